@@ -11,6 +11,7 @@
 
 #include "AudioManager.h"
 #include "kiss_fft/tools/kiss_fftr.h"
+#include "Parallel.h"
 #include "../xSchedule/md5.h"
 #include "osxMacUtils.h"
 
@@ -1157,6 +1158,7 @@ AudioManager::AudioManager(const std::string& audio_file, int step, int block)
 	_data[1] = nullptr; // right channel data
 	_intervalMS = -1; // no length
 	_frameDataPrepared = false; // frame data is used by effects to react to the sone
+	_frameDataFrames = 0;
 	_media_state = MEDIAPLAYINGSTATE::STOPPED;
 	_pcmdata = nullptr;
 	_polyphonicTranscriptionDone = false;
@@ -1205,58 +1207,61 @@ AudioManager::AudioManager(const std::string& audio_file, int step, int block)
     AddAudioDeviceChangeListener(this);
 }
 
-std::list<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const
+// the FFT buckets that make up each of the 127 MIDI notes for a window of n samples
+struct SpectrumNoteBuckets
 {
-	std::list<float> res;
-	int outcount = n / 2 + 1;
-	kiss_fftr_cfg cfg;
-	kiss_fft_cpx* out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx) * (outcount));
-	if (out != nullptr)
-	{
-		if ((cfg = kiss_fftr_alloc(n, 0/*is_inverse_fft*/, nullptr, nullptr)) != nullptr)
-		{
-			kiss_fftr(cfg, in, out);
-			free(cfg);
-		}
+    int start[127];
+    int end[127];
+};
 
-		for (int j = 0; j < 127; j++)
-		{
-            // choose the right bucket for this MIDI note
-            double freq = 440.0 * exp2f(((double)j - 69.0) / 12.0);
-            int start = freq * (double)n / (double)_rate;
-            double freqnext = 440.0 * exp2f(((double)j + 1.0 - 69.0) / 12.0);
-            int end = freqnext * (double)n / (double)_rate;
+static void CalculateSpectrumNoteBuckets(int n, long rate, SpectrumNoteBuckets& buckets)
+{
+    for (int j = 0; j < 127; j++)
+    {
+        // choose the right bucket for this MIDI note
+        double freq = 440.0 * exp2f(((double)j - 69.0) / 12.0);
+        buckets.start[j] = freq * (double)n / (double)rate;
+        double freqnext = 440.0 * exp2f(((double)j + 1.0 - 69.0) / 12.0);
+        buckets.end[j] = freqnext * (double)n / (double)rate;
+    }
+}
 
-            float val = 0.0;
+// writes the level of each MIDI note into res and returns the largest of them
+static float CalculateSpectrumAnalysis(const float* in, int n, const SpectrumNoteBuckets& buckets, kiss_fftr_cfg cfg, kiss_fft_cpx* out, float* res)
+{
+    int outcount = n / 2 + 1;
+    float max = 0;
 
-            // got through all buckets up to the next note and take the maximums
-            if (end < outcount-1)
+    kiss_fftr(cfg, in, out);
+
+    for (int j = 0; j < 127; j++)
+    {
+        float val = 0.0;
+
+        // got through all buckets up to the next note and take the maximums
+        if (buckets.end[j] < outcount - 1)
+        {
+            for (int k = buckets.start[j]; k <= buckets.end[j]; k++)
             {
-                for (int k = start; k <= end; k++)
-                {
-                    kiss_fft_cpx* cur = out + k;
-                    val = std::max(val, sqrtf(cur->r * cur->r + cur->i * cur->i));
-                    //float valscaled = valnew * scaling;
-                }
+                kiss_fft_cpx* cur = out + k;
+                val = std::max(val, sqrtf(cur->r * cur->r + cur->i * cur->i));
             }
+        }
 
-			float db = log10(val);
-			if (db < 0.0)
-			{
-				db = 0.0;
-			}
-
-			res.push_back(db);
-			if (db > max)
-			{
-				max = db;
-			}
-		}
+        float db = log10(val);
+        if (db < 0.0)
+        {
+            db = 0.0;
+        }
 
-		free(out);
-	}
+        res[j] = db;
+        if (db > max)
+        {
+            max = db;
+        }
+    }
 
-	return res;
+    return max;
 }
 
 void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback fn)
@@ -1356,6 +1361,7 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
             logger_pianodata.debug("About to extract Polyphonic Transcription result.");
             Vamp::Plugin::FeatureSet features = pt->getRemainingFeatures();
             logger_pianodata.debug("Polyphonic Transcription result retrieved.");
+            std::vector<std::vector<float>> notes(frames);
             logger_pianodata.debug("Start,Duration,CalcStart,CalcEnd,midinote");
             for (size_t j = 0; j < features[0].size(); j++)
             {
@@ -1378,26 +1384,36 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
                 if (currentstart - sframe * _intervalMS > _intervalMS / 2) {
                     sframe++;
                 }
-                int eframe = currentend / _intervalMS;
+                int eframe = std::min(currentend / _intervalMS, (long)notes.size() - 1);
                 while (sframe <= eframe) {
-                    _frameData[sframe][4].push_back(features[0][j].values[0]);
+                    notes[sframe].push_back(features[0][j].values[0]);
                     sframe++;
                 }
             }
 
+            FrameDataArray& notedata = _frameData[FRAMEDATA_NOTES];
+            notedata.Clear();
+            notedata.offsets.reserve(notes.size() + 1);
+            for (const auto& it : notes)
+            {
+                notedata.offsets.push_back(notedata.values.size());
+                notedata.values.insert(notedata.values.end(), it.begin(), it.end());
+            }
+            notedata.offsets.push_back(notedata.values.size());
+
             fn(dlg, 100);
 
             if (logger_pianodata.isDebugEnabled())
             {
                 logger_pianodata.debug("Piano data calculated:");
                 logger_pianodata.debug("Time MS, Keys");
-                for (size_t i = 0; i < _frameData.size(); i++)
+                for (int i = 0; i < _frameDataFrames; i++)
                 {
                     long ms = i * _intervalMS;
                     std::string keys = "";
-                    for (auto it2 = _frameData[i][4].begin(); it2 != _frameData[i][4].end(); ++it2)
+                    for (auto it2 : _frameData[FRAMEDATA_NOTES].Get(i))
                     {
-                        keys += " " + std::string(wxString::Format("%f", *it2).c_str());
+                        keys += " " + std::string(wxString::Format("%f", it2).c_str());
                     }
                     logger_pianodata.debug("%ld,%s", ms, (const char *)keys.c_str());
                 }
@@ -1472,127 +1488,134 @@ void AudioManager::DoPrepareFrameData()
 	_bigmin = 1;
 	_bigspectogrammax = -1;
 
-	size_t step = 2048;
-	float *pdata[2];
-
-	int pos = 0;
-	std::list<float> spectrogram;
+	int step = 2048;
 
-	// process each frome of the song
+	// The spectrogram is calculated over fixed windows of step samples which do not line up with the frames. A frame
+	// takes the maximum of the windows that start before it ends and that no earlier frame used. If there are none
+	// it keeps the previous frame's spectrogram. Windows starting past the end of the track have no data.
+	int windows = totalsamples > step ? (totalsamples - 1) / step : 0;
+	std::vector<int> windowStart(frames);
+	std::vector<int> windowEnd(frames);
+	int used = 0;
 	for (int i = 0; i < frames; i++)
 	{
-		std::vector<std::list<float>> aFrameData;
-		aFrameData.resize(5); // preallocate the spots we will need
-
-		// accumulators
-		float max = -100.0;
-		float min = 100.0;
-		float spread = -100;
-
-		// clear the data if we are about to get new data ... dont clear it if we wont
-		// this happens because the spectrogram function has a fixed window based on the parameters we set and it
-		// does not match our time slices exactly so we have to select which one to use
-		if (pos < i * samplesperframe + samplesperframe  && pos + step < totalsamples)
+		int end = std::min((int)(((int64_t)(i + 1) * samplesperframe + step - 1) / step), windows);
+		if (end > used || i == 0)
 		{
-			spectrogram.clear();
+			windowStart[i] = used;
+			windowEnd[i] = end;
+			used = end;
 		}
-
-		// only get the data if we are not ahead of the music
-		while (pos < i * samplesperframe + samplesperframe && pos + step < totalsamples)
+		else
 		{
-			std::list<float> subspectrogram;
-			pdata[0] = GetLeftDataPtr(pos);
-			pdata[1] = GetRightDataPtr(pos);
-			float max2 = 0;
-
-			if (pdata[0] == nullptr)
-			{
-				subspectrogram.clear();
-			}
-			else
+			windowStart[i] = windowStart[i - 1];
+			windowEnd[i] = windowEnd[i - 1];
+		}
+	}
+	int validwindows = std::min(windows, (int)(_trackSize / step) + 1);
+
+	std::vector<float> spectra((size_t)windows * 127);
+	std::vector<float> spectramax(windows, 0.0f);
+	SpectrumNoteBuckets buckets;
+	CalculateSpectrumNoteBuckets(step, _rate, buckets);
+	parallel_for_range(0, validwindows, [this, step, &buckets, &spectra, &spectramax](int start, int end) {
+		kiss_fftr_cfg cfg = kiss_fftr_alloc(step, 0/*is_inverse_fft*/, nullptr, nullptr);
+		kiss_fft_cpx* out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx) * (step / 2 + 1));
+		if (cfg != nullptr && out != nullptr)
+		{
+			for (int k = start; k < end; k++)
 			{
-				subspectrogram = CalculateSpectrumAnalysis(pdata[0], step, max2, i);
+				spectramax[k] = CalculateSpectrumAnalysis(_data[0] + (size_t)k * step, step, buckets, cfg, out, &spectra[(size_t)k * 127]);
 			}
+		}
+		free(out);
+		free(cfg);
+	}, 8);
+	for (int k = 0; k < windows; k++)
+	{
+		_bigspectogrammax = std::max(_bigspectogrammax, spectramax[k]);
+	}
 
-			// and keep track of the larges value so we can normalise it
-			if (max2 > _bigspectogrammax)
-			{
-				_bigspectogrammax = max2;
-			}
-			pos += step;
+	FrameDataArray& high = _frameData[FRAMEDATA_HIGH];
+	FrameDataArray& low = _frameData[FRAMEDATA_LOW];
+	FrameDataArray& spread = _frameData[FRAMEDATA_SPREAD];
+	FrameDataArray& vu = _frameData[FRAMEDATA_VU];
+	for (auto& it : _frameData)
+	{
+		it.Clear();
+	}
+	high.width = low.width = spread.width = 1;
+	high.values.resize(frames);
+	low.values.resize(frames);
+	spread.values.resize(frames);
+	vu.width = windows > 0 ? 127 : 0;
+	vu.offsets.resize(frames + 1);
+	for (int i = 0; i < frames; i++)
+	{
+		vu.offsets[i + 1] = vu.offsets[i] + (windowStart[i] < std::min(windowEnd[i], validwindows) ? vu.width : 0);
+	}
+	vu.values.resize(vu.offsets[frames]);
 
-			// either take the newly calculated values or if we are merging two results take the maximum of each value
-			if (spectrogram.size() == 0)
-			{
-				spectrogram = subspectrogram;
-			}
-			else
+	// process each frame of the song
+	parallel_for_range(0, frames, [this, samplesperframe, validwindows, &windowStart, &windowEnd, &spectra, &high, &low, &spread, &vu](int start, int end) {
+		for (int i = start; i < end; i++)
+		{
+			// accumulators
+			float max = -100.0;
+			float min = 100.0;
+			float framespread = -100;
+
+			// now do the raw data analysis for the frame ... the data is all loaded so it can be read directly
+			for (int j = 0; j < samplesperframe; j++)
 			{
-				if (subspectrogram.size() > 0)
+				long offset = (long)i * samplesperframe + j;
+				float data = offset > _trackSize ? 0 : _data[0][offset];
+
+				// Max data
+				if (data > max)
 				{
-					std::list<float>::iterator sub = subspectrogram.begin();
-					for (std::list<float>::iterator fr = spectrogram.begin(); fr != spectrogram.end(); ++fr)
-					{
-						if (*sub > *fr)
-						{
-							*fr = *sub;
-						}
-						++sub;
-					}
+					max = data;
 				}
-			}
-		}
 
-		// now do the raw data analysis for the frame
-		for (int j = 0; j < samplesperframe; j++)
-		{
-			float data = GetLeftData(i * samplesperframe + j);
-
-			// Max data
-			if (data > max)
-			{
-				max = data;
-			}
+				// Min data
+				if (data < min)
+				{
+					min = data;
+				}
 
-			// Min data
-			if (data < min)
-			{
-				min = data;
+				// Spread data
+				if (max - min > framespread)
+				{
+					framespread = max - min;
+				}
 			}
+			high.values[i] = max;
+			low.values[i] = min;
+			spread.values[i] = framespread;
 
-			// Spread data
-			if (max - min > spread)
+			// and the maximum of each note over the frame's windows
+			if (vu.offsets[i] != vu.offsets[i + 1])
 			{
-				spread = max - min;
+				float* res = &vu.values[vu.offsets[i]];
+				const float* window = &spectra[(size_t)windowStart[i] * 127];
+				std::copy(window, window + 127, res);
+				for (int k = windowStart[i] + 1; k < std::min(windowEnd[i], validwindows); k++)
+				{
+					window = &spectra[(size_t)k * 127];
+					for (int j = 0; j < 127; j++)
+					{
+						res[j] = std::max(res[j], window[j]);
+					}
+				}
 			}
 		}
+	}, 16);
 
-		if (max > _bigmax)
-		{
-			_bigmax = max;
-		}
-		if (min < _bigmin)
-		{
-			_bigmin = min;
-		}
-		if (spread > _bigspread)
-		{
-			_bigspread = spread;
-		}
-
-		// Now save the results for the frame
-		std::list<float> maxlist;
-		maxlist.push_back(max);
-		std::list<float> minlist;
-		minlist.push_back(min);
-		std::list<float> spreadlist;
-		spreadlist.push_back(spread);
-		aFrameData[0] = maxlist;
-		aFrameData[1] = minlist;
-		aFrameData[2] = spreadlist;
-		aFrameData[3] = spectrogram;
-
-		_frameData.push_back(aFrameData);
+	for (int i = 0; i < frames; i++)
+	{
+		_bigmax = std::max(_bigmax, high.values[i]);
+		_bigmin = std::min(_bigmin, low.values[i]);
+		_bigspread = std::max(_bigspread, spread.values[i]);
 	}
 
 	// normalise data ... basically scale the data so the highest value is the scale value.
@@ -1601,26 +1624,23 @@ void AudioManager::DoPrepareFrameData()
 	float bigminscale = 1 / (_bigmin * scale);
 	float bigspreadscale = 1 / (_bigspread * scale);
 	float bigspectrogramscale = 1 / (_bigspectogrammax * scale);
-	for (std::vector<std::vector<std::list<float>>>::iterator itframe = _frameData.begin(); itframe != _frameData.end(); ++itframe)
+	for (auto& it : high.values)
 	{
-		std::list<float>* fl = &(*itframe)[0];
-		std::list<float>::iterator f = fl->begin();
-		*f = (*f * bigmaxscale);
-
-		fl = &(*itframe)[1];
-		f = fl->begin();
-		*f = (*f * bigminscale);
-
-		fl = &(*itframe)[2];
-		f = fl->begin();
-		*f = (*f * bigspreadscale);
-
-		fl = &(*itframe)[3];
-		for (std::list<float>::iterator ff = fl->begin(); ff != fl->end(); ++ff)
-		{
-			*ff = *ff * bigspectrogramscale;
-		}
+		it *= bigmaxscale;
+	}
+	for (auto& it : low.values)
+	{
+		it *= bigminscale;
+	}
+	for (auto& it : spread.values)
+	{
+		it *= bigspreadscale;
+	}
+	for (auto& it : vu.values)
+	{
+		it *= bigspectrogramscale;
 	}
+	_frameDataFrames = frames;
 
 	// flag the fact that the data is all ready
 	_frameDataPrepared = true;
@@ -1671,17 +1691,27 @@ void ProgressFunction(wxProgressDialog* pd, int p)
     }
 }
 
+FrameDataView AudioManager::FrameDataArray::Get(int frame) const
+{
+    if (offsets.empty())
+    {
+        if (frame < 0 || (size_t)frame * width >= values.size()) return FrameDataView();
+        return FrameDataView(&values[frame * width], &values[frame * width] + width);
+    }
+    if (frame < 0 || (size_t)frame + 1 >= offsets.size()) return FrameDataView();
+    return FrameDataView(values.data() + offsets[frame], values.data() + offsets[frame + 1]);
+}
+
 // Get the pre-prepared data for this frame
-std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
+FrameDataView AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
 {
     log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    std::list<float>* rc = nullptr;
 
     // Grab the lock so we can safely access the frame data
     std::shared_lock<std::shared_timed_mutex> lock(_mutex);
 
     // make sure we have audio data
-    if (_data[0] == nullptr) return rc;
+    if (_data[0] == nullptr) return FrameDataView();
 
     // if the frame data has not been prepared
     if (!_frameDataPrepared)
@@ -1706,50 +1736,11 @@ std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::
         DoPolyphonicTranscription(&dlg, ProgressFunction);
     }
 
-    // now we can grab the data we need
-    try
-    {
-        if (frame < (int)_frameData.size())
-        {
-            std::vector<std::list<float>>* framedata = &_frameData[frame];
-
-            if (framedata == nullptr)
-            {
-                logger_base.crit("AudioManager::GetFrameData framedata is nullptr ... this is going to crash.");
-            }
-
-            switch (fdt)
-            {
-            case FRAMEDATA_HIGH:
-                rc = &framedata->at(0);
-                break;
-            case FRAMEDATA_LOW:
-                rc = &framedata->at(1);
-                break;
-            case FRAMEDATA_SPREAD:
-                rc = &framedata->at(2);
-                break;
-            case FRAMEDATA_VU:
-                rc = &framedata->at(3);
-                break;
-            case FRAMEDATA_ISTIMINGMARK:
-                // we dont need to do anything here
-                break;
-            case FRAMEDATA_NOTES:
-                rc = &framedata->at(4);
-                break;
-            }
-        }
-    }
-    catch (...)
-    {
-        rc = nullptr;
-    }
-
-    return rc;
+    // now we can grab the data we need ... timing marks have none
+    return _frameData[fdt].Get(frame);
 }
 
-std::list<float>* AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
+FrameDataView AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
 {
     int frame = ms / _intervalMS;
     return GetFrameData(frame, fdt, timing);
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <shared_mutex>
 
 extern "C"
@@ -60,6 +61,24 @@ typedef enum FRAMEDATATYPE {
 	FRAMEDATA_NOTES
 } FRAMEDATATYPE;
 
+// One frame's values for a FRAMEDATATYPE. It points into the AudioManager's frame data so it is only
+// good while the AudioManager lives and until the frame data is prepared again.
+class FrameDataView
+{
+    const float* _begin;
+    const float* _end;
+
+public:
+    FrameDataView() : _begin(nullptr), _end(nullptr) {}
+    FrameDataView(const float* begin, const float* end) : _begin(begin), _end(end) {}
+    const float* begin() const { return _begin; }
+    const float* end() const { return _end; }
+    size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+    float front() const { return *_begin; }
+    float operator[](size_t i) const { return _begin[i]; }
+};
+
 typedef enum MEDIAPLAYINGSTATE {
 	PLAYING,
 	PAUSED,
@@ -164,7 +183,19 @@ class AudioManager
     Job* _jobAudioLoad;
     std::shared_timed_mutex _mutexAudioLoad;
     long _loadedData;
-    std::vector<std::vector<std::list<float>>> _frameData;
+    // Values for one FRAMEDATATYPE for every frame in a single array. Each frame has width values
+    // unless offsets is filled in, then frame i's values run from offsets[i] up to offsets[i + 1].
+    struct FrameDataArray
+    {
+        std::vector<float> values;
+        std::vector<size_t> offsets;
+        size_t width = 0;
+
+        FrameDataView Get(int frame) const;
+        void Clear() { values.clear(); offsets.clear(); width = 0; }
+    };
+    FrameDataArray _frameData[FRAMEDATA_NOTES + 1];
+    int _frameDataFrames;
 	std::string _audio_file;
 	xLightsVamp _vamp;
 	long _rate;
@@ -204,7 +235,6 @@ class AudioManager
     static int decodebitrateindex(int bitrateindex, int version, int layertype);
 	int decodesamplerateindex(int samplerateindex, int version) const;
     static int decodesideinfosize(int version, int mono);
-	std::list<float> CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const;
     void LoadAudioData(bool separateThread, AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* audioStream, AVFrame* frame);
     void SetLoadedData(long pos);
 
@@ -250,8 +280,8 @@ public:
 	void SetStepBlock(int step, int block);
 	void SetFrameInterval(int intervalMS);
 	int GetFrameInterval() const { return _intervalMS; }
-	std::list<float>* GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
-	std::list<float>* GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
+	FrameDataView GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
+	FrameDataView GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
 	void DoPrepareFrameData();
 	void DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback progresscallback);
 	bool IsPolyphonicTranscriptionDone() const { return _polyphonicTranscriptionDone; };
@@ -186,6 +186,116 @@ HSVValue& HSVValue::operator=(const xlColor& c) {
 }
 
 
+namespace
+{
+    // the last result for each colour in a small direct mapped table, spans of
+    // pixels rarely have more than a handful of distinct colours in them
+    template <class T>
+    class ColorMemo
+    {
+        static const int SIZE = 256;
+        uint32_t keys[SIZE];
+        T values[SIZE];
+
+    public:
+        ColorMemo()
+        {
+            // colours only use the low 24 bits so this never matches
+            std::fill(keys, keys + SIZE, 0xFFFFFFFF);
+        }
+
+        template <class F>
+        const T &Get(const xlColor &c, F convert)
+        {
+            uint32_t key = c.red | (c.green << 8) | (c.blue << 16);
+            int slot = (key * 2654435761u) >> 24;
+            if (keys[slot] != key) {
+                keys[slot] = key;
+                values[slot] = convert(c);
+            }
+            return values[slot];
+        }
+    };
+}
+
+void ColorsToHSV(const xlColor *colors, HSVValue *hsv, size_t count) {
+    ColorMemo<HSVValue> memo;
+    for (size_t i = 0; i < count; i++) {
+        hsv[i] = memo.Get(colors[i], [](const xlColor &c) { return c.asHSV(); });
+    }
+}
+
+void ColorsFromHSV(const HSVValue *hsv, xlColor *colors, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t alpha = colors[i].alpha;
+        ::fromHSV(colors[i], hsv[i]);
+        colors[i].alpha = alpha;
+    }
+}
+
+void AdjustHSV(xlColor *colors, size_t count, float hueAdjust, float saturationAdjust, float valueAdjust) {
+    ColorMemo<xlColor> memo;
+    auto adjust = [hueAdjust, saturationAdjust, valueAdjust](const xlColor &c) {
+        HSVValue hsv = c.asHSV();
+        if (hueAdjust != 0) {
+            hsv.hue += hueAdjust;
+            if (hsv.hue < 0) {
+                hsv.hue += 1.0;
+            } else if (hsv.hue > 1) {
+                hsv.hue -= 1.0;
+            }
+        }
+        if (saturationAdjust != 0) {
+            hsv.saturation += saturationAdjust;
+            if (hsv.saturation < 0) {
+                hsv.saturation = 0.0;
+            } else if (hsv.saturation > 1) {
+                hsv.saturation = 1.0;
+            }
+        }
+        if (valueAdjust != 0) {
+            hsv.value += valueAdjust;
+            if (hsv.value < 0) {
+                hsv.value = 0.0;
+            } else if (hsv.value > 1) {
+                hsv.value = 1.0;
+            }
+        }
+        return xlColor(hsv);
+    };
+    for (size_t i = 0; i < count; i++) {
+        const xlColor &c = memo.Get(colors[i], adjust);
+        colors[i].red = c.red;
+        colors[i].green = c.green;
+        colors[i].blue = c.blue;
+    }
+}
+
+void AdjustBrightnessContrast(xlColor *colors, size_t count, int brightness, int contrast) {
+    ColorMemo<xlColor> memo;
+    auto adjust = [brightness, contrast](const xlColor &c) {
+        HSVValue hsv = c.asHSV();
+        hsv.value = hsv.value * ((double)brightness / 100.0);
+
+        // reduce brightness when below 0.5 in the V value or increase if > 0.5
+        if (hsv.value < 0.5) {
+            hsv.value = hsv.value - (hsv.value * ((double)contrast / 100.0));
+        } else {
+            hsv.value = hsv.value + (hsv.value * ((double)contrast / 100.0));
+        }
+
+        if (hsv.value < 0.0) hsv.value = 0.0;
+        if (hsv.value > 1.0) hsv.value = 1.0;
+        return xlColor(hsv);
+    };
+    for (size_t i = 0; i < count; i++) {
+        const xlColor &c = memo.Get(colors[i], adjust);
+        colors[i].red = c.red;
+        colors[i].green = c.green;
+        colors[i].blue = c.blue;
+    }
+}
+
 void xlColor::SetFromString(const wxString &str) {
     SetFromString(str.ToStdString());
 }
@@ -245,6 +245,14 @@ typedef std::vector<xlColor> xlColorVector;
 typedef std::vector<ColorCurve> xlColorCurveVector;
 typedef std::vector<HSVValue> hsvVector;
 
+// Span versions of the HSV conversions and the layer adjustments built on them. They give exactly
+// the same 8 bit result as converting the pixels one at a time but each distinct colour in the
+// span is only converted once, alpha is left as it was.
+void ColorsToHSV(const xlColor *colors, HSVValue *hsv, size_t count);
+void ColorsFromHSV(const HSVValue *hsv, xlColor *colors, size_t count);
+void AdjustHSV(xlColor *colors, size_t count, float hueAdjust, float saturationAdjust, float valueAdjust);
+void AdjustBrightnessContrast(xlColor *colors, size_t count, int brightness, int contrast);
+
 enum ColorDisplayMode
 {
     MODE_HUE,
@@ -28,10 +28,41 @@
 
 const std::string Job::EMPTY_STRING = "";
 
+#define MAX_JOB_POOL_THREADS 250
+
+// Per worker deque.  The owning worker pushes and pops at the back (LIFO so
+// nested work stays hot in cache), idle workers steal from the front.
+class JobPoolQueue
+{
+public:
+    std::mutex lock;
+    std::deque<Job*> jobs;
+
+    Job *PopBack() {
+        std::unique_lock<std::mutex> l(lock);
+        if (jobs.empty()) {
+            return nullptr;
+        }
+        Job *j = jobs.back();
+        jobs.pop_back();
+        return j;
+    }
+    Job *PopFront() {
+        std::unique_lock<std::mutex> l(lock, std::try_to_lock);
+        if (!l.owns_lock() || jobs.empty()) {
+            return nullptr;
+        }
+        Job *j = jobs.front();
+        jobs.pop_front();
+        return j;
+    }
+};
+
 
 class JobPoolWorker
 {
     JobPool *pool;
+    int queueIdx;
     volatile bool stopped;
     std::atomic<Job  *> currentJob;
     enum {
@@ -46,7 +77,7 @@ class JobPoolWorker
     std::thread *thread;
     std::thread::id tid;
 public:
-    JobPoolWorker(JobPool *p);
+    JobPoolWorker(JobPool *p, int queueIdx);
     virtual ~JobPoolWorker();
 
     void Stop();
@@ -56,17 +87,24 @@ public:
     std::string GetStatus();
     
     std::string GetThreadName() const;
+    JobPool *GetPool() const { return pool; }
+    int GetQueueIndex() const { return queueIdx; }
 };
 
+// the worker running on the current thread, if any
+static thread_local JobPoolWorker *currentWorker = nullptr;
+
 static void startFunc(JobPoolWorker *jpw) {
 #ifdef LINUX
     XInitThreads();
 #endif
+    currentWorker = jpw;
     jpw->Entry();
+    currentWorker = nullptr;
     delete jpw;
 }
-JobPoolWorker::JobPoolWorker(JobPool *p)
-: pool(p), stopped(false), currentJob(nullptr), status(STARTING), thread(nullptr)
+JobPoolWorker::JobPoolWorker(JobPool *p, int qi)
+: pool(p), queueIdx(qi), stopped(false), currentJob(nullptr), status(STARTING), thread(nullptr)
 {
     static log4cpp::Category &logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
     logger_jobpool.debug("JobPoolWorker created  %X\n", this);
@@ -201,7 +239,7 @@ void JobPoolWorker::Entry()
         while ( !stopped ) {
             status = IDLE;
 
-            Job *job = pool->GetNextJob();
+            Job *job = pool->GetNextJob(queueIdx);
             if (job != nullptr) {
                 logger_jobpool.debug("JobPoolWorker::Entry processing job.   %X", this);
                 status = RUNNING_JOB;
@@ -223,6 +261,7 @@ void JobPoolWorker::Entry()
         logger_jobpool.warn("JobPoolWorker::Entry exiting due to __forced_unwind.  %X", this);
         pool->numThreads--;
         status = STOPPED;
+        pool->ReleaseWorkerQueue(queueIdx);
         pool->RemoveWorker(this);
         throw;
 #endif // HAVE_ABI_FORCEDUNWIND
@@ -230,6 +269,7 @@ void JobPoolWorker::Entry()
         logger_jobpool.warn("JobPoolWorker::Entry exiting due to unknown exception.  %X", this);
         --pool->numThreads;
         status = STOPPED;
+        pool->ReleaseWorkerQueue(queueIdx);
         pool->RemoveWorker(this);
         wxTheApp->OnUnhandledException();
         return;
@@ -237,6 +277,7 @@ void JobPoolWorker::Entry()
     logger_jobpool.debug("JobPoolWorker::Entry exiting.  %X", this);
     --pool->numThreads;
     status = STOPPED;
+    pool->ReleaseWorkerQueue(queueIdx);
     pool->RemoveWorker(this);
     logger_jobpool.debug("JobPoolWorker::Entry removed.  %X", this);
     RemoveThreadName();
@@ -272,20 +313,29 @@ void JobPoolWorker::ProcessJob(Job *job)
 	}
 }
 
-JobPool::JobPool(const std::string &n) : threadLock(false), queueLock(), signal(), queue(), numThreads(0), maxNumThreads(8),  idleThreads(0), inFlight(0), threadNameBase(n)
+JobPool::JobPool(const std::string &n) : threadLock(false), queueLock(), signal(), injectLock(), queue(),
+    numWorkerQueues(0), numThreads(0), maxNumThreads(8), idleThreads(0), inFlight(0), queuedJobs(0),
+    stealCount(0), idleCount(0), threadNameBase(n)
 {
+    workerQueues.resize(MAX_JOB_POOL_THREADS, nullptr);
 }
 
 JobPool::~JobPool()
 {
-    if ( !queue.empty() ) {
-        std::deque<Job*>::iterator iter = queue.begin();
-        for (; iter != queue.end(); ++iter) {
-            delete (*iter);
+    Stop();
+    for (auto it : queue) {
+        delete it;
+    }
+    queue.clear();
+    for (auto q : workerQueues) {
+        if (q != nullptr) {
+            for (auto it : q->jobs) {
+                delete it;
+            }
+            delete q;
         }
-        queue.clear();
     }
-    Stop();
+    workerQueues.clear();
 }
 
 void JobPool::LockThreads() {
@@ -306,48 +356,142 @@ void JobPool::RemoveWorker(JobPoolWorker *w) {
     UnlockThreads();
 }
 
-Job *JobPool::GetNextJob() {
+bool JobPool::IsWorkerThread() const {
+    return currentWorker != nullptr && currentWorker->GetPool() == this;
+}
+
+// must be called with the thread lock held
+int JobPool::AcquireWorkerQueue() {
+    int idx;
+    if (!freeWorkerQueues.empty()) {
+        idx = freeWorkerQueues.back();
+        freeWorkerQueues.pop_back();
+    } else {
+        idx = numWorkerQueues;
+        if (idx >= MAX_JOB_POOL_THREADS) {
+            return -1;
+        }
+        workerQueues[idx] = new JobPoolQueue();
+        numWorkerQueues++;
+    }
+    return idx;
+}
+
+void JobPool::ReleaseWorkerQueue(int idx) {
+    JobPoolQueue *q = workerQueues[idx];
+    // anything left on the exiting worker's deque goes back to the global queue
+    {
+        std::unique_lock<std::mutex> ql(q->lock);
+        if (!q->jobs.empty()) {
+            std::unique_lock<std::mutex> il(injectLock);
+            for (auto j : q->jobs) {
+                queue.push_back(j);
+            }
+            q->jobs.clear();
+        }
+    }
+    LockThreads();
+    freeWorkerQueues.push_back(idx);
+    UnlockThreads();
+    WakeIdleThread();
+}
+
+Job *JobPool::TryGetJob(int queueIdx) {
+    if (queuedJobs == 0) {
+        return nullptr;
+    }
+    Job *req = workerQueues[queueIdx]->PopBack();
+    if (req == nullptr) {
+        std::unique_lock<std::mutex> il(injectLock);
+        if (!queue.empty()) {
+            req = queue.front();
+            queue.pop_front();
+        }
+    }
+    if (req == nullptr) {
+        int count = numWorkerQueues;
+        for (int x = 1; x < count && req == nullptr; x++) {
+            int idx = (queueIdx + x) % count;
+            req = workerQueues[idx]->PopFront();
+        }
+        if (req != nullptr) {
+            stealCount++;
+        }
+    }
+    if (req != nullptr) {
+        queuedJobs--;
+    }
+    return req;
+}
+
+Job *JobPool::GetNextJob(int queueIdx) {
+    Job *req = TryGetJob(queueIdx);
+    if (req != nullptr) {
+        return req;
+    }
     std::unique_lock<std::mutex> mutLock(queueLock);
-    Job *req = nullptr;
-    if (queue.empty()) {
-        idleThreads++;
+    idleThreads++;
+    // PushJob increments queuedJobs before checking idleThreads so either we
+    // see the new job here or the pusher sees us idle and notifies
+    if (queuedJobs == 0) {
+        idleCount++;
         long timeout = 100;
         if (idleThreads <= 12) {
             timeout = 30000;
         }
         signal.wait_for(mutLock, std::chrono::milliseconds(timeout));
-        idleThreads--;
     }
-    if ( !queue.empty() ) {
-        req = queue.front();
-        queue.pop_front();
+    idleThreads--;
+    mutLock.unlock();
+    return TryGetJob(queueIdx);
+}
+
+void JobPool::WakeIdleThread() {
+    if (idleThreads > 0) {
+        std::unique_lock<std::mutex> mutLock(queueLock);
+        signal.notify_one();
     }
-    return req;
 }
 
 void JobPool::PushJob(Job *job)
 {
-	std::unique_lock<std::mutex> locker(queueLock);
-    queue.push_back(job);
     inFlight++;
-    
+    JobPoolWorker *worker = currentWorker;
+    if (worker != nullptr && worker->GetPool() == this) {
+        // jobs spawned by one of our own workers stay local, idle
+        // workers will steal them if the owner doesn't get to them
+        JobPoolQueue *q = workerQueues[worker->GetQueueIndex()];
+        std::unique_lock<std::mutex> locker(q->lock);
+        q->jobs.push_back(job);
+    } else {
+        std::unique_lock<std::mutex> locker(injectLock);
+        queue.push_back(job);
+    }
+    queuedJobs++;
+
     int count = inFlight;
     count -= idleThreads;
     count -= numThreads;
     count = std::min(count, maxNumThreads - numThreads);
     if (count > 0) {
         LockThreads();
+        // workers can push concurrently so recheck now that we hold the lock
+        count = std::min(count, maxNumThreads - numThreads);
         if (numThreads == 0 && count < 4 && 4 < maxNumThreads) {
             //when we create first thread, assume we'll need extras real soon
             count = 4;
         }
         for (int i = 0; i < count; i++) {
-            threads.push_back(new JobPoolWorker(this));
+            int idx = AcquireWorkerQueue();
+            if (idx == -1) {
+                break;
+            }
+            threads.push_back(new JobPoolWorker(this, idx));
             numThreads++;
         }
         UnlockThreads();
     }
-    signal.notify_all();
+    WakeIdleThread();
 }
 
 void JobPool::Start(size_t poolSize)
@@ -400,6 +544,12 @@ std::string JobPool::GetThreadStatus() {
         ret << "\n";
     }
     UnlockThreads();
+    ret << "Queued: " << (int)queuedJobs
+        << "    In Flight: " << (int)inFlight
+        << "    Idle: " << (int)idleThreads
+        << "    Steals: " << (unsigned long long)stealCount
+        << "    Idle Waits: " << (unsigned long long)idleCount
+        << "\n";
     return ret.str();
 }
 
@@ -30,17 +30,32 @@ public:
 
 
 class JobPoolWorker;
+class JobPoolQueue;
 class JobPool
 {
     std::atomic_bool threadLock;
     std::mutex queueLock;
     std::condition_variable signal;
     std::vector<JobPoolWorker*> threads;
+
+    // global injection queue, used for jobs pushed from threads that are not
+    // workers of this pool (main thread, other pools)
+    std::mutex injectLock;
     std::deque<Job*> queue;
+
+    // per worker deques.  Slots live as long as the pool so other workers can
+    // steal from them without holding the thread lock.
+    std::vector<JobPoolQueue*> workerQueues;
+    std::vector<int> freeWorkerQueues;
+    std::atomic_int numWorkerQueues;
+
     std::atomic_int numThreads;
     std::atomic_int maxNumThreads;
     std::atomic_int idleThreads;
     std::atomic_int inFlight;
+    std::atomic_int queuedJobs;
+    std::atomic_ullong stealCount;
+    std::atomic_ullong idleCount;
     std::string threadNameBase;
     
 public:
@@ -55,12 +70,19 @@ public:
     
     virtual std::string GetThreadStatus();
     
+    // returns true if the calling thread is one of this pool's workers
+    bool IsWorkerThread() const;
+    
 private:
     friend class JobPoolWorker;
     void RemoveWorker(JobPoolWorker*);
     void LockThreads();
     void UnlockThreads();
-    Job *GetNextJob();
+    int AcquireWorkerQueue();
+    void ReleaseWorkerQueue(int idx);
+    Job *TryGetJob(int queueIdx);
+    Job *GetNextJob(int queueIdx);
+    void WakeIdleThread();
 };
 
 
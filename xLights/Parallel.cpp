@@ -8,6 +8,7 @@
 
 #include "Parallel.h"
 #include <thread>
+#include <algorithm>
 
 #include "JobPool.h"
 
@@ -34,51 +35,84 @@ int ParallelJobPool::calcSteps(int minStep, int total) {
     return 1;
 }
 
+int ParallelJobPool::calcGrainSize(int calcSteps, int total, int grainSize) {
+    if (grainSize > 0) {
+        return grainSize;
+    }
+    // a few chunks per thread so faster threads can pick up the slack
+    return std::max(1, total / (calcSteps * 4));
+}
+
 ParallelJobPool ParallelJobPool::POOL;
 
 
+class ParallelRangeState {
+public:
+    ParallelRangeState(int mn, int mx, int g, std::function<void(int, int)> &&f)
+        : func(std::move(f)), iteration(mn), max(mx), grain(g), barrier(mx - mn) {}
+
+    std::function<void(int, int)> func;
+    std::atomic_int iteration;
+    const int max;
+    const int grain;
+    ParallelForBarrier barrier;
+
+    void Process() {
+        int start;
+        while ((start = iteration.fetch_add(grain)) < max) {
+            int end = std::min(start + grain, max);
+            try {
+                func(start, end);
+            } catch (...) {
+                //nothing
+            }
+            barrier.Done(end - start);
+        }
+    }
+};
+
 class ParallelJob : public Job {
-    int max;
-    std::function<void(int)>& func;
-    std::atomic_int &doneCount;
-    std::atomic_int &iteration;
+    std::shared_ptr<ParallelRangeState> state;
 public:
-    ParallelJob(int m, std::function<void(int)>& f,
-                std::atomic_int &dc, std::atomic_int &it)
-        : max(m), func(f), iteration(it), doneCount(dc) {}
+    ParallelJob(const std::shared_ptr<ParallelRangeState> &s) : state(s) {}
     virtual ~ParallelJob() {};
     virtual void Process() override {
-        try {
-            int x;
-            while ((x = iteration.fetch_add(1)) < max) {
-                func(x);
-            }
-        } catch (...) {
-            //nothing
-        }
-        doneCount++;
+        state->Process();
     };
     virtual bool DeleteWhenComplete() override { return true; };
     virtual bool SetThreadName() override { return false; }
 };
 
-void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep) {
+void parallel_for_range(int min, int max, std::function<void(int, int)>&& func, int minStep, int grainSize) {
     int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, max - min);
     if (calcSteps == 1) {
-        for (int x = min; x < max; x++) {
-            func(x);
+        if (min < max) {
+            func(min, max);
         }
     } else {
-        std::function<void(int)> f(func);
-        std::atomic_int doneCount(0);
-        std::atomic_int iteration(min);
+        int grain = ParallelJobPool::POOL.calcGrainSize(calcSteps, max - min, grainSize);
+        std::shared_ptr<ParallelRangeState> state = std::make_shared<ParallelRangeState>(min, max, grain, std::move(func));
         for (int x = 0; x < calcSteps-1; x++) {
-            ParallelJobPool::POOL.PushJob(new ParallelJob(max, f, doneCount, iteration));
-        }
-        ParallelJob(max, f, doneCount, iteration).Process();
-        while (doneCount < calcSteps) {
-            std::this_thread::yield();
+            ParallelJobPool::POOL.PushJob(new ParallelJob(state));
         }
+        // the calling thread works through chunks as well and then only
+        // blocks for chunks that other threads have already claimed
+        state->Process();
+        state->barrier.Wait();
     }
 }
 
+void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep, int grainSize) {
+    int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, max - min);
+    if (calcSteps == 1) {
+        for (int x = min; x < max; x++) {
+            func(x);
+        }
+    } else {
+        parallel_for_range(min, max, [&func](int start, int end) {
+            for (int x = start; x < end; x++) {
+                func(x);
+            }
+        }, minStep, grainSize);
+    }
+}
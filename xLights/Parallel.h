@@ -9,7 +9,11 @@
 
 #include <functional>
 #include <list>
+#include <vector>
+#include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <thread>
 
 #include "JobPool.h"
@@ -22,6 +26,37 @@ public:
     static ParallelJobPool POOL;
     
     int calcSteps(int minStep, int size);
+    int calcGrainSize(int calcSteps, int size, int grainSize);
+};
+
+
+/**
+ * Completion tracking shared between the caller of a parallel_for and the
+ * helper jobs it pushes.  The caller blocks on it (instead of spinning) once
+ * it runs out of chunks to process itself.  Helper jobs that start after
+ * all the work has been claimed find nothing to do and exit, so the caller
+ * never waits on a job that is still sitting in the queue.  That is what
+ * makes nested parallel_for calls from inside pool jobs safe.
+ */
+class ParallelForBarrier {
+    std::mutex lock;
+    std::condition_variable signal;
+    std::atomic_int remaining;
+public:
+    ParallelForBarrier(int count) : remaining(count) {}
+    
+    void Done(int count) {
+        if (remaining.fetch_sub(count) == count) {
+            std::unique_lock<std::mutex> l(lock);
+            signal.notify_all();
+        }
+    }
+    void Wait() {
+        if (remaining > 0) {
+            std::unique_lock<std::mutex> l(lock);
+            signal.wait(l, [this] { return remaining <= 0; });
+        }
+    }
 };
 
 
@@ -31,8 +66,19 @@ public:
  *
  * would convert to:
  * parallel_for(start, max, [&] (int x) {} );
+ *
+ * minStep is the minimum number of iterations worth handing to another
+ * thread, grainSize is the number of iterations claimed at a time (0 picks
+ * one based on the number of threads used)
+ */
+void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep = 1, int grainSize = 0);
+
+
+/**
+ * Same as above, but f is called with [begin, end) ranges of at most
+ * grainSize iterations to avoid the per index function call overhead
  */
-void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep = 1);
+void parallel_for_range(int start, int max, std::function<void(int, int)>&& f, int minStep = 1, int grainSize = 0);
 
 
 /**
@@ -47,44 +93,61 @@ void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep
  * parallel_for(list, f);
  */
 template <typename T>
-void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minStep = 1) {
-    class ParallelListJob : public Job {
-        std::atomic_int &doneCount;
-        std::function<void(T&, int)>& func;
-        std::mutex &lock;
-        std::atomic_int &index;
-        typename std::list<T>::iterator &iterator;
-        const int max;
+void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minStep = 1, int grainSize = 0) {
+    class ParallelListState {
     public:
-        ParallelListJob(std::atomic_int &dc,
-                        std::function<void(T&, int)>& f,
-                        typename std::list<T>::iterator &it,
-                        std::mutex &l,
-                        std::atomic_int &idx,
-                        int m)
-            : Job(), doneCount(dc), func(f), iterator(it), lock(l), index(idx), max(m) {}
+        ParallelListState(std::list<T> &l, std::function<void(T&, int)> &f, int m, int g)
+            : func(f), iterator(l.begin()), index(0), max(m), grain(g), barrier(m) {}
+        
+        std::function<void(T&, int)> func;
+        std::mutex lock;
+        typename std::list<T>::iterator iterator;
+        int index;
+        const int max;
+        const int grain;
+        ParallelForBarrier barrier;
+        
         void Process() {
-            try {
-                while (true) {
-                    lock.lock();
-                    int idx = index.fetch_add(1);
-                    if (idx < max) {
-                        T &t = *iterator;
-                        ++iterator;
-                        lock.unlock();
-                        func(t, idx);
-                    } else {
-                        lock.unlock();
-                        doneCount++;
+            std::vector<T*> items;
+            items.reserve(grain);
+            while (true) {
+                int idx;
+                {
+                    std::unique_lock<std::mutex> l(lock);
+                    idx = index;
+                    int end = std::min(idx + grain, max);
+                    if (idx >= end) {
                         return;
                     }
+                    for (int x = idx; x < end; x++) {
+                        items.push_back(&(*iterator));
+                        ++iterator;
+                    }
+                    index = end;
                 }
-            } catch (...) {
-                //nothing
-                doneCount++;
+                for (auto t : items) {
+                    try {
+                        func(*t, idx);
+                    } catch (...) {
+                        //nothing
+                    }
+                    idx++;
+                }
+                barrier.Done((int)items.size());
+                items.clear();
             }
         }
     };
+    class ParallelListJob : public Job {
+        std::shared_ptr<ParallelListState> state;
+    public:
+        ParallelListJob(const std::shared_ptr<ParallelListState> &s) : Job(), state(s) {}
+        virtual void Process() override {
+            state->Process();
+        }
+        virtual bool DeleteWhenComplete() override { return true; }
+        virtual bool SetThreadName() override { return false; }
+    };
     
     int size = list.size();
     int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, size);
@@ -95,18 +158,13 @@ void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minSt
             idx++;
         }
     } else {
-        std::atomic_int doneCount(0);
-        std::mutex lock;
-        std::atomic_int idx(0);
-        typename std::list<T>::iterator it = list.begin();
-        
+        int grain = ParallelJobPool::POOL.calcGrainSize(calcSteps, size, grainSize);
+        std::shared_ptr<ParallelListState> state = std::make_shared<ParallelListState>(list, f, size, grain);
         for (int x = 0; x < calcSteps-1; x++) {
-            ParallelJobPool::POOL.PushJob(new ParallelListJob(doneCount, f, it, lock, idx, size));
-        }
-        ParallelListJob(doneCount, f, it, lock, idx, size).Process();
-        while (doneCount < calcSteps) {
-            std::this_thread::yield();
+            ParallelJobPool::POOL.PushJob(new ParallelListJob(state));
         }
+        state->Process();
+        state->barrier.Wait();
     }
 }
 
@@ -307,7 +307,7 @@ void PixelBufferClass::reset(int nlayers, int timing, bool isNode)
     {
         layers[x] = new LayerInfo(frame);
         layers[x]->buffer.SetFrameTimeInMs(frameTimeInMs);
-        model->InitRenderBufferNodes("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
+        model->InitRenderBufferNodesCached("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
         layers[x]->bufferType = "Default";
         layers[x]->camera = "2D";
         layers[x]->bufferTransform = "None";
@@ -332,6 +332,7 @@ void PixelBufferClass::reset(int nlayers, int timing, bool isNode)
         layers[x]->ModelBufferHt = layers[x]->BufferHt;
         layers[x]->ModelBufferWi = layers[x]->BufferWi;
         layers[x]->buffer.InitBuffer(layers[x]->BufferHt, layers[x]->BufferWi, layers[x]->ModelBufferHt, layers[x]->ModelBufferWi, layers[x]->bufferTransform, isNode);
+        layers[x]->DecodeSettings();
     }
 }
 
@@ -341,7 +342,7 @@ void PixelBufferClass::InitPerModelBuffers(const ModelGroup &model, int layer, i
         Model *m = *it;
         RenderBuffer *buf = new RenderBuffer(frame);
         buf->SetFrameTimeInMs(timing);
-        m->InitRenderBufferNodes("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
+        m->InitRenderBufferNodesCached("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
         buf->InitBuffer(buf->BufferHt, buf->BufferWi, buf->BufferHt, buf->BufferWi, "None");
         layers[layer]->modelBuffers.push_back(std::unique_ptr<RenderBuffer>(buf));
     }
@@ -397,16 +398,16 @@ void PixelBufferClass::Clear(int which)
 
 void PixelBufferClass::GetNodeChannelValues(size_t nodenum, unsigned char *buf)
 {
-    layers[0]->buffer.Nodes[nodenum]->GetForChannels(buf);
+    layers[0]->buffer.nodeTable.GetForChannels(nodenum, buf);
 }
 void PixelBufferClass::SetNodeChannelValues(size_t nodenum, const unsigned char *buf)
 {
-    layers[0]->buffer.Nodes[nodenum]->SetFromChannels(buf);
+    layers[0]->buffer.nodeTable.SetFromChannels(nodenum, buf);
 }
 xlColor PixelBufferClass::GetNodeColor(size_t nodenum) const
 {
     xlColor color;
-    layers[0]->buffer.Nodes[nodenum]->GetColor(color);
+    layers[0]->buffer.nodeTable.GetColor(nodenum, color);
     return color;
 }
 xlColor PixelBufferClass::GetNodeMaskColor(size_t nodenum) const
@@ -475,6 +476,370 @@ void PixelBufferClass::SetMixType(int layer, const std::string& MixName)
     layers[layer]->buffer.SetAllowAlphaChannel(MixTypeHandlesAlpha(layers[layer]->mixType));
 }
 
+// Span mixing kernels.  Each one produces exactly the same result as the
+// matching case in mixColors, PrepareMixSpan picks the kernel for a layer
+// once per frame so the per pixel switch and threshold handling go away.
+// The SSE2/NEON paths work on 4 pixels at a time and fall back to the
+// scalar code for any group that needs floating point blending.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XL_MIX_SSE2
+#define XL_MIX_SIMD
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define XL_MIX_NEON
+#define XL_MIX_SIMD
+#endif
+
+static_assert(sizeof(xlColor) == 4, "span mixing requires xlColor to be packed RGBA");
+
+namespace
+{
+#ifdef XL_MIX_SSE2
+    typedef __m128i MixVec;
+    inline MixVec mv_load(const xlColor *c) { return _mm_loadu_si128((const __m128i*)c); }
+    inline void mv_store(xlColor *c, MixVec v) { _mm_storeu_si128((__m128i*)c, v); }
+    inline MixVec mv_adds(MixVec a, MixVec b) { return _mm_adds_epu8(a, b); }
+    inline MixVec mv_subs(MixVec a, MixVec b) { return _mm_subs_epu8(a, b); }
+    inline MixVec mv_max(MixVec a, MixVec b) { return _mm_max_epu8(a, b); }
+    inline MixVec mv_min(MixVec a, MixVec b) { return _mm_min_epu8(a, b); }
+    // (a + b) / 2 rounded down, _mm_avg_epu8 rounds up
+    inline MixVec mv_havg(MixVec a, MixVec b) {
+        return _mm_add_epi8(_mm_and_si128(a, b),
+                            _mm_and_si128(_mm_srli_epi16(_mm_xor_si128(a, b), 1), _mm_set1_epi8(0x7F)));
+    }
+    inline MixVec mv_opaque(MixVec v) { return _mm_or_si128(v, _mm_set1_epi32(0xFF000000)); }
+    inline MixVec mv_rgbmax(MixVec v) {
+        v = _mm_and_si128(v, _mm_set1_epi32(0x00FFFFFF));
+        MixVec m = _mm_max_epu8(v, _mm_srli_epi32(v, 8));
+        m = _mm_max_epu8(m, _mm_srli_epi32(v, 16));
+        return _mm_and_si128(m, _mm_set1_epi32(0xFF));
+    }
+    inline MixVec mv_ge(MixVec v, int level) { return _mm_cmpgt_epi32(v, _mm_set1_epi32(level - 1)); }
+    inline MixVec mv_rgbzero(MixVec v) { return _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0x00FFFFFF)), _mm_setzero_si128()); }
+    inline MixVec mv_alphaeq(MixVec v, int a) { return _mm_cmpeq_epi32(_mm_srli_epi32(v, 24), _mm_set1_epi32(a)); }
+    inline MixVec mv_or(MixVec a, MixVec b) { return _mm_or_si128(a, b); }
+    inline MixVec mv_select(MixVec m, MixVec a, MixVec b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+    inline MixVec mv_black() { return _mm_set1_epi32(0xFF000000); }
+    inline bool mv_all(MixVec m) { return _mm_movemask_epi8(m) == 0xFFFF; }
+    inline bool mv_none(MixVec m) { return _mm_movemask_epi8(m) == 0; }
+#elif defined(XL_MIX_NEON)
+    typedef uint32x4_t MixVec;
+    inline MixVec mv_load(const xlColor *c) { return vld1q_u32((const uint32_t*)c); }
+    inline void mv_store(xlColor *c, MixVec v) { vst1q_u32((uint32_t*)c, v); }
+    inline MixVec mv_adds(MixVec a, MixVec b) { return vreinterpretq_u32_u8(vqaddq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b))); }
+    inline MixVec mv_subs(MixVec a, MixVec b) { return vreinterpretq_u32_u8(vqsubq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b))); }
+    inline MixVec mv_max(MixVec a, MixVec b) { return vreinterpretq_u32_u8(vmaxq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b))); }
+    inline MixVec mv_min(MixVec a, MixVec b) { return vreinterpretq_u32_u8(vminq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b))); }
+    inline MixVec mv_havg(MixVec a, MixVec b) { return vreinterpretq_u32_u8(vhaddq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b))); }
+    inline MixVec mv_opaque(MixVec v) { return vorrq_u32(v, vdupq_n_u32(0xFF000000)); }
+    inline MixVec mv_rgbmax(MixVec v) {
+        v = vandq_u32(v, vdupq_n_u32(0x00FFFFFF));
+        MixVec m = mv_max(v, vshrq_n_u32(v, 8));
+        m = mv_max(m, vshrq_n_u32(v, 16));
+        return vandq_u32(m, vdupq_n_u32(0xFF));
+    }
+    inline MixVec mv_ge(MixVec v, int level) { return vcgeq_u32(v, vdupq_n_u32(level)); }
+    inline MixVec mv_rgbzero(MixVec v) { return vceqq_u32(vandq_u32(v, vdupq_n_u32(0x00FFFFFF)), vdupq_n_u32(0)); }
+    inline MixVec mv_alphaeq(MixVec v, int a) { return vceqq_u32(vshrq_n_u32(v, 24), vdupq_n_u32(a)); }
+    inline MixVec mv_or(MixVec a, MixVec b) { return vorrq_u32(a, b); }
+    inline MixVec mv_select(MixVec m, MixVec a, MixVec b) { return vbslq_u32(m, a, b); }
+    inline MixVec mv_black() { return vdupq_n_u32(0xFF000000); }
+    inline bool mv_all(MixVec m) {
+        uint32x2_t t = vand_u32(vget_low_u32(m), vget_high_u32(m));
+        return (vget_lane_u32(t, 0) & vget_lane_u32(t, 1)) == 0xFFFFFFFF;
+    }
+    inline bool mv_none(MixVec m) {
+        uint32x2_t t = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+        return (vget_lane_u32(t, 0) | vget_lane_u32(t, 1)) == 0;
+    }
+#endif
+
+    inline int RGBMax(const xlColor &c) {
+        return std::max(c.red, std::max(c.green, c.blue));
+    }
+
+    struct NormalMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            fg.alpha = p.alpha[fg.alpha];
+            bg.AlphaBlendForgroundOnto(fg);
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            for (int x = 0; x < 4; x++) {
+                fg[x].alpha = p.alpha[fg[x].alpha];
+            }
+            MixVec f = mv_load(fg);
+            MixVec opaque = mv_alphaeq(f, 255);
+            if (mv_all(mv_or(opaque, mv_alphaeq(f, 0)))) {
+                mv_store(bg, mv_select(opaque, f, mv_load(bg)));
+            } else {
+                for (int x = 0; x < 4; x++) {
+                    bg[x].AlphaBlendForgroundOnto(fg[x]);
+                }
+            }
+        }
+#endif
+    };
+
+    struct AdditiveMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            bg.Set(std::min(fg.red + bg.red, 255), std::min(fg.green + bg.green, 255), std::min(fg.blue + bg.blue, 255));
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            mv_store(bg, mv_opaque(mv_adds(mv_load(fg), mv_load(bg))));
+        }
+#endif
+    };
+
+    struct SubtractiveMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            bg.Set(std::max(bg.red - fg.red, 0), std::max(bg.green - fg.green, 0), std::max(bg.blue - fg.blue, 0));
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            mv_store(bg, mv_opaque(mv_subs(mv_load(bg), mv_load(fg))));
+        }
+#endif
+    };
+
+    struct MaxMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            bg.Set(std::max(fg.red, bg.red), std::max(fg.green, bg.green), std::max(fg.blue, bg.blue));
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            mv_store(bg, mv_opaque(mv_max(mv_load(fg), mv_load(bg))));
+        }
+#endif
+    };
+
+    struct MinMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            bg.Set(std::min(fg.red, bg.red), std::min(fg.green, bg.green), std::min(fg.blue, bg.blue));
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            mv_store(bg, mv_opaque(mv_min(mv_load(fg), mv_load(bg))));
+        }
+#endif
+    };
+
+    struct AverageMix {
+        // only average when both colors are non-black
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            if (bg == xlBLACK) {
+                bg = fg;
+            } else if (fg != xlBLACK) {
+                bg.Set((fg.Red() + bg.Red()) / 2, (fg.Green() + bg.Green()) / 2, (fg.Blue() + bg.Blue()) / 2);
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec f = mv_load(fg);
+            MixVec b = mv_load(bg);
+            MixVec avg = mv_opaque(mv_havg(f, b));
+            mv_store(bg, mv_select(mv_rgbzero(b), f, mv_select(mv_rgbzero(f), b, avg)));
+        }
+#endif
+    };
+
+    // first masks second
+    struct Mask1Mix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            if (RGBMax(fg) >= p.thresholdLevel) {
+                bg.Set(0, 0, 0);
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec m = mv_ge(mv_rgbmax(mv_load(fg)), p.thresholdLevel);
+            mv_store(bg, mv_select(m, mv_black(), mv_load(bg)));
+        }
+#endif
+    };
+
+    // second masks first
+    struct Mask2Mix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            if (RGBMax(bg) < p.thresholdLevel) {
+                bg = fg;
+            } else {
+                bg.Set(0, 0, 0);
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec m = mv_ge(mv_rgbmax(mv_load(bg)), p.thresholdLevel);
+            mv_store(bg, mv_select(m, mv_black(), mv_load(fg)));
+        }
+#endif
+    };
+
+    // effect 1 shows where it is non black, also used for "2 reveals 1" and "Layered"
+    // with the colors swapped
+    struct RevealMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            if (RGBMax(fg) >= p.thresholdLevel) {
+                bg = fg;
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec f = mv_load(fg);
+            MixVec m = mv_ge(mv_rgbmax(f), p.thresholdLevel);
+            mv_store(bg, mv_select(m, f, mv_load(bg)));
+        }
+#endif
+    };
+    struct LayeredMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            if (RGBMax(bg) < p.thresholdLevel) {
+                bg = fg;
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec b = mv_load(bg);
+            MixVec m = mv_ge(mv_rgbmax(b), p.thresholdLevel);
+            mv_store(bg, mv_select(m, b, mv_load(fg)));
+        }
+#endif
+    };
+
+    // The unmask modes need the HSV round trip to stay identical, only the
+    // "everything is masked out" case is vectorised
+    template <bool FIRST, bool TRUE_UNMASK>
+    struct UnmaskMix {
+        static void Mix(xlColor &fg, xlColor &bg, const MixSpanParams &p) {
+            const xlColor &mask = FIRST ? fg : bg;
+            if (RGBMax(mask) >= p.thresholdLevel) {
+                HSVValue hsv0 = fg.asHSV();
+                HSVValue hsv1 = bg.asHSV();
+                if (FIRST) {
+                    if (!TRUE_UNMASK) {
+                        hsv1.value = hsv0.value;
+                    }
+                    bg = hsv1;
+                } else {
+                    if (!TRUE_UNMASK) {
+                        hsv0.value = hsv1.value;
+                    }
+                    bg = hsv0;
+                }
+            } else {
+                bg.Set(0, 0, 0);
+            }
+        }
+#ifdef XL_MIX_SIMD
+        static void Mix4(xlColor *fg, xlColor *bg, const MixSpanParams &p) {
+            MixVec m = mv_ge(mv_rgbmax(mv_load(FIRST ? fg : bg)), p.thresholdLevel);
+            if (mv_none(m)) {
+                mv_store(bg, mv_black());
+            } else {
+                for (int x = 0; x < 4; x++) {
+                    Mix(fg[x], bg[x], p);
+                }
+            }
+        }
+#endif
+    };
+
+    template <class Op>
+    void MixSpanKernel(xlColor *fg, xlColor *bg, int count, const MixSpanParams &params) {
+        int i = 0;
+#ifdef XL_MIX_SIMD
+        for (; i + 4 <= count; i += 4) {
+            Op::Mix4(fg + i, bg + i, params);
+        }
+#endif
+        for (; i < count; i++) {
+            Op::Mix(fg[i], bg[i], params);
+        }
+    }
+
+    MixSpanFunction GetMixSpanFunction(MixTypes mt) {
+        switch (mt) {
+        case Mix_Normal:
+            return MixSpanKernel<NormalMix>;
+        case Mix_Additive:
+            return MixSpanKernel<AdditiveMix>;
+        case Mix_Subtractive:
+            return MixSpanKernel<SubtractiveMix>;
+        case Mix_Max:
+            return MixSpanKernel<MaxMix>;
+        case Mix_Min:
+            return MixSpanKernel<MinMix>;
+        case Mix_Average:
+            return MixSpanKernel<AverageMix>;
+        case Mix_Mask1:
+            return MixSpanKernel<Mask1Mix>;
+        case Mix_Mask2:
+            return MixSpanKernel<Mask2Mix>;
+        case Mix_1_reveals_2:
+            return MixSpanKernel<RevealMix>;
+        case Mix_2_reveals_1:
+        case Mix_Layered:
+            return MixSpanKernel<LayeredMix>;
+        case Mix_Unmask1:
+            return MixSpanKernel<UnmaskMix<true, false>>;
+        case Mix_TrueUnmask1:
+            return MixSpanKernel<UnmaskMix<true, true>>;
+        case Mix_Unmask2:
+            return MixSpanKernel<UnmaskMix<false, false>>;
+        case Mix_TrueUnmask2:
+            return MixSpanKernel<UnmaskMix<false, true>>;
+        default:
+            // cross fades, shadows and the positional modes go through mixColors
+            return nullptr;
+        }
+    }
+}
+
+void PixelBufferClass::PrepareMixSpan(LayerInfo* layer)
+{
+    layer->mixSpan = GetMixSpanFunction(layer->mixType);
+    if (layer->mixSpan == nullptr) {
+        return;
+    }
+    MixSpanParams &p = layer->mixParams;
+    p.threshold = layer->effectMixVaries ? layer->buffer.GetEffectTimeIntervalPosition() : layer->effectMixThreshold;
+    if (p.threshold < 0) {
+        p.threshold = 0;
+    }
+    // HSV value is max(r,g,b) / 255.0 so "value > threshold" becomes an integer compare
+    p.thresholdLevel = 0;
+    while (p.thresholdLevel < 256 && !((double)p.thresholdLevel / 255.0 > p.threshold)) {
+        p.thresholdLevel++;
+    }
+    for (int a = 0; a < 256; a++) {
+        xlColor c(0, 0, 0, a);
+        c.alpha = c.alpha * layer->fadeFactor * (1.0 - p.threshold);
+        p.alpha[a] = c.alpha;
+    }
+}
+
+void PixelBufferClass::MixSpan(const int *x, const int *y, xlColor *fg, xlColor *bg, int count, int layer)
+{
+    LayerInfo *thelayer = layers[layer];
+    if (thelayer->mixSpan == nullptr) {
+        for (int i = 0; i < count; i++) {
+            mixColors(x[i], y[i], fg[i], bg[i], layer);
+        }
+        return;
+    }
+    if (!thelayer->buffer.allowAlpha && thelayer->fadeFactor != 1.0) {
+        //need to fade the first here as we're not mixing anything
+        for (int i = 0; i < count; i++) {
+            HSVValue hsv0 = fg[i].asHSV();
+            hsv0.value *= thelayer->fadeFactor;
+            fg[i] = hsv0;
+        }
+    }
+    thelayer->mixSpan(fg, bg, count, thelayer->mixParams);
+}
+
 void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer)
 {
     static const int n = 0;  //increase to change the curve of the crossfade
@@ -711,14 +1076,19 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
     }
 }
 
-void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod)
+void PixelBufferClass::GetMixedColors(int start, int end, xlColor *colors, const std::vector<bool> & validLayers, int EffectPeriod)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    unsigned short &sparkle = layers[0]->buffer.Nodes[node]->sparkle;
-    int cnt = 0;
-    c = xlBLACK;
-    xlColor color;
+    int count = end - start;
+    std::vector<xlColor> fg(count);
+    std::vector<int> xs(count);
+    std::vector<int> ys(count);
+    std::vector<bool> hasColor(count, false);
+    std::vector<HSVValue> hsv;
+    for (int i = 0; i < count; i++) {
+        colors[i] = xlBLACK;
+    }
 
     for (int layer = numLayers - 1; layer >= 0; layer--) {
         if (validLayers[layer]) {
@@ -726,20 +1096,68 @@ void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<boo
 
             // TEMPORARY - THIS SHOULD BE REMOVED BUT I WANT TO SEE WHAT IS CAUSING SOME RANDOM CRASHES - KW - 2017.7
             if (thelayer == nullptr) {
-                logger_base.crit("PixelBufferClass::GetMixedColor thelayer is nullptr ... this is going to crash.");
+                logger_base.crit("PixelBufferClass::GetMixedColors thelayer is nullptr ... this is going to crash.");
             }
 
-            if (node >= thelayer->buffer.Nodes.size()) {
-                //logger_base.crit("PixelBufferClass::GetMixedColor thelayer->buffer.Nodes does not contain node %d as it is only %d in size ... this was going to crash.", node, thelayer->buffer.Nodes.size());
+            const NodeTable &nodeTable = thelayer->buffer.nodeTable;
+            int layerCount = std::min(end, (int)nodeTable.size()) - start;
+            if (layerCount <= 0) {
+                continue;
+            }
+
+            int effStartPer, effEndPer;
+            thelayer->buffer.GetEffectPeriods(effStartPer, effEndPer);
+            float offset = ((float)(EffectPeriod - effStartPer)) / ((float)(effEndPer - effStartPer));
+            offset = std::min(offset, 1.0f);
+
+            float ha;
+            if (thelayer->activeValueCurves & LayerInfo::VC_HUEADJUST) {
+                ha = thelayer->HueAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
             } else {
-                int effStartPer, effEndPer;
-                thelayer->buffer.GetEffectPeriods(effStartPer, effEndPer);
-                float offset = ((float)(EffectPeriod - effStartPer)) / ((float)(effEndPer - effStartPer));
-                offset = std::min(offset, 1.0f);
+                ha = (float)thelayer->hueadjust / 100.0;
+            }
+            float sa;
+            if (thelayer->activeValueCurves & LayerInfo::VC_SATURATIONADJUST) {
+                sa = thelayer->SaturationAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
+            } else {
+                sa = (float)thelayer->saturationadjust / 100.0;
+            }
+
+            float va;
+            if (thelayer->activeValueCurves & LayerInfo::VC_VALUEADJUST) {
+                va = thelayer->ValueAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
+            } else {
+                va = (float)thelayer->valueadjust / 100.0;
+            }
+
+            bool sparkles = thelayer->use_music_sparkle_count ||
+                thelayer->sparkle_count > 0 ||
+                (thelayer->activeValueCurves & LayerInfo::VC_SPARKLES);
+            int sc = thelayer->sparkle_count;
+            if (sparkles) {
+                if (thelayer->activeValueCurves & LayerInfo::VC_SPARKLES) {
+                    sc = (int)thelayer->SparklesValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS());
+                }
+                if (thelayer->use_music_sparkle_count) {
+                    sc = (int)(thelayer->music_sparkle_count_factor * (float)sc);
+                }
+            }
 
-                auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
-                int x = coord.bufX;
-                int y = coord.bufY;
+            int b;
+            if (thelayer->activeValueCurves & LayerInfo::VC_BRIGHTNESS) {
+                b = (int)thelayer->BrightnessValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS());
+            } else {
+                b = thelayer->brightness;
+            }
+
+            for (int i = 0; i < layerCount; i++) {
+                int node = start + i;
+                xlColor &color = fg[i];
+
+                int x = nodeTable.firstX[node];
+                int y = nodeTable.firstY[node];
+                xs[i] = x;
+                ys[i] = y;
 
                 if (thelayer->isMasked(x, y)
                     || x < 0
@@ -751,128 +1169,54 @@ void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<boo
                 } else {
                     thelayer->buffer.GetPixel(x, y, color);
                 }
+            }
 
-                float ha;
-                if (thelayer->HueAdjustValueCurve.IsActive()) {
-                    ha = thelayer->HueAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
-                } else {
-                    ha = (float)thelayer->hueadjust / 100.0;
-                }
-                float sa;
-                if (thelayer->SaturationAdjustValueCurve.IsActive()) {
-                    sa = thelayer->SaturationAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
-                } else {
-                    sa = (float)thelayer->saturationadjust / 100.0;
-                }
-                
-                float va;
-                if (thelayer->ValueAdjustValueCurve.IsActive()) {
-                    va = thelayer->ValueAdjustValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS()) / 100.0;
-                } else {
-                    va = (float)thelayer->valueadjust / 100.0;
-                }
-                
-                // adjust for HSV adjustments
-                if (ha != 0 || sa != 0 || va != 0) {
-                    HSVValue hsv = color.asHSV();
-
-                    if (ha != 0) {
-                        hsv.hue += ha;
-                        if (hsv.hue < 0) {
-                            hsv.hue += 1.0;
-                        } else if (hsv.hue > 1) {
-                            hsv.hue -= 1.0;
-                        }
-                    }
-
-                    if (sa != 0) {
-                        hsv.saturation += sa;
-                        if (hsv.saturation < 0) {
-                            hsv.saturation = 0.0;
-                        } else if (hsv.saturation > 1) {
-                            hsv.saturation = 1.0;
-                        }
-                    }
+            // adjust for HSV adjustments
+            if (ha != 0 || sa != 0 || va != 0) {
+                AdjustHSV(&fg[0], layerCount, ha, sa, va);
+            }
 
-                    if (va != 0) {
-                        hsv.value += va;
-                        if (hsv.value < 0) {
-                            hsv.value = 0.0;
-                        } else if (hsv.value > 1) {
-                            hsv.value = 1.0;
+            // add sparkles
+            if (sparkles) {
+                for (int i = 0; i < layerCount; i++) {
+                    xlColor &color = fg[i];
+                    if (color != xlBLACK) {
+                        unsigned short &sparkle = layers[0]->buffer.nodeTable.sparkle[start + i];
+                        switch (sparkle % (208 - sc))
+                        {
+                        case 1:
+                        case 7:
+                            // too dim
+                            //color.Set("#444444");
+                            break;
+                        case 2:
+                        case 6:
+                            color.Set(0x88, 0x88, 0x88);
+                            break;
+                        case 3:
+                        case 5:
+                            color.Set(0xbb, 0xbb, 0xbb);
+                            break;
+                        case 4:
+                            color.Set(255, 255, 255);
+                            break;
+                        default:
+                            break;
                         }
+                        sparkle++;
                     }
-
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                }
-
-                // add sparkles
-                if (color != xlBLACK &&
-                    (thelayer->use_music_sparkle_count ||
-                        thelayer->sparkle_count > 0 ||
-                        thelayer->SparklesValueCurve.IsActive())) {
-                        
-                    int sc = thelayer->sparkle_count;
-                    if (thelayer->SparklesValueCurve.IsActive()) {
-                        sc = (int)thelayer->SparklesValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS());
-                    }
-                    if (thelayer->use_music_sparkle_count) {
-                        sc = (int)(thelayer->music_sparkle_count_factor * (float)sc);
-                    }
-
-                    switch (sparkle % (208 - sc))
-                    {
-                    case 1:
-                    case 7:
-                        // too dim
-                        //color.Set("#444444");
-                        break;
-                    case 2:
-                    case 6:
-                        color.Set(0x88, 0x88, 0x88);
-                        break;
-                    case 3:
-                    case 5:
-                        color.Set(0xbb, 0xbb, 0xbb);
-                        break;
-                    case 4:
-                        color.Set(255, 255, 255);
-                        break;
-                    default:
-                        break;
-                    }
-                    sparkle++;
                 }
-                int b;
-                if (thelayer->BrightnessValueCurve.IsActive()) {
-                    b = (int)thelayer->BrightnessValueCurve.GetOutputValueAt(offset, thelayer->buffer.GetStartTimeMS(), thelayer->buffer.GetEndTimeMS());
-                } else {
-                    b = thelayer->brightness;
-                }
-                if (thelayer->contrast != 0) {
-                    //contrast is not 0, can handle brightness change at same time
-                    HSVValue hsv = color.asHSV();
-                    hsv.value = hsv.value * ((double)b / 100.0);
-
-                    // Apply Contrast
-                    if (hsv.value < 0.5) {
-                        // reduce brightness when below 0.5 in the V value or increase if > 0.5
-                        hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
-                    } else {
-                        hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
-                    }
+            }
 
-                    if (hsv.value < 0.0) hsv.value = 0.0;
-                    if (hsv.value > 1.0) hsv.value = 1.0;
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                } else if (b != 100) {
-                    //just brightness
-                    float ba = b;
-                    ba /= 100.0f;
+            if (thelayer->contrast != 0) {
+                //contrast is not 0, can handle brightness change at same time
+                AdjustBrightnessContrast(&fg[0], layerCount, b, thelayer->contrast);
+            } else if (b != 100) {
+                //just brightness
+                float ba = b;
+                ba /= 100.0f;
+                for (int i = 0; i < layerCount; i++) {
+                    xlColor &color = fg[i];
                     float f = color.red * ba;
                     color.red = std::min((int)f, 255);
                     f = color.green * ba;
@@ -880,23 +1224,43 @@ void PixelBufferClass::GetMixedColor(int node, xlColor& c, const std::vector<boo
                     f = color.blue * ba;
                     color.blue = std::min((int)f, 255);
                 }
+            }
 
-                if (cnt > 0) {
-                    mixColors(x, y, color, c, layer);
+            // mix whole runs of nodes that already have a color below them, the
+            // first layer a node gets is faded/blended onto black instead
+            int i = 0;
+            while (i < layerCount) {
+                int runEnd = i;
+                bool mix = hasColor[i];
+                while (runEnd < layerCount && hasColor[runEnd] == mix) {
+                    runEnd++;
+                }
+                if (mix) {
+                    MixSpan(&xs[i], &ys[i], &fg[i], &colors[i], runEnd - i, layer);
                 } else if (thelayer->fadeFactor != 1.0) {
                     //need to fade the first here as we're not mixing anything
-                    HSVValue hsv = color.asHSV();
-                    hsv.value *= thelayer->fadeFactor;
-                    if (color.alpha != 255) {
-                        hsv.value *= color.alpha;
-                        hsv.value /= 255.0f;
+                    int n = runEnd - i;
+                    hsv.resize(n);
+                    ColorsToHSV(&fg[i], &hsv[0], n);
+                    for (int h = 0; h < n; h++) {
+                        hsv[h].value *= thelayer->fadeFactor;
+                        if (fg[i + h].alpha != 255) {
+                            hsv[h].value *= fg[i + h].alpha;
+                            hsv[h].value /= 255.0f;
+                        }
+                    }
+                    // the nodes have no color yet so are still opaque black
+                    ColorsFromHSV(&hsv[0], &colors[i], n);
+                    for (int h = i; h < runEnd; h++) {
+                        hasColor[h] = true;
                     }
-                    c = hsv;
                 } else {
-                    c.AlphaBlendForgroundOnto(color);
+                    for (int n = i; n < runEnd; n++) {
+                        colors[n].AlphaBlendForgroundOnto(fg[n]);
+                        hasColor[n] = true;
+                    }
                 }
-
-                cnt++;
+                i = runEnd;
             }
         }
     }
@@ -1144,172 +1508,95 @@ static void boxesForGauss(int d, int n, std::vector<float> &boxes)  // standard
     }
 }
 
-#define RED(a, b) a[(b)*4]
-#define GREEN(a, b) a[(b)*4 + 1]
-#define BLUE(a, b) a[(b)*4 + 2]
-#define ALPHA(a, b) a[(b)*4 + 3]
-static inline void SET(float *ar, int idx, float r, float g, float b, float a) {
-    idx *= 4;
-    ar[idx++] = r;
-    ar[idx++] = g;
-    ar[idx++] = b;
-    ar[idx] = a;
-}
-
-static void boxBlurH_4 (const float  * const scl, float *tcl, int w, int h, float r) {
-    float iarr = 1.0f / (r+r+1.0f);
-    for(int i=0; i<h; i++) {
-        int ti = i*w;
-        int li = ti;
-        int ri = ti+r;
-        int maxri = ti + w - 1;
-        int fvIdx = ti;
-        int lvIdx = ti+w-1;
-
-        float valr = (r+1.0) * RED(scl,fvIdx);
-        float valg = (r+1.0) * GREEN(scl,fvIdx);
-        float valb = (r+1.0) * BLUE(scl,fvIdx);
-        float vala = (r+1.0) * ALPHA(scl,fvIdx);
-
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
-
-        for (int j=0; j<r; j++) {
-            int idx = j < w ? ti+j : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
-        }
-        for (int j=0  ; j<=r ; j++) {
-            int idx = ri <= maxri ? ri++ : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
-
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
-            }
-        }
-        for (int j=r+1; j<w-r; j++) {
-            int c = ri <= maxri ? ri++ : lvIdx;
-            int c2 = li <= maxri ? li++ : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
-            }
-        }
+// The box passes blur all four channels of a pixel at once and walk a row or
+// a column with the same arithmetic, in the same order, as the original
+// per channel loops so the output is unchanged.  Rows and columns are
+// independent so big buffers spread them over the thread pool.
+namespace
+{
+#ifdef XL_MIX_SSE2
+    typedef __m128 BlurVec;
+    inline BlurVec bv_load(const float *f) { return _mm_loadu_ps(f); }
+    inline void bv_store(float *f, BlurVec v) { _mm_storeu_ps(f, v); }
+    inline BlurVec bv_set(float f) { return _mm_set1_ps(f); }
+    inline BlurVec bv_add(BlurVec a, BlurVec b) { return _mm_add_ps(a, b); }
+    inline BlurVec bv_sub(BlurVec a, BlurVec b) { return _mm_sub_ps(a, b); }
+    inline BlurVec bv_mul(BlurVec a, BlurVec b) { return _mm_mul_ps(a, b); }
+#elif defined(XL_MIX_NEON)
+    typedef float32x4_t BlurVec;
+    inline BlurVec bv_load(const float *f) { return vld1q_f32(f); }
+    inline void bv_store(float *f, BlurVec v) { vst1q_f32(f, v); }
+    inline BlurVec bv_set(float f) { return vdupq_n_f32(f); }
+    inline BlurVec bv_add(BlurVec a, BlurVec b) { return vaddq_f32(a, b); }
+    inline BlurVec bv_sub(BlurVec a, BlurVec b) { return vsubq_f32(a, b); }
+    inline BlurVec bv_mul(BlurVec a, BlurVec b) { return vmulq_f32(a, b); }
+#else
+    struct BlurVec { float v[4]; };
+    inline BlurVec bv_load(const float *f) { BlurVec r; for (int x = 0; x < 4; x++) r.v[x] = f[x]; return r; }
+    inline void bv_store(float *f, BlurVec v) { for (int x = 0; x < 4; x++) f[x] = v.v[x]; }
+    inline BlurVec bv_set(float f) { BlurVec r; for (int x = 0; x < 4; x++) r.v[x] = f; return r; }
+    inline BlurVec bv_add(BlurVec a, BlurVec b) { for (int x = 0; x < 4; x++) a.v[x] += b.v[x]; return a; }
+    inline BlurVec bv_sub(BlurVec a, BlurVec b) { for (int x = 0; x < 4; x++) a.v[x] -= b.v[x]; return a; }
+    inline BlurVec bv_mul(BlurVec a, BlurVec b) { for (int x = 0; x < 4; x++) a.v[x] *= b.v[x]; return a; }
+#endif
+}
 
-        for (int j=w-r; j<w  ; j++) {
-            int c2 = li <= maxri ? li++: lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
-            }
-        }
+// one running sum box pass along a line of len RGBA pixels that are stride floats apart
+static void boxBlurLine(const float *scl, float *tcl, int len, int stride, int r) {
+    const BlurVec iarr = bv_set(1.0f / (r + r + 1.0f));
+    const int last = len - 1;
+    const BlurVec fv = bv_load(scl);
+    const BlurVec lv = bv_load(scl + last * stride);
+
+    BlurVec val = bv_mul(bv_set(r + 1.0f), fv);
+    for (int j = 0; j < r; j++) {
+        val = bv_add(val, bv_load(scl + std::min(j, last) * stride));
     }
-}
 
-static void boxBlurT_4 (const float * const scl, float *tcl, int w, int h, float r) {
-    float iarr = 1.0f / (r+r+1.0f);
-    for(int i=0; i<w; i++) {
-        int ti = i;
-        int li = ti;
-        int ri = ti+r*w;
-
-        int maxri = ti+w*(h-1);
-
-        int fvIdx = ti;
-        int lvIdx = ti+w*(h-1);
-
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
-
-        float valr = (r+1)*fvRed;
-        float valg = (r+1)*fvGreen;
-        float valb = (r+1)*fvBlue;
-        float vala = (r+1)*fvAlpha;
-
-        for(int j=0; j<r; j++) {
-            int idx = j < w ? ti+j*w : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
-        }
-        for(int j=0  ; j<=r ; j++) {
-            int idx = ri <= maxri ? ri : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-            }
-            ri+=w;
-            ti+=w;
-        }
-        for(int j=r+1; j<h-r; j++) {
-            int c = ri <= maxri ? ri : lvIdx;
-            int c2 = li <= maxri ? li : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-            }
-            li+=w; ri+=w; ti+=w;
-        }
-        for(int j=h-r; j<h  ; j++) {
-            int c2 = li <= maxri ? li : lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-            }
-            li += w;
-            ti += w;
+    int ti = 0;
+    int li = 0;
+    int ri = r;
+    for (int j = 0; j <= r; j++) {
+        val = bv_add(val, bv_sub(bv_load(scl + std::min(ri++, last) * stride), fv));
+        if (ti <= last) {
+            bv_store(tcl + ti++ * stride, bv_mul(val, iarr));
+        }
+    }
+    for (int j = r + 1; j < len - r; j++) {
+        val = bv_add(val, bv_sub(bv_load(scl + std::min(ri++, last) * stride), bv_load(scl + std::min(li++, last) * stride)));
+        if (ti <= last) {
+            bv_store(tcl + ti++ * stride, bv_mul(val, iarr));
+        }
+    }
+    for (int j = len - r; j < len; j++) {
+        val = bv_add(val, bv_sub(lv, bv_load(scl + std::min(li++, last) * stride)));
+        if (ti <= last) {
+            bv_store(tcl + ti++ * stride, bv_mul(val, iarr));
         }
     }
 }
 
-static void boxBlur_4(float *scl, float *tcl, int w, int h, float r, int size) {
-    memcpy(tcl, scl, sizeof(float)*4*size);
-    boxBlurH_4(tcl, scl, w, h, r);
-    boxBlurT_4(scl, tcl, w, h, r);
+// blurs scl in place, tcl is scratch space of the same size
+static void boxBlur_4(float *scl, float *tcl, int w, int h, int r) {
+    // keep each task to a few thousand pixels so small buffers stay on this thread
+    parallel_for_range(0, h, [scl, tcl, w, r](int start, int end) {
+        for (int y = start; y < end; y++) {
+            boxBlurLine(scl + y * w * 4, tcl + y * w * 4, w, 4, r);
+        }
+    }, std::max(1, 4096 / w));
+    parallel_for_range(0, w, [scl, tcl, w, h, r](int start, int end) {
+        for (int x = start; x < end; x++) {
+            boxBlurLine(tcl + x * 4, scl + x * 4, h, w * 4, r);
+        }
+    }, std::max(1, 4096 / h));
 }
 
-static void gaussBlur_4(float *scl, float *tcl, int w, int h, int r, int size) {
+static void gaussBlur_4(float *scl, float *tcl, int w, int h, int r) {
     std::vector<float> bxs;
     boxesForGauss(r - 1, 3, bxs);
-    boxBlur_4 (scl, tcl, w, h, (bxs[0]-1)/2, size);
-    boxBlur_4 (tcl, scl, w, h, (bxs[1]-1)/2, size);
-    boxBlur_4 (scl, tcl, w, h, (bxs[2]-1)/2, size);
+    boxBlur_4(scl, tcl, w, h, ((int)bxs[0] - 1) / 2);
+    boxBlur_4(scl, tcl, w, h, ((int)bxs[1] - 1) / 2);
+    boxBlur_4(scl, tcl, w, h, ((int)bxs[2] - 1) / 2);
 }
 
 static inline int roundInt(float r) {
@@ -1336,8 +1623,8 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
         return;
     } else if (b > 2 && layer->BufferWi > 6 && layer->BufferHt > 6) {
         int pixCount = layer->buffer.pixels.size();
-        float * input = new float[pixCount * 4];
-        float * tmp = new float[pixCount * 4];
+        std::vector<float> input(pixCount * 4);
+        std::vector<float> tmp(pixCount * 4);
         for (int x = 0; x < pixCount; x++) {
             const xlColor &c = layer->buffer.pixels[x];
             input[x * 4] = c.red;
@@ -1345,16 +1632,14 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
             input[x * 4 + 2] = c.blue;
             input[x * 4 + 3] = c.alpha;
         }
-        gaussBlur_4(input, tmp, layer->BufferWi, layer->BufferHt, b, pixCount);
+        gaussBlur_4(&input[0], &tmp[0], layer->BufferWi, layer->BufferHt, b);
 
         for (int x = 0; x < pixCount; x++) {
-            layer->buffer.pixels[x].Set(roundInt(tmp[x*4]),
-                                        roundInt(tmp[x*4 + 1]),
-                                        roundInt(tmp[x*4 + 2]),
-                                        roundInt(tmp[x*4 + 3]));
+            layer->buffer.pixels[x].Set(roundInt(input[x*4]),
+                                        roundInt(input[x*4 + 1]),
+                                        roundInt(input[x*4 + 2]),
+                                        roundInt(input[x*4 + 3]));
         }
-        delete [] input;
-        delete [] tmp;
     } else {
         int d;
         int u;
@@ -1368,34 +1653,47 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
             d = (b - 1) / 2;
             u = (b - 1) / 2;
         }
-        RenderBuffer orig(layer->buffer);
-        for (int x = 0; x < layer->BufferWi; x++)
+
+        // the sum over the square of pixels inside the buffer is the sum of the
+        // row sums, so sum the rows once and then add those up down the columns
+        const int w = layer->BufferWi;
+        const int h = layer->BufferHt;
+        std::vector<int> rowSums(w * h * 4);
+        for (int y = 0; y < h; y++)
         {
-            for (int y = 0; y < layer->BufferHt; y++)
+            for (int x = 0; x < w; x++)
+            {
+                int *sum = &rowSums[(y * w + x) * 4];
+                for (int i = std::max(x - d, 0); i <= std::min(x + u, w - 1); i++)
+                {
+                    const xlColor &c = layer->buffer.GetPixel(i, y);
+                    sum[0] += c.red;
+                    sum[1] += c.green;
+                    sum[2] += c.blue;
+                    sum[3] += c.alpha;
+                }
+            }
+        }
+        for (int x = 0; x < w; x++)
+        {
+            int cols = std::min(x + u, w - 1) - std::max(x - d, 0) + 1;
+            for (int y = 0; y < h; y++)
             {
                 int r = 0;
                 int g = 0;
                 int b2 = 0;
                 int a = 0;
-                int sm = 0;
-                for (int i = x - d; i <= x + u; i++)
+                int jmin = std::max(y - d, 0);
+                int jmax = std::min(y + u, h - 1);
+                for (int j = jmin; j <= jmax; j++)
                 {
-                    if (i >= 0 && i < layer->BufferWi)
-                    {
-                        for (int j = y - d; j <= y + u; j++)
-                        {
-                            if (j >=0 && j < layer->BufferHt)
-                            {
-                                const xlColor &c = orig.GetPixel(i, j);
-                                r += c.red;
-                                g += c.green;
-                                b2 += c.blue;
-                                a += c.alpha;
-                                ++sm;
-                            }
-                        }
-                    }
+                    const int *sum = &rowSums[(j * w + x) * 4];
+                    r += sum[0];
+                    g += sum[1];
+                    b2 += sum[2];
+                    a += sum[3];
                 }
+                int sm = cols * (jmax - jmin + 1);
                 layer->buffer.SetPixel(x, y, xlColor(r/sm, g/sm, b2/sm, a/sm));
             }
         }
@@ -1465,7 +1763,6 @@ static const std::string SLIDER_Contrast("SLIDER_Contrast");
 static const std::string STR_NORMAL("Normal");
 static const std::string STR_NONE("None");
 static const std::string STR_FADE("Fade");
-static const std::string STR_FOLD("Fold");
 
 static const std::string CHOICE_In_Transition_Type("CHOICE_In_Transition_Type");
 static const std::string CHOICE_Out_Transition_Type("CHOICE_Out_Transition_Type");
@@ -1485,23 +1782,90 @@ void ComputeValueCurve(const std::string& valueCurve, ValueCurve& theValueCurve,
     theValueCurve.Deserialise(valueCurve);
 }
 
+void SubBufferSpec::Parse(const std::string &subBuffer)
+{
+    static const float defaults[4] = { 0.0f, 0.0f, 100.0f, 100.0f };
+    for (int i = 0; i < 4; i++) {
+        _value[i] = defaults[i];
+        _hasCurve[i] = false;
+        _curve[i] = ValueCurve();
+    }
+    _empty = subBuffer == STR_EMPTY;
+    if (_empty) {
+        return;
+    }
+
+    // Max appears in the value curves so protect its x before splitting the edges apart
+    wxString sb = subBuffer;
+    sb.Replace("Max", "yyz");
+
+    wxArrayString v = wxSplit(sb, 'x');
+    for (int i = 0; i < 4 && i < (int)v.size(); i++) {
+        if (v[i].Contains("Active=TRUE")) {
+            v[i].Replace("yyz", "Max");
+            _curve[i] = ValueCurve(v[i].ToStdString());
+            _curve[i].SetLimits(-100, 200);
+            _hasCurve[i] = true;
+        } else {
+            _value[i] = wxAtof(v[i]);
+        }
+    }
+}
+
+float SubBufferSpec::GetEdge(int edge, float progress, long startMS, long endMS)
+{
+    if (_hasCurve[edge]) {
+        return _curve[edge].GetOutputValueAt(progress, startMS, endMS);
+    }
+    return _value[edge];
+}
+
+void SubBufferSpec::Bake(long startMS, long endMS, int frames)
+{
+    for (int i = 0; i < 4; i++) {
+        if (_hasCurve[i]) {
+            _curve[i].Bake(startMS, endMS, frames);
+        }
+    }
+}
+
+void SubBufferSpec::GetRect(int bufferWi, int bufferHi, float progress, long startMS, long endMS, int &x1Int, int &y1Int, int &x2Int, int &y2Int)
+{
+    float x1 = GetEdge(0, progress, startMS, endMS);
+    float y1 = GetEdge(1, progress, startMS, endMS);
+    float x2 = GetEdge(2, progress, startMS, endMS);
+    float y2 = GetEdge(3, progress, startMS, endMS);
+
+    if (x1 > x2) std::swap(x1, x2);
+    if (y1 > y2) std::swap(y1, y2);
+
+    x1 *= (float)bufferWi;
+    x2 *= (float)bufferWi;
+    y1 *= (float)bufferHi;
+    y2 *= (float)bufferHi;
+    x1 /= 100.0;
+    x2 /= 100.0;
+    y1 /= 100.0;
+    y2 /= 100.0;
+
+    x1Int = std::round(x1);
+    x2Int = std::round(x2);
+    y1Int = std::round(y1);
+    y2Int = std::round(y2);
+}
+
 // Works out the maximum buffer size reached based on a subbuffer - this may be larger than the model size but never less than the model size
-void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi, int& maxHt, int& maxWi, long startMS, long endMS)
+void ComputeMaxBuffer(SubBufferSpec& spec, const std::string& subBuffer, int BufferHt, int BufferWi, int& maxHt, int& maxWi, long startMS, long endMS)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    if (wxString(subBuffer).Contains("Active=TRUE"))
+    if (spec.IsVariable())
     {
         // value curve present ... we have work to do
-        wxString sb = subBuffer;
-        sb.Replace("Max", "yyz");
-
-        wxArrayString v = wxSplit(sb, 'x');
-
-        bool fx1vc = v.size() > 0 && v[0].Contains("Active=TRUE");
-        bool fy1vc = v.size() > 1 && v[1].Contains("Active=TRUE");
-        bool fx2vc = v.size() > 2 && v[2].Contains("Active=TRUE");
-        bool fy2vc = v.size() > 3 && v[3].Contains("Active=TRUE");
+        bool fx1vc = spec.HasCurve(0);
+        bool fy1vc = spec.HasCurve(1);
+        bool fx2vc = spec.HasCurve(2);
+        bool fy2vc = spec.HasCurve(3);
 
         // the larger the number the more fine grained the buffer assessment will be ... makes crashes less likely
         #define VCITERATIONS (10.0 * VC_X_POINTS)
@@ -1509,23 +1873,17 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
         float maxX = 0;
         if (fx1vc || fx2vc)
         {
-            v[0].Replace("yyz", "Max");
-            v[2].Replace("yyz", "Max");
-            ValueCurve vcx1(v[0].ToStdString());
-            ValueCurve vcx2(v[2].ToStdString());
-            vcx1.SetLimits(-100, 200);
-            vcx2.SetLimits(-100, 200);
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float valx1 = 0.0;
                 if (fx1vc)
                 {
-                    valx1 = vcx1.GetOutputValueAt((float)i / VCITERATIONS, startMS, endMS);
+                    valx1 = spec.GetEdge(0, (float)i / VCITERATIONS, startMS, endMS);
                 }
                 float valx2 = BufferWi;
                 if (fx2vc)
                 {
-                    valx2 = vcx2.GetOutputValueAt((float)i / VCITERATIONS, startMS, endMS);
+                    valx2 = spec.GetEdge(2, (float)i / VCITERATIONS, startMS, endMS);
                 }
                 float diff = std::abs(valx2 - valx1);
                 if (diff > maxX)
@@ -1538,23 +1896,17 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
         float maxY = 0;
         if (fy1vc || fy2vc)
         {
-            v[1].Replace("yyz", "Max");
-            v[3].Replace("yyz", "Max");
-            ValueCurve vcy1(v[1].ToStdString());
-            ValueCurve vcy2(v[3].ToStdString());
-            vcy1.SetLimits(-100, 200);
-            vcy2.SetLimits(-100, 200);
             for (int i = 0; i < VCITERATIONS; ++i)
             {
                 float valy1 = 0.0;
                 if (fy1vc)
                 {
-                    valy1 = vcy1.GetOutputValueAt((float)i / VCITERATIONS, startMS, endMS);
+                    valy1 = spec.GetEdge(1, (float)i / VCITERATIONS, startMS, endMS);
                 }
                 float valy2 = BufferWi;
                 if (fy2vc)
                 {
-                    valy2 = vcy2.GetOutputValueAt((float)i / VCITERATIONS, startMS, endMS);
+                    valy2 = spec.GetEdge(3, (float)i / VCITERATIONS, startMS, endMS);
                 }
                 float diff = std::abs(valy2 - valy1);
                 if (diff > maxY)
@@ -1581,117 +1933,33 @@ void ComputeMaxBuffer(const std::string& subBuffer, int BufferHt, int BufferWi,
     }
 }
 
-void ComputeSubBuffer(const std::string &subBuffer, std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHi, float progress, long startMS, long endMS) {
-
-    if (subBuffer == STR_EMPTY) {
+static void OffsetNodes(std::vector<NodeBaseClassPtr> &nodes, int dx, int dy)
+{
+    if (dx == 0 && dy == 0) {
         return;
     }
-
-    wxString sb = subBuffer;
-    sb.Replace("Max", "yyz");
-
-    wxArrayString v = wxSplit(sb, 'x');
-
-    bool fx1vc = v.size() > 0 && v[0].Contains("Active=TRUE");
-    bool fy1vc = v.size() > 1 && v[1].Contains("Active=TRUE");
-    bool fx2vc = v.size() > 2 && v[2].Contains("Active=TRUE");
-    bool fy2vc = v.size() > 3 && v[3].Contains("Active=TRUE");
-
-    float x1;
-    if (fx1vc)
-    {
-        v[0].Replace("yyz", "Max");
-        ValueCurve vc(v[0].ToStdString());
-        vc.SetLimits(-100, 200);
-        x1 = vc.GetOutputValueAt(progress, startMS, endMS);
-    }
-    else if (v.size() > 0)
-    {
-        x1 = wxAtof(v[0]);
-    }
-    else
-    {
-        x1 = 0.0;
+    for (size_t x = 0; x < nodes.size(); x++) {
+        for (auto &it2 : nodes[x]->Coords) {
+            it2.bufX -= dx;
+            it2.bufY -= dy;
+        }
     }
+}
 
-    float y1;
-    if (fy1vc)
-    {
-        v[1].Replace("yyz", "Max");
-        ValueCurve vc(v[1].ToStdString());
-        vc.SetLimits(-100, 200);
-        y1 = vc.GetOutputValueAt(progress, startMS, endMS);
-    }
-    else if (v.size() > 1)
-    {
-        y1 = wxAtof(v[1]);
-    }
-    else
-    {
-        y1 = 0.0;
-    }
+void ComputeSubBuffer(SubBufferSpec &spec, std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHi, float progress, long startMS, long endMS) {
 
-    float x2;
-    if (fx2vc)
-    {
-        v[2].Replace("yyz", "Max");
-        ValueCurve vc(v[2].ToStdString());
-        vc.SetLimits(-100, 200);
-        x2 = vc.GetOutputValueAt(progress, startMS, endMS);
-    }
-    else if (v.size() > 2)
-    {
-        x2 = wxAtof(v[2]);
-    }
-    else
-    {
-        x2 = 100.0;
-    }
-
-    float y2;
-    if (fy2vc)
-    {
-        v[3].Replace("yyz", "Max");
-        ValueCurve vc(v[3].ToStdString());
-        vc.SetLimits(-100, 200);
-        y2 = vc.GetOutputValueAt(progress, startMS, endMS);
-    }
-    else if (v.size() > 3)
-    {
-        y2 = wxAtof(v[3]);
-    }
-    else
-    {
-        y2 = 100.0;
+    if (spec.IsEmpty()) {
+        return;
     }
 
-    if (x1 > x2) std::swap(x1, x2);
-    if (y1 > y2) std::swap(y1, y2);
-
-    x1 *= (float)bufferWi;
-    x2 *= (float)bufferWi;
-    y1 *= (float)bufferHi;
-    y2 *= (float)bufferHi;
-    x1 /= 100.0;
-    x2 /= 100.0;
-    y1 /= 100.0;
-    y2 /= 100.0;
-    
-    int x1Int = std::round(x1);
-    int x2Int = std::round(x2);
-    int y1Int = std::round(y1);
-    int y2Int = std::round(y2);
+    int x1Int, y1Int, x2Int, y2Int;
+    spec.GetRect(bufferWi, bufferHi, progress, startMS, endMS, x1Int, y1Int, x2Int, y2Int);
 
     bufferWi = x2Int - x1Int;
     bufferHi = y2Int - y1Int;
     if (bufferWi < 1) bufferWi = 1;
     if (bufferHi < 1) bufferHi = 1;
-    for (size_t x = 0; x < newNodes.size(); x++) {
-        for (auto &it2 : newNodes[x]->Coords) {
-            it2.bufX -= x1Int;
-            it2.bufY -= y1Int;
-        }
-    }
+    OffsetNodes(newNodes, x1Int, y1Int);
 }
 
 void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMap) {
@@ -1791,21 +2059,26 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
         if (StartsWith(type, "Per Model")) {
             tt = "Single Line";
         }
-        model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
+        model->InitRenderBufferNodesCached(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
         if (origNodeCount != 0 && origNodeCount != inf->buffer.Nodes.size()) {
             inf->buffer.Nodes.clear();
-            model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
+            model->InitRenderBufferNodesCached(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
         }
         
+        if (inf->subBuffer != subBuffer) {
+            inf->subBufferSpec.Parse(subBuffer);
+        }
+        inf->subBufferNodesValid = false;
+
         int curBH = inf->BufferHt;
         int curBW = inf->BufferWi;
-        ComputeSubBuffer(subBuffer, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt, 0, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS());
+        ComputeSubBuffer(inf->subBufferSpec, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt, 0, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS());
         
         curBH = std::max(curBH, inf->BufferHt);
         curBW = std::max(curBW, inf->BufferWi);
 
         // save away the full model buffer size ... some effects need to know this
-        ComputeMaxBuffer(subBuffer, curBH, curBW, inf->ModelBufferHt, inf->ModelBufferWi, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS());
+        ComputeMaxBuffer(inf->subBufferSpec, subBuffer, curBH, curBW, inf->ModelBufferHt, inf->ModelBufferWi, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS());
 
         ComputeValueCurve(brightnessValueCurve, inf->BrightnessValueCurve);
         ComputeValueCurve(hueAdjustValueCurve, inf->HueAdjustValueCurve);
@@ -1852,7 +2125,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
                 std::string ntype = type.substr(10, type.length() - 10);
                 int bw, bh;
                 (*it)->Nodes.clear();
-                gp->Models()[cnt]->InitRenderBufferNodes(ntype, camera, transform, (*it)->Nodes, bw, bh);
+                gp->Models()[cnt]->InitRenderBufferNodesCached(ntype, camera, transform, (*it)->Nodes, bw, bh);
                 if (bw == 0) bw = 1; // zero sized buffers are a problem
                 if (bh == 0) bh = 1;
                 (*it)->InitBuffer(bh, bw, bh, bw, transform);
@@ -1862,12 +2135,19 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
             inf->usingModelBuffers = false;
         }
     }
+    inf->DecodeSettings();
 }
 
 bool PixelBufferClass::IsPersistent(int layer) {
     return layers[layer]->persistent;
 }
 
+bool PixelBufferClass::HasSparkles(int layer) const {
+    return layers[layer]->use_music_sparkle_count ||
+        layers[layer]->sparkle_count > 0 ||
+        (layers[layer]->activeValueCurves & LayerInfo::VC_SPARKLES);
+}
+
 RenderBuffer& PixelBufferClass::BufferForLayer(int layer, int idx)
 {
     if (idx >= 0 && layers[layer]->usingModelBuffers && idx < layers[layer]->modelBuffers.size()) {
@@ -1926,6 +2206,27 @@ void PixelBufferClass::SetTimes(int layer, int startTime, int endTime)
         }
     }
 
+    // the layer curves are evaluated for every frame of the effect so turn them into tables now
+    LayerInfo *inf = layers[layer];
+    ValueCurve::SetFrameTime(frameTimeInMs);
+    long startMS = inf->buffer.GetStartTimeMS();
+    long endMS = inf->buffer.GetEndTimeMS();
+    int frames = ValueCurve::GetBakeFrames(startMS, endMS);
+    ValueCurve *curves[] = {
+        &inf->BlurValueCurve, &inf->SparklesValueCurve, &inf->BrightnessValueCurve,
+        &inf->HueAdjustValueCurve, &inf->SaturationAdjustValueCurve, &inf->ValueAdjustValueCurve,
+        &inf->RotationValueCurve, &inf->XRotationValueCurve, &inf->YRotationValueCurve,
+        &inf->ZoomValueCurve, &inf->RotationsValueCurve, &inf->PivotPointXValueCurve,
+        &inf->PivotPointYValueCurve, &inf->XPivotValueCurve, &inf->YPivotValueCurve
+    };
+    for (auto vc : curves) {
+        if (vc->IsActive()) {
+            vc->Bake(startMS, endMS, frames);
+        }
+    }
+    if (inf->variableSubBuffer) {
+        inf->subBufferSpec.Bake(startMS, endMS, frames);
+    }
 }
 
 static inline bool IsInRange(const std::vector<bool> &restrictRange, size_t start) {
@@ -1938,33 +2239,39 @@ static inline bool IsInRange(const std::vector<bool> &restrictRange, size_t star
     return restrictRange[start];
 }
 
-void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange) {
-
-    // KW ... I think this needs to be optimised
+static void GetDimmingCurves(const NodeTable &nodeTable, std::vector<DimmingCurve*> &curves) {
+    curves.resize(nodeTable.models.size());
+    for (size_t x = 0; x < nodeTable.models.size(); x++) {
+        curves[x] = nodeTable.models[x] == nullptr ? nullptr : nodeTable.models[x]->modelDimmingCurve;
+    }
+}
 
+void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange) {
     if (layers[0] != nullptr) { // I dont like this ... it should never be null
-        for (auto &n : layers[0]->buffer.Nodes) {
-            size_t start = n->ActChan;
+        NodeTable &nodeTable = layers[0]->buffer.nodeTable;
+        std::vector<DimmingCurve*> curves;
+        GetDimmingCurves(nodeTable, curves);
+
+        size_t count = nodeTable.size();
+        for (size_t n = 0; n < count; n++) {
+            size_t start = nodeTable.actChan[n];
             if (IsInRange(restrictRange, start)) {
-                if (n->model != nullptr) { // nor this
-                    DimmingCurve *curve = n->model->modelDimmingCurve;
-                    if (curve != nullptr) {
-                        if (n->GetChanCount() == 1) {
-                            uint8_t buf[3];
-                            n->GetForChannels(buf);
-                            xlColor color(buf[0], buf[0], buf[0]);
-                            curve->apply(color);
-                            
-                            n->SetColor(color);
-                        } else {
-                            xlColor color;
-                            n->GetColor(color);
-                            curve->apply(color);
-                            n->SetColor(color);
-                        }
+                DimmingCurve *curve = curves[nodeTable.modelIndex[n]];
+                if (curve != nullptr) {
+                    if (nodeTable.chanCount[n] == 1) {
+                        uint8_t buf[3];
+                        nodeTable.GetForChannels(n, buf);
+                        xlColor color(buf[0], buf[0], buf[0]);
+                        curve->apply(color);
+                        nodeTable.SetColor(n, color);
+                    } else {
+                        xlColor color;
+                        nodeTable.GetColor(n, color);
+                        curve->apply(color);
+                        nodeTable.SetColor(n, color);
                     }
                 }
-                n->GetForChannels(&fdata[start]);
+                nodeTable.GetForChannels(n, &fdata[start]);
             }
         }
     }
@@ -1972,26 +2279,57 @@ void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &
 
 void PixelBufferClass::SetColors(int layer, const unsigned char *fdata)
 {
+    NodeTable &nodeTable = layers[layer]->buffer.nodeTable;
+    std::vector<DimmingCurve*> curves;
+    GetDimmingCurves(nodeTable, curves);
+
     xlColor color;
-    for (auto &n : layers[layer]->buffer.Nodes) {
-        size_t start = n->ActChan;
-        
-        n->SetFromChannels(&fdata[start]);
-        n->GetColor(color);
-        
-        DimmingCurve *curve = n->model->modelDimmingCurve;
+    size_t count = nodeTable.size();
+    for (size_t n = 0; n < count; n++) {
+        nodeTable.SetFromChannels(n, &fdata[nodeTable.actChan[n]]);
+        nodeTable.GetColor(n, color);
+
+        DimmingCurve *curve = curves[nodeTable.modelIndex[n]];
         if (curve != nullptr) {
             curve->reverse(color);
         }
-        for (auto &a : n->Coords) {
-            layers[layer]->buffer.SetPixel(a.bufX,
-                                           a.bufY,
+        for (uint32_t c = nodeTable.coordStart[n]; c < nodeTable.coordStart[n + 1]; c++) {
+            layers[layer]->buffer.SetPixel(nodeTable.bufX[c],
+                                           nodeTable.bufY[c],
                                            color);
-
         }
     }
 }
 
+// RotoZoom moves pixels from a copy of the layer back into the cleared layer.
+// The copy is kept with the layer so no axis has to copy a whole RenderBuffer.
+static const std::vector<xlColor> &SnapshotForRotoZoom(LayerInfo* layer)
+{
+    std::vector<xlColor> &pixels = layer->buffer.pixels;
+    layer->rotoZoomPixels.assign(pixels.begin(), pixels.end());
+    layer->buffer.Clear();
+    return layer->rotoZoomPixels;
+}
+
+// same as RenderBuffer::GetPixel on the copy
+static inline const xlColor &RotoZoomSource(const std::vector<xlColor> &orig, int w, int h, int x, int y)
+{
+    if (x >= 0 && x < w && y >= 0 && y < h && y * w + x < orig.size())
+    {
+        return orig[y * w + x];
+    }
+    return xlBLACK;
+}
+
+// same as RenderBuffer::SetPixel, transparent pixels leave what is already there
+static inline void RotoZoomSet(std::vector<xlColor> &pixels, int w, int h, int x, int y, const xlColor &c)
+{
+    if (c.alpha != 0 && x >= 0 && x < w && y >= 0 && y < h && y * w + x < pixels.size())
+    {
+        pixels[y * w + x] = c;
+    }
+}
+
 void PixelBufferClass::RotateX(LayerInfo* layer, float offset)
 {
     // Now do the rotation around a point on the x axis
@@ -2010,27 +2348,34 @@ void PixelBufferClass::RotateX(LayerInfo* layer, float offset)
             xpivot = layer->XPivotValueCurve.GetOutputValueAt(offset, layer->buffer.GetStartTimeMS(), layer->buffer.GetEndTimeMS());
         }
 
-        RenderBuffer orig(layer->buffer);
-        layer->buffer.Clear();
+        const int w = layer->buffer.BufferWi;
+        const int h = layer->buffer.BufferHt;
+        const std::vector<xlColor> &orig = SnapshotForRotoZoom(layer);
+        std::vector<xlColor> &pixels = layer->buffer.pixels;
 
         float sine = sin((xrotation + 90) * M_PI / 180);
-        float pivot = xpivot * layer->buffer.BufferWi / 100;
+        float pivot = xpivot * w / 100;
 
-        for (int x = pivot; x < layer->buffer.BufferWi; ++x)
+        // each column lands on one column so columns that land outside are skipped whole
+        for (int x = pivot; x < w; ++x)
         {
             float tox = sine * (x - pivot) + pivot;
-            for (int y = 0; y < layer->buffer.BufferHt; ++y)
+            int tx = tox;
+            if (tx < 0 || tx >= w) continue;
+            for (int y = 0; y < h; ++y)
             {
-                layer->buffer.SetPixel(tox, y, orig.GetPixel(x, y));
+                RotoZoomSet(pixels, w, h, tx, y, RotoZoomSource(orig, w, h, x, y));
             }
         }
 
         for (int x = pivot - 1; x >= 0; --x)
         {
             float tox = -1 * sine * (pivot - x) + pivot;
-            for (int y = 0; y < layer->buffer.BufferHt; ++y)
+            int tx = tox;
+            if (tx < 0 || tx >= w) continue;
+            for (int y = 0; y < h; ++y)
             {
-                layer->buffer.SetPixel(tox, y, orig.GetPixel(x, y));
+                RotoZoomSet(pixels, w, h, tx, y, RotoZoomSource(orig, w, h, x, y));
             }
         }
     }
@@ -2053,27 +2398,33 @@ void PixelBufferClass::RotateY(LayerInfo* layer, float offset)
             ypivot = layer->YPivotValueCurve.GetOutputValueAt(offset, layer->buffer.GetStartTimeMS(), layer->buffer.GetEndTimeMS());
         }
 
-        RenderBuffer orig(layer->buffer);
-        layer->buffer.Clear();
+        const int w = layer->buffer.BufferWi;
+        const int h = layer->buffer.BufferHt;
+        const std::vector<xlColor> &orig = SnapshotForRotoZoom(layer);
+        std::vector<xlColor> &pixels = layer->buffer.pixels;
 
         float sine = sin((yrotation + 90) * M_PI / 180);
-        float pivot = ypivot * layer->buffer.BufferHt / 100;
+        float pivot = ypivot * h / 100;
 
-        for (int y = pivot; y < layer->buffer.BufferHt; ++y)
+        for (int y = pivot; y < h; ++y)
         {
             float toy = sine * (y - pivot) + pivot;
-            for (int x = 0; x < layer->buffer.BufferWi; ++x)
+            int ty = toy;
+            if (ty < 0 || ty >= h) continue;
+            for (int x = 0; x < w; ++x)
             {
-                layer->buffer.SetPixel(x, toy, orig.GetPixel(x, y));
+                RotoZoomSet(pixels, w, h, x, ty, RotoZoomSource(orig, w, h, x, y));
             }
         }
 
         for (int y = pivot - 1; y >= 0; --y)
         {
             float toy = -1 * sine * (pivot - y) + pivot;
-            for (int x = 0; x < layer->buffer.BufferWi; ++x)
+            int ty = toy;
+            if (ty < 0 || ty >= h) continue;
+            for (int x = 0; x < w; ++x)
             {
-                layer->buffer.SetPixel(x, toy, orig.GetPixel(x, y));
+                RotoZoomSet(pixels, w, h, x, ty, RotoZoomSource(orig, w, h, x, y));
             }
         }
     }
@@ -2115,8 +2466,6 @@ void PixelBufferClass::RotateZAndZoom(LayerInfo* layer, float offset)
     if (rotation != 0.0 || zoom != 1.0)
     {
         static const float PI_2 = 6.283185307f;
-        xlColor c;
-        RenderBuffer orig(layer->buffer);
         int q = layer->zoomquality;
         int cx = layer->pivotpointx;
         if (layer->PivotPointXValueCurve.IsActive())
@@ -2136,26 +2485,61 @@ void PixelBufferClass::RotateZAndZoom(LayerInfo* layer, float offset)
         float anglecos = cos(-angle);
         float anglesin = sin(-angle);
 
-        layer->buffer.Clear();
-        for (int x = 0; x < layer->BufferWi; x++)
+        // the rotated position of each sample is the sum of a term from its x and a
+        // term from its y, work those out once for every sample column and row
+        const int bw = layer->BufferWi;
+        const int bh = layer->BufferHt;
+        std::vector<float> ux(bw * q);
+        std::vector<float> vx(bw * q);
+        std::vector<float> uy(bh * q);
+        std::vector<float> vy(bh * q);
+        for (int x = 0; x < bw; x++)
+        {
+            for (int i = 0; i < q; i++)
+            {
+                float xx = (float)x + ((float)i * inc) - xoff;
+                ux[x * q + i] = anglecos * xx * zoom;
+                vx[x * q + i] = -anglesin * xx * zoom;
+            }
+        }
+        for (int y = 0; y < bh; y++)
+        {
+            for (int j = 0; j < q; j++)
+            {
+                float yy = (float)y + ((float)j * inc) - yoff;
+                uy[y * q + j] = anglesin * yy * zoom;
+                vy[y * q + j] = anglecos * yy * zoom;
+            }
+        }
+
+        const int w = layer->buffer.BufferWi;
+        const int h = layer->buffer.BufferHt;
+        const std::vector<xlColor> &orig = SnapshotForRotoZoom(layer);
+        std::vector<xlColor> &pixels = layer->buffer.pixels;
+        for (int x = 0; x < bw; x++)
         {
             for (int i = 0; i < q; i++)
             {
-                for (int y = 0; y < layer->BufferHt; y++)
+                const float ui = xoff + ux[x * q + i];
+                const float vi = yoff + vx[x * q + i];
+                for (int y = 0; y < bh; y++)
                 {
-                    orig.GetPixel(x, y, c);
+                    const xlColor &c = RotoZoomSource(orig, w, h, x, y);
+                    if (c.alpha == 0)
+                    {
+                        // would not be drawn anyway
+                        continue;
+                    }
                     for (int j = 0; j < q; j++)
                     {
-                        float xx = (float)x + ((float)i * inc) - xoff;
-                        float yy = (float)y + ((float)j * inc) - yoff;
-                        float u = xoff + anglecos * xx * zoom + anglesin * yy * zoom;
-                        if (u >= 0 && u < layer->BufferWi)
+                        float u = ui + uy[y * q + j];
+                        if (u >= 0 && u < bw)
                         {
-                            float v = yoff + -anglesin * xx * zoom + anglecos * yy * zoom;
+                            float v = vi + vy[y * q + j];
 
-                            if (v >= 0 && v < layer->BufferHt)
+                            if (v >= 0 && v < bh)
                             {
-                                layer->buffer.SetPixel(u, v, c);
+                                RotoZoomSet(pixels, w, h, u, v, c);
                             }
                         }
                     }
@@ -2169,11 +2553,8 @@ void PixelBufferClass::RotoZoom(LayerInfo* layer, float offset)
 {
     if (std::isinf(offset)) offset = 1.0;
 
-    wxArrayString order = wxSplit(layer->rotationorder, ',');
-
-    for (auto it = order.begin(); it != order.end(); ++it)
+    for (char c : layer->rotationAxes)
     {
-        char c = it->Trim(false).ToStdString()[0];
         switch(c)
         {
         case 'X':
@@ -2191,8 +2572,7 @@ void PixelBufferClass::RotoZoom(LayerInfo* layer, float offset)
 
 bool PixelBufferClass::IsVariableSubBuffer(int layer) const
 {
-    const std::string &subBuffer = layers[layer]->subBuffer;
-    return subBuffer.find("Active=TRUE") != std::string::npos;
+    return layers[layer]->variableSubBuffer;
 }
     
 MixTypes PixelBufferClass::GetMixType(int layer) const
@@ -2209,26 +2589,41 @@ void PixelBufferClass::PrepareVariableSubBuffer(int EffectPeriod, int layer)
 {
     if (!IsVariableSubBuffer(layer)) return;
 
-    const std::string &subBuffer = layers[layer]->subBuffer;
+    LayerInfo *inf = layers[layer];
 
     int effStartPer, effEndPer;
-    layers[layer]->buffer.GetEffectPeriods(effStartPer, effEndPer);
+    inf->buffer.GetEffectPeriods(effStartPer, effEndPer);
     float offset = 0.0;
     if (effEndPer != effStartPer) {
         offset = ((float)EffectPeriod - (float)effStartPer) / ((float)effEndPer - (float)effStartPer);
     }
     offset = std::min(offset, 1.0f);
-    const std::string &type = layers[layer]->type;
-    const std::string &camera = layers[layer]->camera;
-    const std::string &transform = layers[layer]->transform;
-    layers[layer]->buffer.Nodes.clear();
-    model->InitRenderBufferNodes(type, camera, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
-    ComputeSubBuffer(subBuffer, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt, offset, layers[layer]->buffer.GetStartTimeMS(), layers[layer]->buffer.GetEndTimeMS());
-    layers[layer]->buffer.BufferWi = layers[layer]->BufferWi;
-    layers[layer]->buffer.BufferHt = layers[layer]->BufferHt;
-    
-    if (layers[layer]->buffer.BufferWi == 0) layers[layer]->buffer.BufferWi = 1;
-    if (layers[layer]->buffer.BufferHt == 0) layers[layer]->buffer.BufferHt = 1;
+
+    // the nodes only need to be created once per settings change, after that moving the
+    // sub buffer is just a shift of the node coordinates
+    bool changed = false;
+    if (!inf->subBufferNodesValid) {
+        inf->buffer.Nodes.clear();
+        model->InitRenderBufferNodesCached(inf->type, inf->camera, inf->transform, inf->buffer.Nodes, inf->subBufferModelWi, inf->subBufferModelHt);
+        inf->subBufferX1 = inf->subBufferY1 = 0;
+        inf->subBufferNodesValid = true;
+        changed = true;
+    }
+
+    int x1, y1, x2, y2;
+    inf->subBufferSpec.GetRect(inf->subBufferModelWi, inf->subBufferModelHt, offset, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS(), x1, y1, x2, y2);
+    if (changed || x1 != inf->subBufferX1 || y1 != inf->subBufferY1 || x2 != inf->subBufferX2 || y2 != inf->subBufferY2) {
+        OffsetNodes(inf->buffer.Nodes, x1 - inf->subBufferX1, y1 - inf->subBufferY1);
+        inf->subBufferX1 = x1;
+        inf->subBufferY1 = y1;
+        inf->subBufferX2 = x2;
+        inf->subBufferY2 = y2;
+        inf->BufferWi = std::max(x2 - x1, 1);
+        inf->BufferHt = std::max(y2 - y1, 1);
+        inf->buffer.nodeTable.Build(inf->buffer.Nodes);
+    }
+    inf->buffer.BufferWi = inf->BufferWi;
+    inf->buffer.BufferHt = inf->BufferHt;
 }
 
 void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & validLayers, int saveLayer)
@@ -2247,11 +2642,14 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
         offset = std::min(offset, 1.0f);
 
         // do gausian blur
-        if (layers[layer]->BlurValueCurve.IsActive() || layers[layer]->blur > 1)
+        if ((layers[layer]->activeValueCurves & LayerInfo::VC_BLUR) || layers[layer]->blur > 1)
         {
             Blur(layers[layer], offset);
         }
-        RotoZoom(layers[layer], offset);
+        if (layers[layer]->needsRotoZoom)
+        {
+            RotoZoom(layers[layer], offset);
+        }
     }
 
     for(int ii=0; ii < numLayers; ii++)
@@ -2259,9 +2657,9 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
         if (layers[ii]->use_music_sparkle_count &&
             layers[ii]->buffer.GetMedia() != nullptr) {
             float f = 0.0;
-            std::list<float>* pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->begin();
+            FrameDataView pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty()) {
+                f = pf.front();
             }
             layers[ii]->music_sparkle_count_factor = f;
         } else {
@@ -2290,14 +2688,14 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
                 fadeOutFactor = 1-(double)curStep/(double)layers[ii]->fadeOutSteps;
             }
             //calc fades
-            if (STR_FADE == layers[ii]->inTransitionType) {
+            if (layers[ii]->inTransition == Transition_Fade) {
                 if (fadeInFactor<1) {
                     layers[ii]->fadeFactor = fadeInFactor;
                 }
             } else {
                 layers[ii]->inMaskFactor = fadeInFactor;
             }
-            if (STR_FOLD == layers[ii]->inTransitionType && EffectPeriod < effStartPer + layers[ii]->fadeInSteps )
+            if (layers[ii]->inTransition == Transition_Fold && EffectPeriod < effStartPer + layers[ii]->fadeInSteps )
             {
                RenderBuffer& currentRB(layers[ii]->buffer);
                const RenderBuffer *prevRB = nullptr;
@@ -2308,9 +2706,9 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
                foldIn( currentRB, ColorBuffer( currentRB.pixels, currentRB.BufferWi, currentRB.BufferHt ), prevRB, progress );
             }
 
-            if (STR_FADE == layers[ii]->outTransitionType) {
+            if (layers[ii]->outTransition == Transition_Fade) {
                 if (fadeOutFactor<1) {
-                    if (STR_FADE == layers[ii]->inTransitionType
+                    if (layers[ii]->inTransition == Transition_Fade
                         && fadeInFactor<1) {
                         layers[ii]->fadeFactor = (fadeInFactor+fadeOutFactor)/(double)2.0;
                     } else {
@@ -2320,7 +2718,7 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
             } else {
                 layers[ii]->outMaskFactor = fadeOutFactor;
             }
-            if (STR_FOLD == layers[ii]->outTransitionType )
+            if (layers[ii]->outTransition == Transition_Fold)
             {
                if ( EffectPeriod >= effEndPer - layers[ii]->fadeOutSteps )
                {
@@ -2341,7 +2739,7 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
     }
 
     // layer calculation and map to output
-    size_t NodeCount = layers[0]->buffer.Nodes.size();
+    size_t NodeCount = layers[0]->buffer.nodeTable.size();
     int countValid = 0;
     for (auto x : validLayers) {
         if (x) {
@@ -2377,64 +2775,105 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
     }
     */
     
-    parallel_for(0, NodeCount, [this, saveLayer, &validLayers, EffectPeriod] (int i) {
-        if (!layers[saveLayer]->buffer.Nodes[i]->IsVisible()) {
-            // unmapped pixel - set to black
-            layers[saveLayer]->buffer.Nodes[i]->SetColor(xlBLACK);
-        } else {
-            // get blend of two effects
-            xlColor color;
-            GetMixedColor(i,
-                          color,
-                          validLayers, EffectPeriod);
+    for (int layer = 0; layer < numLayers; layer++) {
+        if (validLayers[layer]) {
+            PrepareMixSpan(layers[layer]);
+        }
+    }
 
-            // set color for physical output
-            layers[saveLayer]->buffer.Nodes[i]->SetColor(color);
+    parallel_for_range(0, NodeCount, [this, saveLayer, &validLayers, EffectPeriod] (int start, int end) {
+        static const int MIX_SPAN = 1024;
+        xlColor colors[MIX_SPAN];
+        NodeTable &nodeTable = layers[saveLayer]->buffer.nodeTable;
+        end = std::min(end, (int)nodeTable.size());
+        for (int s = start; s < end; s += MIX_SPAN) {
+            int e = std::min(s + MIX_SPAN, end);
+            // get blend of the effects
+            GetMixedColors(s, e, colors, validLayers, EffectPeriod);
+            for (int i = s; i < e; i++) {
+                if (!nodeTable.IsVisible(i)) {
+                    // unmapped pixel - set to black
+                    nodeTable.SetColor(i, xlBLACK);
+                } else {
+                    // set color for physical output
+                    nodeTable.SetColor(i, colors[i - s]);
+                }
+            }
         }
     }, blockSize);
 }
 
-static int DecodeType(const std::string &type)
+static TransitionTypes DecodeTransitionType(const std::string &type)
 {
-    if (type == "Wipe")
-    {
-        return 1;
-    }
-    else if (type == "Clock")
-    {
-        return 2;
-    }
-    else if (type == "From Middle")
-    {
-        return 3;
-    }
-    else if (type == "Square Explode")
-    {
-        return 4;
-    }
-    else if (type == "Circle Explode")
-    {
-        return 5;
-    }
-    else if (type == "Blinds")
-    {
-        return 6;
-    }
-    else if (type == "Blend")
-    {
-        return 7;
-    }
-    else if (type == "Slide Checks")
-    {
-        return 8;
-    }
-    else if (type == "Slide Bars")
-    {
-        return 9;
-    }
-
-    return 0;
+    static const std::map<std::string, TransitionTypes> types = {
+        {"Fade", Transition_Fade},
+        {"Fold", Transition_Fold},
+        {"Wipe", Transition_Wipe},
+        {"Clock", Transition_Clock},
+        {"From Middle", Transition_FromMiddle},
+        {"Square Explode", Transition_SquareExplode},
+        {"Circle Explode", Transition_CircleExplode},
+        {"Blinds", Transition_Blinds},
+        {"Blend", Transition_Blend},
+        {"Slide Checks", Transition_SlideChecks},
+        {"Slide Bars", Transition_SlideBars}
+    };
+    auto it = types.find(type);
+    if (it == types.end()) {
+        return Transition_Unknown;
+    }
+    return it->second;
+}
+
+// Turn the string settings that CalcOutput and friends need every frame into
+// enums and flags.  Called whenever the layer settings change.
+void PixelBufferClass::LayerInfo::DecodeSettings() {
+    inTransition = DecodeTransitionType(inTransitionType);
+    outTransition = DecodeTransitionType(outTransitionType);
+
+    rotationAxes.clear();
+    wxArrayString order = wxSplit(rotationorder, ',');
+    for (auto it = order.begin(); it != order.end(); ++it) {
+        std::string axis = it->Trim(false).ToStdString();
+        if (!axis.empty() && (axis[0] == 'X' || axis[0] == 'Y' || axis[0] == 'Z')) {
+            rotationAxes += axis[0];
+        }
+    }
+
+    activeValueCurves = 0;
+    const std::pair<const ValueCurve*, int> curves[] = {
+        {&BlurValueCurve, VC_BLUR},
+        {&SparklesValueCurve, VC_SPARKLES},
+        {&BrightnessValueCurve, VC_BRIGHTNESS},
+        {&HueAdjustValueCurve, VC_HUEADJUST},
+        {&SaturationAdjustValueCurve, VC_SATURATIONADJUST},
+        {&ValueAdjustValueCurve, VC_VALUEADJUST},
+        {&RotationValueCurve, VC_ROTATION},
+        {&XRotationValueCurve, VC_XROTATION},
+        {&YRotationValueCurve, VC_YROTATION},
+        {&ZoomValueCurve, VC_ZOOM},
+        {&RotationsValueCurve, VC_ROTATIONS},
+        {&PivotPointXValueCurve, VC_PIVOTPOINTX},
+        {&PivotPointYValueCurve, VC_PIVOTPOINTY},
+        {&XPivotValueCurve, VC_XPIVOT},
+        {&YPivotValueCurve, VC_YPIVOT}
+    };
+    for (auto &vc : curves) {
+        if (vc.first->IsActive()) {
+            activeValueCurves |= vc.second;
+        }
+    }
+
+    // RotateX/RotateY/RotateZAndZoom are all no-ops unless one of these is set
+    needsRotoZoom = (activeValueCurves & VC_ROTOZOOM) != 0
+        || (xrotation != 0 && xrotation != 360)
+        || (yrotation != 0 && yrotation != 360)
+        || rotation != 0
+        || zoom != 1.0f;
+
+    variableSubBuffer = subBuffer.find("Active=TRUE") != std::string::npos;
 }
+
 void PixelBufferClass::LayerInfo::clear() {
     buffer.Clear();
     if (usingModelBuffers) {
@@ -2898,12 +3337,12 @@ void PixelBufferClass::LayerInfo::calculateMask(bool isFirstFrame) {
     bool hasMask = false;
     if (inMaskFactor < 1.0) {
         mask.resize(BufferHt * BufferWi);
-        calculateMask(inTransitionType, false, isFirstFrame);
+        calculateMask(inTransition, inTransitionType, false, isFirstFrame);
         hasMask = true;
     }
     if (outMaskFactor < 1.0) {
         mask.resize(BufferHt * BufferWi);
-        calculateMask(outTransitionType, true, isFirstFrame);
+        calculateMask(outTransition, outTransitionType, true, isFirstFrame);
         hasMask = true;
     }
     if (!hasMask) {
@@ -2911,40 +3350,40 @@ void PixelBufferClass::LayerInfo::calculateMask(bool isFirstFrame) {
     }
 }
 
-void PixelBufferClass::LayerInfo::calculateMask(const std::string &type, bool mode, bool isFirstFrame) {
+void PixelBufferClass::LayerInfo::calculateMask(TransitionTypes type, const std::string &typeName, bool mode, bool isFirstFrame) {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    switch (DecodeType(type)) {
-        case 1:
+    switch (type) {
+        case Transition_Wipe:
             createWipeMask(mode);
             break;
-        case 2:
+        case Transition_Clock:
             createClockMask(mode);
             break;
-        case 3:
+        case Transition_FromMiddle:
             createFromMiddleMask(mode);
             break;
-        case 4:
+        case Transition_SquareExplode:
             createSquareExplodeMask(mode);
             break;
-        case 5:
+        case Transition_CircleExplode:
             createCircleExplodeMask(mode);
             break;
-        case 6:
+        case Transition_Blinds:
             createBlindsMask(mode);
             break;
-        case 7:
+        case Transition_Blend:
             createBlendMask(mode);
             break;
-        case 8:
+        case Transition_SlideChecks:
             createSlideChecksMask(mode);
             break;
-        case 9:
+        case Transition_SlideBars:
             createSlideBarsMask(mode);
             break;
         default:
             if (isFirstFrame)
             {
-                logger_base.warn("Unrecognised transition type '%s'.", (const char *)type.c_str());
+                logger_base.warn("Unrecognised transition type '%s'.", (const char *)typeName.c_str());
             }
             break;
     }
@@ -84,6 +84,65 @@ enum MixTypes
     Mix_Min
 };
 
+/**
+ * \brief layer in/out transitions, decoded from the transition choice once per settings change
+ */
+enum TransitionTypes
+{
+    Transition_Unknown,
+    Transition_Fade,
+    Transition_Fold,
+    Transition_Wipe,
+    Transition_Clock,
+    Transition_FromMiddle,
+    Transition_SquareExplode,
+    Transition_CircleExplode,
+    Transition_Blinds,
+    Transition_Blend,
+    Transition_SlideChecks,
+    Transition_SlideBars
+};
+
+/**
+ * \brief per layer values the span mixing kernels need, resolved once per frame
+ */
+struct MixSpanParams
+{
+    float fadeFactor;     /**< layer fade in/out factor */
+    float threshold;      /**< effect mix threshold, clamped to >= 0 */
+    int thresholdLevel;   /**< smallest max(r,g,b) whose HSV value is above threshold */
+    uint8_t alpha[256];   /**< Mix_Normal alpha after applying fade and threshold */
+};
+
+/**
+ * \brief mixes count foreground colors onto the background colors, bg receives the result
+ */
+typedef void (*MixSpanFunction)(xlColor *fg, xlColor *bg, int count, const MixSpanParams &params);
+
+/**
+ * \brief CUSTOM_SubBuffer parsed once per settings change, each edge (x1, y1, x2, y2) is a
+ * percentage of the model buffer that is either fixed or comes from a value curve
+ */
+class SubBufferSpec
+{
+public:
+    SubBufferSpec() { Parse(""); }
+    void Parse(const std::string &subBuffer);
+    bool IsEmpty() const { return _empty; }
+    bool IsVariable() const { return _hasCurve[0] || _hasCurve[1] || _hasCurve[2] || _hasCurve[3]; }
+    bool HasCurve(int edge) const { return _hasCurve[edge]; }
+    float GetEdge(int edge, float progress, long startMS, long endMS);
+    void Bake(long startMS, long endMS, int frames);
+    // the sub buffer at progress rounded to whole pixels of a bufferWi x bufferHi buffer
+    void GetRect(int bufferWi, int bufferHi, float progress, long startMS, long endMS, int &x1, int &y1, int &x2, int &y2);
+
+private:
+    bool _empty;
+    float _value[4];
+    bool _hasCurve[4];
+    ValueCurve _curve[4];
+};
+
 class Effect;
 class SequenceElements;
 class SettingsMap;
@@ -132,12 +191,44 @@ private:
             fadeInSteps = fadeOutSteps = 0;
             inTransitionAdjust = outTransitionAdjust = 0;
             inTransitionReverse = outTransitionReverse = false;
+            mixSpan = nullptr;
+            inTransition = outTransition = Transition_Fade;
+            rotationAxes = "XYZ";
+            activeValueCurves = 0;
+            needsRotoZoom = false;
+            variableSubBuffer = false;
+            subBufferNodesValid = false;
+            subBufferX1 = subBufferY1 = subBufferX2 = subBufferY2 = 0;
+            subBufferModelWi = subBufferModelHt = 0;
         }
+
+        // bits for activeValueCurves
+        enum {
+            VC_BLUR = 0x0001,
+            VC_SPARKLES = 0x0002,
+            VC_BRIGHTNESS = 0x0004,
+            VC_HUEADJUST = 0x0008,
+            VC_SATURATIONADJUST = 0x0010,
+            VC_VALUEADJUST = 0x0020,
+            VC_ROTATION = 0x0040,
+            VC_XROTATION = 0x0080,
+            VC_YROTATION = 0x0100,
+            VC_ZOOM = 0x0200,
+            VC_ROTATIONS = 0x0400,
+            VC_PIVOTPOINTX = 0x0800,
+            VC_PIVOTPOINTY = 0x1000,
+            VC_XPIVOT = 0x2000,
+            VC_YPIVOT = 0x4000,
+            VC_ROTOZOOM = VC_ROTATION | VC_XROTATION | VC_YROTATION | VC_ZOOM | VC_ROTATIONS
+                | VC_PIVOTPOINTX | VC_PIVOTPOINTY | VC_XPIVOT | VC_YPIVOT
+        };
         RenderBuffer buffer;
+        std::vector<xlColor> rotoZoomPixels; // copy of the buffer that RotoZoom draws from
         std::string bufferType;
         std::string camera;
         std::string bufferTransform;
         std::string subBuffer;
+        SubBufferSpec subBufferSpec;
         std::string blurValueCurve;
         std::string sparklesValueCurve;
         std::string brightnessValueCurve;
@@ -195,6 +286,8 @@ private:
         int contrast;
         double fadeFactor;
         MixTypes mixType;
+        MixSpanFunction mixSpan;
+        MixSpanParams mixParams;
         float effectMixThreshold;
         bool effectMixVaries;
         bool canvas;
@@ -203,6 +296,19 @@ private:
         int fadeOutSteps;
         std::string inTransitionType;
         std::string outTransitionType;
+        TransitionTypes inTransition;
+        TransitionTypes outTransition;
+        std::string rotationAxes;  // rotationorder decoded to the axis letters, eg "XYZ"
+        int activeValueCurves;     // VC_* bits for the value curves that are active
+        bool needsRotoZoom;
+        bool variableSubBuffer;
+        bool subBufferNodesValid;  // buffer.Nodes came from PrepareVariableSubBuffer and are offset by subBufferX1/Y1
+        int subBufferX1;
+        int subBufferY1;
+        int subBufferX2;
+        int subBufferY2;
+        int subBufferModelWi;      // size of the buffer the variable sub buffer is cut from
+        int subBufferModelHt;
         std::string type;
         std::string transform;
         int inTransitionAdjust;
@@ -216,7 +322,8 @@ private:
 
         std::vector<uint8_t> mask;
         void calculateMask(bool isFirstFrame);
-        void calculateMask(const std::string &type, bool mode, bool isFirstFrame);
+        void calculateMask(TransitionTypes type, const std::string &typeName, bool mode, bool isFirstFrame);
+        void DecodeSettings();
         bool isMasked(int x, int y);
         
         void clear();
@@ -241,13 +348,15 @@ private:
 
     //both fg and bg may be modified, bg will contain the new, mixed color to be the bg for the next mix
     void mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer);
+    void PrepareMixSpan(LayerInfo* layer);
+    void MixSpan(const int *x, const int *y, xlColor *fg, xlColor *bg, int count, int layer);
     void reset(int layers, int timing, bool isNode = false);
 	void Blur(LayerInfo* layer, float offset);
     void RotoZoom(LayerInfo* layer, float offset);
     void RotateX(LayerInfo* layer, float offset);
     void RotateY(LayerInfo* layer, float offset);
     void RotateZAndZoom(LayerInfo* layer, float offset);
-    void GetMixedColor(int node, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod);
+    void GetMixedColors(int start, int end, xlColor *colors, const std::vector<bool> & validLayers, int EffectPeriod);
 
     std::string modelName;
     std::string lastBufferType;
@@ -293,6 +402,7 @@ public:
     
     void SetLayerSettings(int layer, const SettingsMap &settings);
     bool IsPersistent(int layer);
+    bool HasSparkles(int layer) const;
     
     void SetMixType(int layer, const std::string& MixName);
     void SetPalette(int layer, xlColorVector& newcolors, xlColorCurveVector& newcc);
@@ -20,6 +20,14 @@
 
 #define END_OF_RENDER_FRAME INT_MAX
 
+// Runs of frames where all of a model's effects can be rendered out of order
+// are split into slices rendered in parallel on separate pixel buffers.
+// Models smaller than this aren't worth the extra buffers.
+#define PARTIAL_RENDER_MIN_NODES 1000
+// fewest frames per slice
+#define PARTIAL_RENDER_MIN_FRAMES 20
+#define PARTIAL_RENDER_MAX_SLICES 4
+
 //other common strings
 static const std::string STR_EMPTY("");
 
@@ -78,6 +86,7 @@ public:
 
     NextRenderer() : nextLock(), nextSignal() {
         previousFrameDone = -1;
+        upstreamCriticalPathMS = 0;
     }
 
     virtual ~NextRenderer() {}
@@ -97,21 +106,22 @@ public:
 
     void FrameDone(int frame) {
         for (auto i = next.begin(); i < next.end(); ++i) {
-            (*i)->setPreviousFrameDone(frame);
+            (*i)->setPreviousFrameDone(frame, this);
         }
     }
 
-    virtual void setPreviousFrameDone(int i) {
+    virtual void setPreviousFrameDone(int i, NextRenderer *from = nullptr) {
         std::unique_lock<std::mutex> lock(nextLock);
+        if (i == END_OF_RENDER_FRAME && from != nullptr) {
+            upstreamCriticalPathMS = std::max(upstreamCriticalPathMS, from->GetCriticalPathMS());
+        }
         previousFrameDone = i;
         nextSignal.notify_all();
     }
 
     int waitForFrame(int frame) {
         std::unique_lock<std::mutex> lock(nextLock);
-        while (frame > previousFrameDone) {
-            nextSignal.wait_for(lock, std::chrono::milliseconds(10));
-        }
+        nextSignal.wait(lock, [this, frame] { return frame <= previousFrameDone; });
         return previousFrameDone;
     }
 
@@ -125,63 +135,70 @@ public:
         return previousFrameDone;
     }
 
+    // longest chain of rendering time (ms) leading up to and including this renderer
+    virtual long GetCriticalPathMS() const
+    {
+        return upstreamCriticalPathMS;
+    }
+
 protected:
     std::mutex nextLock;
     std::condition_variable nextSignal;
     volatile long previousFrameDone;
+    long upstreamCriticalPathMS;
 private:
     std::vector<NextRenderer *> next;
 };
 
+// Joins the frame progress of all the renderers that share channels with a
+// model and passes the lowest frame they have all completed on to that model.
 class AggregatorRenderer: public NextRenderer {
 public:
 
-    AggregatorRenderer(int numFrames) : NextRenderer(), finalFrame(numFrames + 19) {
-        data = new int[numFrames + 20];
-        for (int x = 0; x < (numFrames + 20); ++x) {
-            data[x] = 0;
-        }
-        max = 0;
+    AggregatorRenderer(int numFrames) : NextRenderer() {
     }
 
     virtual ~AggregatorRenderer() {
-        delete [] data;
     }
 
-    void incNumAggregated() {
-        ++max;
+    void addUpstream(NextRenderer *r) {
+        upstream.push_back(r);
+        upstreamFrame.push_back(-1);
     }
 
     int getNumAggregated() const
     {
-        return max;
+        return (int)upstream.size();
     }
 
-    virtual void setPreviousFrameDone(int frame) {
-        if (max <= 1) {
+    virtual void setPreviousFrameDone(int frame, NextRenderer *from = nullptr) override {
+        if (upstream.size() <= 1) {
+            if (frame == END_OF_RENDER_FRAME && from != nullptr) {
+                upstreamCriticalPathMS = from->GetCriticalPathMS();
+            }
             FrameDone(frame);
             return;
         }
-        int idx = frame;
-        if (idx == END_OF_RENDER_FRAME) {
-            idx = finalFrame;
-        }
-        if (idx % 10 == 0 || idx == finalFrame) {
-            //only record every 10th frame and the final frame to
-            //avoid a lot of lock contention
-            std::unique_lock<std::mutex> lock(nextLock);
-            ++data[idx];
-            if (data[idx] == max) {
-                previousFrameDone = frame;
-                FrameDone(previousFrameDone);
+        std::unique_lock<std::mutex> lock(nextLock);
+        int minFrame = END_OF_RENDER_FRAME;
+        for (size_t x = 0; x < upstream.size(); ++x) {
+            if (upstream[x] == from) {
+                upstreamFrame[x] = frame;
+                if (frame == END_OF_RENDER_FRAME) {
+                    upstreamCriticalPathMS = std::max(upstreamCriticalPathMS, from->GetCriticalPathMS());
+                }
             }
+            minFrame = std::min(minFrame, upstreamFrame[x]);
+        }
+        if (minFrame > previousFrameDone) {
+            previousFrameDone = minFrame;
+            FrameDone(minFrame);
         }
     }
 
 private:
-    int *data;
-    int max;
-    const int finalFrame;
+    std::vector<NextRenderer *> upstream;
+    std::vector<int> upstreamFrame;
 };
 
 class SNPair {
@@ -214,7 +231,7 @@ public:
     RenderJob(ModelElement *row, SequenceData &data, xLightsFrame *xframe, bool zeroBased = false)
         : Job(), NextRenderer(), rowToRender(row), seqData(&data), xLights(xframe),
             gauge(nullptr), currentFrame(0), renderLog(log4cpp::Category::getInstance(std::string("log_render"))),
-            supportsModelBlending(false), abort(false), statusMap(nullptr)
+            supportsModelBlending(false), abort(false), renderTimeMS(0), statusMap(nullptr), zeroBased(zeroBased)
     {
         name = "";
         if (row != nullptr) {
@@ -494,7 +511,12 @@ public:
         supportsModelBlending = true;
     }
 
-    bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false) {
+    virtual long GetCriticalPathMS() const override
+    {
+        return upstreamCriticalPathMS + renderTimeMS;
+    }
+
+    bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false, bool updateStatus = true) {
 
         wxStopWatch sw;
         bool effectsToUpdate = false;
@@ -512,9 +534,12 @@ public:
             Effect *ef = findEffectForFrame(elayer, frame, info.currentEffectIdxs[layer]);
             if (ef != info.currentEffects[layer]) {
                 info.currentEffects[layer] = ef;
-                SetInializingStatus(frame, layer, strand);
+                if (updateStatus) {
+                    SetInializingStatus(frame, layer, strand);
+                }
                 initialize(layer, frame, ef, info.settingsMaps[layer], buffer);
                 info.effectStates[layer] = true;
+                prefetchNextEffect(elayer, frame, info.currentEffectIdxs[layer]);
             }
 
             if (buffer->IsVariableSubBuffer(layer))
@@ -526,7 +551,9 @@ public:
             if (!persist || info.currentEffects[layer] == nullptr || info.currentEffects[layer]->GetEffectIndex() == -1) {
                 buffer->Clear(layer);
             }
-            SetRenderingStatus(frame, &info.settingsMaps[layer], layer, strand, -1, true);
+            if (updateStatus) {
+                SetRenderingStatus(frame, &info.settingsMaps[layer], layer, strand, -1, true);
+            }
             bool b = info.effectStates[layer];
 
             // Mix canvas pre-loads the buffer with data from underlying layers
@@ -583,7 +610,9 @@ public:
         }
 
         if (effectsToUpdate) {
-            SetCalOutputStatus(frame, strand);
+            if (updateStatus) {
+                SetCalOutputStatus(frame, strand);
+            }
             if (blend) {
                 buffer->SetColors(numLayers, &((*seqData)[frame][0]));
                 info.validLayers[numLayers] = true;
@@ -605,6 +634,9 @@ public:
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
         SetGenericStatus("Initializing rendering thread for %s", 0);
+        wxStopWatch totalTimer;
+        long waitTime = 0;
+        renderTimeMS = 0;
         int maxFrameBeforeCheck = -1;
         int origChangeCount;
         int ss, es;
@@ -650,12 +682,19 @@ public:
                 EffectLayer *elayer = rowToRender->GetEffectLayer(layer);
                 std::unique_lock<std::recursive_mutex> elock(elayer->GetLock());
                 mainModelInfo.currentEffects[layer] = findEffectForFrame(elayer, startFrame, mainModelInfo.currentEffectIdxs[layer]);
+                if (mainModelInfo.currentEffects[layer] != nullptr) {
+                    mainModelInfo.currentEffects[layer]->PrefetchCache(xLights->GetRenderCache());
+                }
                 msg = wxString::Format("Initializing starting effect for %s, layer %d and startFrame %d", name, layer, startFrame) + PrintStatusMap();
                 SetStatus(msg);
                 initialize(layer, startFrame, mainModelInfo.currentEffects[layer], mainModelInfo.settingsMaps[layer], mainBuffer);
                 mainModelInfo.effectStates[layer] = true;
+                prefetchNextEffect(elayer, startFrame, mainModelInfo.currentEffectIdxs[layer]);
             }
 
+            bool partialRender = !zeroBased && !supportsModelBlending && subModelInfos.empty() && nodeBuffers.empty()
+                && mainBuffer->GetNodeCount() >= PARTIAL_RENDER_MIN_NODES;
+
             for (int frame = startFrame; frame <= endFrame; ++frame) {
                 currentFrame = frame;
                 SetGenericStatus("%s: Starting frame %d " + PrintStatusMap(), frame, true);
@@ -675,12 +714,36 @@ public:
                 if (frame >= maxFrameBeforeCheck) {
                     wxStopWatch sw;
                     maxFrameBeforeCheck = waitForFrame(frame);
+                    waitTime += sw.Time();
 
                     if (sw.Time() > 500)
                     {
                         renderLog.info("Model %s rendering frame %d waited %dms waiting for other models to finish.", (const char *)(mainModelInfo.element != nullptr) ? mainModelInfo.element->GetName().c_str() : "", frame, sw.Time());
                     }
                 }
+                if (partialRender) {
+                    int runEnd = GetPartialRenderEnd(frame, mainModelInfo);
+                    int available = GetPreviousFrameDone();
+                    if (available != END_OF_RENDER_FRAME) {
+                        runEnd = std::min(runEnd, available + 1);
+                    }
+                    int slices = GetPartialRenderSlices(runEnd - frame);
+                    if (slices > 1) {
+                        if (!RenderPartialTimeIntervals(frame, runEnd, slices, mainModelInfo, origChangeCount)) {
+                            if (!abort) {
+                                rowToRender->SetDirtyRange(frame * seqData->FrameTime(), endFrame * seqData->FrameTime());
+                            }
+                            break;
+                        }
+                        frame = runEnd - 1;
+                        currentFrame = frame;
+                        if (HasNext()) {
+                            SetGenericStatus("%s: Notifying next renderer of frame %d done", frame);
+                            FrameDone(frame);
+                        }
+                        continue;
+                    }
+                }
                 bool cleared = ProcessFrame(frame, rowToRender, mainModelInfo, mainBuffer, -1, supportsModelBlending);
                 if (!subModelInfos.empty()) {
                     for (auto a = subModelInfos.begin(); a != subModelInfos.end(); ++a) {
@@ -755,13 +818,19 @@ public:
             //make sure the previous has told us we're at the end.  If we return before waiting, the previous
             //may try sending the END_OF_RENDER_FRAME to us and we'll have been deleted
             SetGenericStatus("%s: Waiting on previous renderer for final frame", 0);
+            wxStopWatch sw;
             waitForFrame(END_OF_RENDER_FRAME);
+            waitTime += sw.Time();
+            renderTimeMS = std::max(0L, totalTimer.Time() - waitTime);
+            LogRenderTimes(totalTimer.Time(), waitTime);
 
             //let the next know we're done
             SetGenericStatus("%s: Notifying next renderer of final frame", 0);
             FrameDone(END_OF_RENDER_FRAME);
             xLights->CallAfter(&xLightsFrame::SetStatusText, wxString("Done Rendering " + rowToRender->GetModelName()), 0);
         } else {
+            renderTimeMS = std::max(0L, totalTimer.Time() - waitTime);
+            LogRenderTimes(totalTimer.Time(), waitTime);
             xLights->CallAfter(&xLightsFrame::RenderDone);
         }
         rowToRender->CleanupAfterRender();
@@ -778,6 +847,115 @@ public:
 
 private:
 
+    bool StopRendering(int origChangeCount) {
+        return abort || (!HasNext() &&
+                         (origChangeCount != rowToRender->getChangeCount()
+                          || rowToRender->GetWaitCount()));
+    }
+
+    // Returns the frame (exclusive) up to which every layer keeps showing the
+    // effect it currently has and all those effects can be rendered out of
+    // order, or frame itself if they can't.  Sparkles count on from frame to
+    // frame so layers using them can't be split either.
+    int GetPartialRenderEnd(int frame, EffectLayerInfo &info) {
+        int frameTime = seqData->FrameTime();
+        int time = frame * frameTime;
+        int end = endFrame + 1;
+        for (int layer = 0; layer < numLayers; ++layer) {
+            EffectLayer *elayer = rowToRender->GetEffectLayer(layer);
+            std::unique_lock<std::recursive_mutex> elayerLock(elayer->GetLock());
+            Effect *ef = findEffectForFrame(elayer, frame, info.currentEffectIdxs[layer]);
+            if (ef != info.currentEffects[layer]) {
+                return frame;
+            }
+            if (ef == nullptr) {
+                // the layer stays empty until the next effect starts
+                for (int e = info.currentEffectIdxs[layer]; e < elayer->GetEffectCount(); ++e) {
+                    int st = elayer->GetEffect(e)->GetStartTimeMS();
+                    if (st > time) {
+                        end = std::min(end, (st + frameTime - 1) / frameTime);
+                        break;
+                    }
+                }
+                continue;
+            }
+            end = std::min(end, (ef->GetEndTimeMS() + frameTime - 1) / frameTime);
+            if (ef->GetEffectIndex() != -1) {
+                RenderableEffect *reff = xLights->GetEffectManager().GetEffect(ef->GetEffectIndex());
+                if (reff == nullptr
+                    || !reff->CanRenderPartialTimeInterval()
+                    || !reff->CanRenderOnBackgroundThread(ef, info.settingsMaps[layer], mainBuffer->BufferForLayer(layer, -1))
+                    || mainBuffer->IsPersistent(layer)
+                    || mainBuffer->HasSparkles(layer)
+                    || mainBuffer->IsCanvasMix(layer)
+                    || mainBuffer->BufferCountForLayer(layer) != 1) {
+                    return frame;
+                }
+            }
+        }
+        return end;
+    }
+
+    // Number of slices worth splitting a run of frames into, creating the
+    // extra pixel buffers needed for them.
+    int GetPartialRenderSlices(int frames) {
+        int slices = std::min(PARTIAL_RENDER_MAX_SLICES, ParallelJobPool::POOL.calcSteps(PARTIAL_RENDER_MIN_FRAMES, frames));
+        while ((int)sliceBuffers.size() < slices - 1) {
+            PixelBufferClass *buffer = new PixelBufferClass(xLights);
+            if (!xLights->InitPixelBuffer(name, *buffer, numLayers, false)) {
+                delete buffer;
+                break;
+            }
+            sliceBuffers.push_back(PixelBufferClassPtr(buffer));
+        }
+        return std::min(slices, (int)sliceBuffers.size() + 1);
+    }
+
+    // Renders frames [start, end) as consecutive slices in parallel.  The first
+    // slice continues on the main buffer, the others start their effects fresh
+    // on their own buffers which is fine as GetPartialRenderEnd has checked
+    // none of them depend on earlier frames.  Returns false if rendering was
+    // stopped part way through.
+    bool RenderPartialTimeIntervals(int start, int end, int slices, EffectLayerInfo &mainInfo, int origChangeCount) {
+        SetGenericStatus("%s: Rendering frames from %d in parallel", start, true);
+        std::atomic_bool stopped(false);
+        std::atomic_int framesDone(0);
+        // the first slice moves mainInfo on while the others start
+        std::vector<int> startIdxs = mainInfo.currentEffectIdxs;
+        parallel_for(0, slices, [this, start, end, slices, &mainInfo, &startIdxs, origChangeCount, &stopped, &framesDone](int slice) {
+            int sliceStart = start + (end - start) * slice / slices;
+            int sliceEnd = start + (end - start) * (slice + 1) / slices;
+            EffectLayerInfo sliceInfo(numLayers);
+            EffectLayerInfo &info = slice == 0 ? mainInfo : sliceInfo;
+            PixelBufferClass *buffer = slice == 0 ? mainBuffer : sliceBuffers[slice - 1].get();
+
+            if (slice != 0) {
+                for (int layer = numLayers - 1; layer >= 0; --layer) {
+                    EffectLayer *elayer = rowToRender->GetEffectLayer(layer);
+                    std::unique_lock<std::recursive_mutex> elock(elayer->GetLock());
+                    info.currentEffectIdxs[layer] = startIdxs[layer];
+                    info.currentEffects[layer] = findEffectForFrame(elayer, sliceStart, info.currentEffectIdxs[layer]);
+                    initialize(layer, sliceStart, info.currentEffects[layer], info.settingsMaps[layer], buffer);
+                    info.effectStates[layer] = true;
+                }
+            }
+            for (int frame = sliceStart; frame < sliceEnd; ++frame) {
+                if (stopped || StopRendering(origChangeCount)) {
+                    stopped = true;
+                    return;
+                }
+                ProcessFrame(frame, rowToRender, info, buffer, -1, false, false);
+                currentFrame = start + framesDone++;
+            }
+        }, 1, 1);
+        return !stopped;
+    }
+
+    void LogRenderTimes(long total, long waited) {
+        renderLog.debug("Model %s frames %d-%d took %ldms, %ldms rendering, %ldms waiting on other models, critical path %ldms.",
+                        (const char *)name.c_str(), startFrame, endFrame, total, (long)renderTimeMS, waited, GetCriticalPathMS());
+    }
+
     void initialize(int layer, int frame, Effect *el, SettingsMap &settingsMap, PixelBufferClass *buffer) {
         if (el == nullptr || el->GetEffectIndex() == -1) {
             settingsMap.clear();
@@ -801,17 +979,40 @@ private:
             return nullptr;
         }
         int time = frame * seqData->FrameTime();
+        // effects deleted from the layer while rendering shift the ones after them down, so
+        // only carry on from the last effect found if it still starts no later than this frame
+        if (lastIdx < 0 || lastIdx >= layer->GetEffectCount() || layer->GetEffect(lastIdx)->GetStartTimeMS() > time) {
+            lastIdx = 0;
+        }
         for (int e = lastIdx; e < layer->GetEffectCount(); ++e) {
             Effect *effect = layer->GetEffect(e);
             int st = effect->GetStartTimeMS();
             int et = effect->GetEndTimeMS();
             if (et > time && st <= time) {
+                // frames only move forward so later searches can start here
+                lastIdx = e;
                 return effect;
             }
         }
         return nullptr;
     }
 
+    // gets the render cache reading the effect that comes after the current one on the layer,
+    // lastIdx is where findEffectForFrame last found an effect on the layer
+    void prefetchNextEffect(EffectLayer* layer, int frame, int lastIdx) {
+        if (layer == nullptr || !xLights->GetRenderCache().IsEnabled()) {
+            return;
+        }
+        int time = frame * seqData->FrameTime();
+        for (int e = lastIdx; e < layer->GetEffectCount(); ++e) {
+            Effect *effect = layer->GetEffect(e);
+            if (effect->GetStartTimeMS() > time) {
+                effect->PrefetchCache(xLights->GetRenderCache());
+                return;
+            }
+        }
+    }
+
     Effect *findEffectForFrame(int layer, int frame, int &lastIdx) {
         return findEffectForFrame(rowToRender->GetEffectLayer(layer), frame, lastIdx);
     }
@@ -849,10 +1050,14 @@ private:
     wxGauge *gauge;
     std::atomic_int currentFrame;
     std::atomic_bool abort;
+    std::atomic_long renderTimeMS;
 
     std::vector<EffectLayerInfo *> subModelInfos;
 
     std::map<SNPair, PixelBufferClassPtr> nodeBuffers;
+
+    bool zeroBased;
+    std::vector<PixelBufferClassPtr> sliceBuffers;
 };
 
 
@@ -1091,6 +1296,7 @@ void xLightsFrame::UpdateRenderStatus() {
 
 void xLightsFrame::RenderDone()
 {
+    _renderCache.LogStats();
     mainSequencer->PanelEffectGrid->Refresh();
 }
 
@@ -1308,7 +1514,7 @@ void xLightsFrame::Render(const std::list<Model*> models,
                                     int idx = *i;
                                     if (idx != row) {
                                         if (jobs[idx]->addNext(aggregators[row])) {
-                                            aggregators[row]->incNumAggregated();
+                                            aggregators[row]->addUpstream(jobs[idx]);
                                         }
                                     }
                                 }
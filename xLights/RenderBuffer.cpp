@@ -22,6 +22,7 @@
 **************************************************************/
 
 #include <cmath>
+#include <algorithm>
 #ifdef _MSC_VER
 	// required so M_PI will be defined by MSC
 	#define _USE_MATH_DEFINES
@@ -82,7 +83,6 @@ private:
 };
 
 static ContextPool<TextDrawingContext> *TEXT_CONTEXT_POOL = nullptr;
-static ContextPool<PathDrawingContext> *PATH_CONTEXT_POOL = nullptr;
 
 void DrawingContext::Initialize(wxWindow *parent) {
     if (TEXT_CONTEXT_POOL == nullptr) {
@@ -104,25 +104,6 @@ void DrawingContext::Initialize(wxWindow *parent) {
             }
         });
     }
-    if (PATH_CONTEXT_POOL == nullptr) {
-        PATH_CONTEXT_POOL = new ContextPool<PathDrawingContext>([parent]() {
-            if (wxThread::IsMain()) {
-                return new PathDrawingContext(10, 10 ,false);
-            } else {
-                std::mutex mtx;
-                std::condition_variable signal;
-                std::unique_lock<std::mutex> lck(mtx);
-                PathDrawingContext *tdc;
-                parent->CallAfter([&mtx, &signal, &tdc]() {
-                    std::unique_lock<std::mutex> lck(mtx);
-                    tdc = new PathDrawingContext(10, 10 ,false);
-                    signal.notify_all();
-                });
-                signal.wait(lck);
-                return tdc;
-            }
-        });
-    }
 }
 
 void DrawingContext::CleanUp() {
@@ -130,23 +111,6 @@ void DrawingContext::CleanUp() {
         delete TEXT_CONTEXT_POOL;
         TEXT_CONTEXT_POOL = nullptr;
     }
-    if (PATH_CONTEXT_POOL != nullptr) {
-        delete PATH_CONTEXT_POOL;
-        PATH_CONTEXT_POOL = nullptr;
-    }
-}
-
-PathDrawingContext* PathDrawingContext::GetContext() {
-    if (PATH_CONTEXT_POOL != nullptr) {
-        return PATH_CONTEXT_POOL->GetContext();
-    }
-    return nullptr;
-}
-
-void PathDrawingContext::ReleaseContext(PathDrawingContext* pdc) {
-    if (PATH_CONTEXT_POOL != nullptr) {
-        return PATH_CONTEXT_POOL->ReleaseContext(pdc);
-    }
 }
 
 TextDrawingContext* TextDrawingContext::GetContext() {
@@ -339,11 +303,6 @@ DrawingContext::~DrawingContext() {
 }
 
 
-PathDrawingContext::PathDrawingContext(int BufferWi, int BufferHt, bool allowShared)
-    : DrawingContext(BufferWi, BufferHt, allowShared, true) {}
-
-PathDrawingContext::~PathDrawingContext() {}
-
 TextDrawingContext::TextDrawingContext(int BufferWi, int BufferHt, bool allowShared)
 #ifdef __WXMSW__
     : DrawingContext(BufferWi, BufferHt, allowShared, false)
@@ -405,31 +364,6 @@ void DrawingContext::Clear() {
     }
 }
 
-void PathDrawingContext::Clear() {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    if (gc != nullptr) {
-        delete gc;
-        gc = nullptr;
-    }
-    DrawingContext::Clear();
-#ifdef LINUX
-    gc = wxGraphicsContext::Create(*image);
-#else
-    gc = wxGraphicsContext::Create(*dc);
-#endif
-
-    if (gc == nullptr)
-    {
-        logger_base.error("PathDrawingContext DC creation failed.");
-        return;
-    }
-
-    gc->SetAntialiasMode(wxANTIALIAS_NONE);
-    gc->SetInterpolationQuality(wxInterpolationQuality::wxINTERPOLATION_FAST);
-    gc->SetCompositionMode(wxCompositionMode::wxCOMPOSITION_SOURCE);
-}
-
 void TextDrawingContext::Clear() {
     if (gc != nullptr) {
         delete gc;
@@ -481,11 +415,6 @@ wxImage *DrawingContext::FlushAndGetImage() {
     return image;
 }
 
-void PathDrawingContext::SetPen(wxPen &pen) {
-    if (gc != nullptr)
-        gc->SetPen(pen);
-}
-
 void TextDrawingContext::SetPen(wxPen &pen) {
     if (gc != nullptr) {
         gc->SetPen(pen);
@@ -494,16 +423,6 @@ void TextDrawingContext::SetPen(wxPen &pen) {
     }
 }
 
-wxGraphicsPath PathDrawingContext::CreatePath()
-{
-    return gc->CreatePath();
-}
-
-void PathDrawingContext::StrokePath(wxGraphicsPath& path)
-{
-    gc->StrokePath(path);
-}
-
 void TextDrawingContext::SetFont(wxFontInfo &font, const xlColor &color) {
     if (gc != nullptr) {
         int style = wxFONTFLAG_NOT_ANTIALIASED;
@@ -631,6 +550,275 @@ void TextDrawingContext::GetTextExtents(const wxString &msg, wxArrayDouble &exte
 }
 
 
+PathRasteriser::SubPath &PathRasteriser::Current() {
+    if (_paths.empty() || _paths.back().closed) {
+        Point start = {0, 0};
+        if (!_paths.empty() && !_paths.back().points.empty()) {
+            start = _paths.back().points.front();
+        }
+        _paths.emplace_back();
+        _paths.back().points.push_back(start);
+    }
+    return _paths.back();
+}
+
+void PathRasteriser::MoveTo(double x, double y) {
+    if (_paths.empty() || _paths.back().closed || _paths.back().points.size() > 1) {
+        _paths.emplace_back();
+    }
+    _paths.back().points.clear();
+    _paths.back().points.push_back({x, y});
+}
+
+void PathRasteriser::LineTo(double x, double y) {
+    Current().points.push_back({x, y});
+}
+
+// curves are flattened to segments no more than about two pixels long
+static int CurveSegments(double length) {
+    return std::max(1, std::min(64, (int)(length / 2.0) + 1));
+}
+
+void PathRasteriser::QuadTo(double cx, double cy, double x, double y) {
+    SubPath &path = Current();
+    Point p0 = path.points.back();
+    int n = CurveSegments(std::hypot(cx - p0.x, cy - p0.y) + std::hypot(x - cx, y - cy));
+    for (int i = 1; i <= n; i++) {
+        double t = (double)i / n;
+        double mt = 1.0 - t;
+        path.points.push_back({mt * mt * p0.x + 2 * mt * t * cx + t * t * x,
+                               mt * mt * p0.y + 2 * mt * t * cy + t * t * y});
+    }
+}
+
+void PathRasteriser::CubicTo(double c1x, double c1y, double c2x, double c2y, double x, double y) {
+    SubPath &path = Current();
+    Point p0 = path.points.back();
+    int n = CurveSegments(std::hypot(c1x - p0.x, c1y - p0.y) + std::hypot(c2x - c1x, c2y - c1y) + std::hypot(x - c2x, y - c2y));
+    for (int i = 1; i <= n; i++) {
+        double t = (double)i / n;
+        double mt = 1.0 - t;
+        double a = mt * mt * mt;
+        double b = 3 * mt * mt * t;
+        double c = 3 * mt * t * t;
+        double d = t * t * t;
+        path.points.push_back({a * p0.x + b * c1x + c * c2x + d * x,
+                               a * p0.y + b * c1y + c * c2y + d * y});
+    }
+}
+
+void PathRasteriser::ArcTo(double xc, double yc, double r, double startAngle, double endAngle) {
+    double sx = xc + r * std::cos(startAngle);
+    double sy = yc + r * std::sin(startAngle);
+    if (_paths.empty() || _paths.back().closed) {
+        MoveTo(sx, sy);
+    } else {
+        LineTo(sx, sy);
+    }
+    SubPath &path = _paths.back();
+    int n = CurveSegments(std::abs(endAngle - startAngle) * r);
+    for (int i = 1; i <= n; i++) {
+        double a = startAngle + (endAngle - startAngle) * i / n;
+        path.points.push_back({xc + r * std::cos(a), yc + r * std::sin(a)});
+    }
+}
+
+void PathRasteriser::AddCircle(double xc, double yc, double r) {
+    MoveTo(xc + r, yc);
+    ArcTo(xc, yc, r, 0, 2.0 * M_PI);
+    Close();
+}
+
+void PathRasteriser::Close() {
+    if (!_paths.empty()) {
+        _paths.back().closed = true;
+    }
+}
+
+// everything is wound the same way so overlapping polygons add up rather than cancel out
+void PathRasteriser::AddPolygon(std::vector<std::vector<Point>> &polygons, std::vector<Point> &&polygon) {
+    double area = 0;
+    for (size_t i = 0; i < polygon.size(); i++) {
+        const Point &a = polygon[i];
+        const Point &b = polygon[(i + 1) % polygon.size()];
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area < 0) {
+        std::reverse(polygon.begin(), polygon.end());
+    }
+    polygons.push_back(std::move(polygon));
+}
+
+void PathRasteriser::AddCircle(std::vector<std::vector<Point>> &polygons, double xc, double yc, double r) {
+    int n = std::max(8, std::min(32, (int)(r * 4)));
+    std::vector<Point> circle(n);
+    for (int i = 0; i < n; i++) {
+        double a = 2.0 * M_PI * i / n;
+        circle[i] = {xc + r * std::cos(a), yc + r * std::sin(a)};
+    }
+    AddPolygon(polygons, std::move(circle));
+}
+
+void PathRasteriser::Fill(RenderBuffer &buffer, const xlColor &color) const {
+    std::vector<std::vector<Point>> polygons;
+    for (const auto &path : _paths) {
+        if (path.points.size() > 2) {
+            polygons.push_back(path.points);
+        }
+    }
+    Rasterise(buffer, polygons, color);
+}
+
+void PathRasteriser::Stroke(RenderBuffer &buffer, const xlColor &color, double width) const {
+    double hw = width / 2.0;
+    std::vector<std::vector<Point>> polygons;
+    for (const auto &path : _paths) {
+        const std::vector<Point> &pts = path.points;
+        size_t segments = path.closed ? pts.size() : pts.size() - 1;
+        for (size_t i = 0; i < pts.size(); i++) {
+            AddCircle(polygons, pts[i].x, pts[i].y, hw);
+        }
+        for (size_t i = 0; i < segments && pts.size() > 1; i++) {
+            const Point &a = pts[i];
+            const Point &b = pts[(i + 1) % pts.size()];
+            double len = std::hypot(b.x - a.x, b.y - a.y);
+            if (len == 0) {
+                continue;
+            }
+            double nx = -(b.y - a.y) / len * hw;
+            double ny = (b.x - a.x) / len * hw;
+            AddPolygon(polygons, { {a.x + nx, a.y + ny}, {b.x + nx, b.y + ny}, {b.x - nx, b.y - ny}, {a.x - nx, a.y - ny} });
+        }
+    }
+    Rasterise(buffer, polygons, color);
+}
+
+// Coverage is accumulated a row at a time from 4 sub scanlines, with exact coverage across
+// each span.  Without anti aliasing a pixel is in when its centre is.
+void PathRasteriser::Rasterise(RenderBuffer &buffer, const std::vector<std::vector<Point>> &polygons, const xlColor &color) const {
+    struct Edge {
+        double y0;
+        double y1;
+        double x0;
+        double dxdy;
+        int dir;
+    };
+    std::vector<Edge> edges;
+    for (const auto &poly : polygons) {
+        for (size_t i = 0; i < poly.size(); i++) {
+            const Point &a = poly[i];
+            const Point &b = poly[(i + 1) % poly.size()];
+            if (a.y == b.y) {
+                continue;
+            }
+            if (a.y < b.y) {
+                edges.push_back({a.y, b.y, a.x, (b.x - a.x) / (b.y - a.y), 1});
+            } else {
+                edges.push_back({b.y, a.y, b.x, (a.x - b.x) / (a.y - b.y), -1});
+            }
+        }
+    }
+    if (edges.empty() || buffer.BufferWi <= 0 || buffer.BufferHt <= 0) {
+        return;
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.y0 < b.y0; });
+
+    double maxY = 0;
+    for (const auto &e : edges) {
+        maxY = std::max(maxY, e.y1);
+    }
+    int sy = std::max(0, (int)std::floor(edges.front().y0));
+    int ey = std::min(buffer.BufferHt - 1, (int)std::ceil(maxY));
+
+    const int subSamples = _antiAlias ? 4 : 1;
+    const float weight = 1.0f / subSamples;
+    const int wi = buffer.BufferWi;
+    std::vector<float> cover(wi + 1);
+    std::vector<const Edge *> active;
+    std::vector<std::pair<double, int>> crossings;
+    size_t next = 0;
+
+    for (int y = sy; y <= ey; y++) {
+        int minx = wi;
+        int maxx = -1;
+        for (int s = 0; s < subSamples; s++) {
+            double yy = y + (s + 0.5) / subSamples;
+            while (next < edges.size() && edges[next].y0 <= yy) {
+                active.push_back(&edges[next++]);
+            }
+            active.erase(std::remove_if(active.begin(), active.end(), [yy](const Edge *e) { return e->y1 <= yy; }), active.end());
+
+            crossings.clear();
+            for (auto e : active) {
+                if (yy >= e->y0) {
+                    crossings.push_back({e->x0 + (yy - e->y0) * e->dxdy, e->dir});
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            int winding = 0;
+            double start = 0;
+            for (const auto &c : crossings) {
+                int prev = winding;
+                winding += c.second;
+                if (prev == 0 && winding != 0) {
+                    start = c.first;
+                } else if (prev != 0 && winding == 0) {
+                    double xa = start;
+                    double xb = c.first;
+                    if (!_antiAlias) {
+                        // pixels whose centres are inside the span
+                        xa = std::ceil(xa - 0.5);
+                        xb = std::ceil(xb - 0.5);
+                    }
+                    xa = std::max(0.0, xa);
+                    xb = std::min((double)wi, xb);
+                    if (xb <= xa) {
+                        continue;
+                    }
+                    int ia = (int)xa;
+                    int ib = (int)xb;
+                    minx = std::min(minx, ia);
+                    maxx = std::max(maxx, ib);
+                    if (ia == ib) {
+                        cover[ia] += (xb - xa) * weight;
+                    } else {
+                        cover[ia] += (ia + 1 - xa) * weight;
+                        for (int x = ia + 1; x < ib; x++) {
+                            cover[x] += weight;
+                        }
+                        cover[ib] += (xb - ib) * weight;
+                    }
+                }
+            }
+        }
+
+        for (int x = minx; x <= maxx && x < wi; x++) {
+            float c = std::min(1.0f, cover[x]);
+            cover[x] = 0;
+            int alpha = c * color.alpha + 0.5f;
+            if (alpha == 0) {
+                continue;
+            }
+            const xlColor &dst = buffer.GetPixel(x, y);
+            if (alpha == 255 || dst.alpha == 0) {
+                buffer.SetPixel(x, y, xlColor(color.red, color.green, color.blue, alpha));
+            } else {
+                // source over with straight alpha
+                int outa = alpha + dst.alpha * (255 - alpha) / 255;
+                int da = dst.alpha * (255 - alpha) / 255;
+                buffer.SetPixel(x, y, xlColor((color.red * alpha + dst.red * da) / outa,
+                                              (color.green * alpha + dst.green * da) / outa,
+                                              (color.blue * alpha + dst.blue * da) / outa,
+                                              outa));
+            }
+        }
+        if (maxx >= wi) {
+            cover[wi] = 0;
+        }
+    }
+}
+
 RenderBuffer::RenderBuffer(xLightsFrame *f) : frame(f)
 {
     BufferHt = 0;
@@ -644,10 +832,10 @@ RenderBuffer::RenderBuffer(xLightsFrame *f) : frame(f)
     fadeoutsteps = 0;
     allowAlpha = false;
     needToInit = true;
+    stateCount = 0;
     _nodeBuffer = false;
     frameTimeInMs = 50;
     _textDrawingContext = nullptr;
-    _pathDrawingContext = nullptr;
     tempInt = tempInt2 = 0;
     isTransformed = false;
 }
@@ -658,23 +846,12 @@ RenderBuffer::~RenderBuffer()
     if (_textDrawingContext != nullptr) {
         TextDrawingContext::ReleaseContext(_textDrawingContext);
     }
-    if (_pathDrawingContext != nullptr) {
-        PathDrawingContext::ReleaseContext(_pathDrawingContext);
-    }
     for (std::map<int, EffectRenderCache*>::iterator i = infoCache.begin(); i != infoCache.end(); i++) {
         delete i->second;
     }
-}
-
-PathDrawingContext * RenderBuffer::GetPathDrawingContext()
-{
-    if (_pathDrawingContext == nullptr)
-    {
-        _pathDrawingContext = PathDrawingContext::GetContext();
-        _pathDrawingContext->ResetSize(BufferWi, BufferHt);
+    for (auto& it : effectParameters) {
+        delete it.second;
     }
-
-    return _pathDrawingContext; 
 }
 
 TextDrawingContext * RenderBuffer::GetTextDrawingContext()
@@ -692,9 +869,6 @@ void RenderBuffer::InitBuffer(int newBufferHt, int newBufferWi, int newModelBuff
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    if (_pathDrawingContext != nullptr && (BufferHt != newBufferHt || BufferWi != newBufferWi)) {
-        _pathDrawingContext->ResetSize(newBufferWi, newBufferHt);
-    }
     if (_textDrawingContext != nullptr && (BufferHt != newBufferHt || BufferWi != newBufferWi)) {
         _textDrawingContext->ResetSize(newBufferWi, newBufferHt);
     }
@@ -714,6 +888,7 @@ void RenderBuffer::InitBuffer(int newBufferHt, int newBufferWi, int newModelBuff
     pixels.resize(NumPixels);
     tempbuf.resize(NumPixels);
     isTransformed = (bufferTransform != "None");
+    nodeTable.Build(Nodes);
 }
 
 void RenderBuffer::Clear()
@@ -809,6 +984,11 @@ double RenderBuffer::RandomRange(double num1, double num2)
     return rand01()*(hi-lo)+ lo;
 }
 
+int RenderBuffer::rand()
+{
+    return frameRandom() % ((unsigned)RAND_MAX + 1);
+}
+
 void RenderBuffer::Color2HSV(const xlColor& color, HSVValue& hsv)
 {
     color.toHSV(hsv);
@@ -874,6 +1054,23 @@ void RenderBuffer::GetMultiColorBlend(float n, bool circular, xlColor &color, in
     Get2ColorBlend(coloridx1, coloridx2, ratio, color);
 }
 
+const MultiColorBlendTable &RenderBuffer::GetMultiColorBlendTable(bool circular, int reserveColours)
+{
+    MultiColorBlendTable &table = multiColorBlendTable;
+    int colorcnt = GetColorCount() - reserveColours;
+    if (table.version != palette.GetVersion() || table.colorCount != colorcnt || table.circular != circular)
+    {
+        for (int i = 0; i < MultiColorBlendTable::SIZE; i++)
+        {
+            GetMultiColorBlend((float)i / (float)MultiColorBlendTable::SIZE, circular, table.colors[i], reserveColours);
+        }
+        table.version = palette.GetVersion();
+        table.colorCount = colorcnt;
+        table.circular = circular;
+    }
+    return table;
+}
+
 
 // 0,0 is lower left
 void RenderBuffer::SetPixel(int x, int y, const xlColor &color, bool wrap, bool useAlpha)
@@ -977,11 +1174,11 @@ void RenderBuffer::SetNodePixel(int nodeNum, const xlColor &color) {
 
 void RenderBuffer::CopyNodeColorsToPixels(std::vector<bool> &done) {
     xlColor c;
-    for (auto &node : Nodes) {
-        node->GetColor(c);
-        for (auto &a : node->Coords) {
-            int x = a.bufX;
-            int y = a.bufY;
+    for (size_t n = 0; n < nodeTable.size(); n++) {
+        nodeTable.GetColor(n, c);
+        for (uint32_t i = nodeTable.coordStart[n]; i < nodeTable.coordStart[n + 1]; i++) {
+            int x = nodeTable.bufX[i];
+            int y = nodeTable.bufY[i];
             if (x >= 0 && x < BufferWi && y >= 0 && y < BufferHt && y*BufferWi + x < pixels.size()) {
                 pixels[y*BufferWi+x] = c;
                 done[y*BufferWi+x] = true;
@@ -1259,10 +1456,12 @@ void RenderBuffer::SetState(int period, bool ResetState, const std::string& mode
     if (ResetState)
     {
         needToInit = true;
+        ++stateCount;
     }
     curPeriod = period;
     cur_model = model_name;
     curPeriod = period;
+    frameRandom.seed(period + 1);
     palette.UpdateForProgress(GetEffectTimeIntervalPosition());
 }
 
@@ -1406,6 +1605,7 @@ RenderBuffer::RenderBuffer(RenderBuffer& buffer)
     fadeinsteps = 0;
     fadeoutsteps = 0;
     needToInit = true;
+    stateCount = 0;
     tempInt = 0;
     tempInt2 = 0;
     allowAlpha = buffer.allowAlpha;
@@ -1417,5 +1617,4 @@ RenderBuffer::RenderBuffer(RenderBuffer& buffer)
 
     pixels = buffer.pixels;
     _textDrawingContext = nullptr;
-    _pathDrawingContext = nullptr;
 }
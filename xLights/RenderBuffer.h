@@ -29,6 +29,7 @@
 #include <list>
 #include <vector>
 #include <atomic>
+#include <random>
 #include <wx/colour.h>
 #include <wx/dcclient.h>
 #include <wx/dcmemory.h>
@@ -102,23 +103,6 @@ protected:
     wxGraphicsContext *gc;
 };
 
-class PathDrawingContext : public DrawingContext {
-public:
-    PathDrawingContext(int BufferWi, int BufferHt, bool allowShared);
-    virtual ~PathDrawingContext();
-
-    static PathDrawingContext* GetContext();
-    static void ReleaseContext(PathDrawingContext* pdc);
-    
-    virtual void Clear() override;
-
-    void SetPen(wxPen& pen);
-
-    wxGraphicsPath CreatePath();
-    void StrokePath(wxGraphicsPath& path);
-private:
-};
-
 class TextDrawingContext : public DrawingContext {
 public:
     TextDrawingContext(int BufferWi, int BufferHt, bool allowShared);
@@ -146,6 +130,50 @@ private:
     wxGraphicsFont font;
 };
 
+class RenderBuffer;
+
+// Lines, curves, arcs and polygons flattened into polygons and scan converted straight into a
+// RenderBuffer.  Nothing here touches wx so paths can be drawn on any render thread.  Coordinates
+// are buffer coordinates and pixel x,y covers x to x+1 and y to y+1.
+class PathRasteriser {
+public:
+    PathRasteriser(bool antiAlias = true) : _antiAlias(antiAlias) {}
+
+    void Clear() { _paths.clear(); }
+    void MoveTo(double x, double y);
+    void LineTo(double x, double y);
+    void QuadTo(double cx, double cy, double x, double y);
+    void CubicTo(double c1x, double c1y, double c2x, double c2y, double x, double y);
+    // angles are in radians, anticlockwise from the x axis
+    void ArcTo(double xc, double yc, double r, double startAngle, double endAngle);
+    void AddCircle(double xc, double yc, double r);
+    void Close();
+
+    // sub paths are filled with the non zero winding rule
+    void Fill(RenderBuffer &buffer, const xlColor &color) const;
+    // round joins and caps, overlaps are only drawn once
+    void Stroke(RenderBuffer &buffer, const xlColor &color, double width) const;
+
+private:
+    struct Point {
+        double x;
+        double y;
+    };
+    struct SubPath {
+        std::vector<Point> points;
+        bool closed = false;
+    };
+    SubPath &Current();
+    static void AddPolygon(std::vector<std::vector<Point>> &polygons, std::vector<Point> &&polygon);
+    static void AddCircle(std::vector<std::vector<Point>> &polygons, double xc, double yc, double r);
+    void Rasterise(RenderBuffer &buffer, const std::vector<std::vector<Point>> &polygons, const xlColor &color) const;
+
+    std::vector<SubPath> _paths;
+    bool _antiAlias;
+};
+
+#define COLORCURVE_TABLE_SIZE 1024
+
 class PaletteClass
 {
 private:
@@ -153,6 +181,22 @@ private:
     hsvVector hsv;
     xlColorCurveVector cc;
     const ColorCurve nilcc;
+    // spatial colour curves evaluated across 0-1 so pixels look their colour up
+    std::vector<xlColorVector> ccTable;
+    // bumped whenever the colours change so tables built from them can tell they are stale
+    int version = 0;
+
+    xlColor GetCurveColor(size_t idx, float offset) const
+    {
+        const xlColorVector &table = ccTable[idx];
+        if (table.empty())
+        {
+            return cc[idx].GetValueAt(offset);
+        }
+        if (!(offset > 0.0f)) return table.front();
+        if (offset >= 1.0f) return table.back();
+        return table[(int)(offset * (COLORCURVE_TABLE_SIZE - 1) + 0.5f)];
+    }
 
 public:
 
@@ -165,6 +209,7 @@ public:
             {
                 color[i] = xlColor(it->GetValueAt(progress));
                 hsv[i] = color[i].asHSV();
+                version++;
             }
             i++;
         }
@@ -181,8 +226,26 @@ public:
         {
             hsv.push_back(newcolors[i].asHSV());
         }
+
+        // random curves give a different colour every call so those are left to evaluate
+        ccTable.clear();
+        ccTable.resize(cc.size());
+        for (size_t i = 0; i < cc.size(); i++)
+        {
+            if (cc[i].IsActive() && cc[i].GetTimeCurve() != TC_TIME && cc[i].GetType() != "Random")
+            {
+                ccTable[i].resize(COLORCURVE_TABLE_SIZE);
+                for (int x = 0; x < COLORCURVE_TABLE_SIZE; x++)
+                {
+                    ccTable[i][x] = cc[i].GetValueAt((float)x / (float)(COLORCURVE_TABLE_SIZE - 1));
+                }
+            }
+        }
+        version++;
     }
 
+    int GetVersion() const { return version; }
+
     size_t Size() const
     {
         return std::max(1, (int)color.size());
@@ -238,11 +301,11 @@ public:
     {
         if (type == TC_CW)
         {
-            return cc[idx].GetValueAt(round);
+            return GetCurveColor(idx, round);
         }
         else
         {
-            return cc[idx].GetValueAt(1.0 - round);
+            return GetCurveColor(idx, 1.0 - round);
         }
     }
 
@@ -250,9 +313,9 @@ public:
     {
         double len = sqrt((x - centrex) * (x - centrex) + (y - centrey) * (y - centrey));
         if (type == TC_RADIALIN)
-            return cc[idx].GetValueAt(1.0 - len / maxradius);
+            return GetCurveColor(idx, 1.0 - len / maxradius);
         else
-            return cc[idx].GetValueAt(len / maxradius);
+            return GetCurveColor(idx, len / maxradius);
     }
 
     void GetSpatialColor(size_t idx, float xcentre, float ycentre, float x, float y, float round, float maxradius, xlColor& c) const
@@ -304,16 +367,16 @@ public:
                 switch (cc[idx].GetTimeCurve())
                 {
                 case TC_RIGHT:
-                    c = cc[idx].GetValueAt(x);
+                    c = GetCurveColor(idx, x);
                     break;
                 case TC_LEFT:
-                    c = cc[idx].GetValueAt(1.0 - x);
+                    c = GetCurveColor(idx, 1.0 - x);
                     break;
                 case TC_UP:
-                    c = cc[idx].GetValueAt(y);
+                    c = GetCurveColor(idx, y);
                     break;
                 case TC_DOWN:
-                    c = cc[idx].GetValueAt(1.0 - y);
+                    c = GetCurveColor(idx, 1.0 - y);
                     break;
                 default:
                     c = color[idx];
@@ -383,12 +446,42 @@ public:
     }
 };
 
+// GetMultiColorBlend for every point across the palette, see RenderBuffer::GetMultiColorBlendTable
+class MultiColorBlendTable
+{
+public:
+    static const int SIZE = 1024;
+
+    const xlColor &Get(float n) const
+    {
+        if (!(n > 0.0f)) return colors[0];
+        int i = (int)(n * SIZE);
+        return colors[i < SIZE ? i : SIZE - 1];
+    }
+
+private:
+    friend class RenderBuffer;
+    xlColor colors[SIZE];
+    int version = -1;
+    int colorCount = 0;
+    bool circular = false;
+};
+
 class /*NCCDLLEXPORT*/ EffectRenderCache {
 public:
 	EffectRenderCache();
 	virtual ~EffectRenderCache();
 };
 
+/* Effect settings decoded into a typed block when the effect starts rendering, see RenderableEffect::GetParameters */
+class /*NCCDLLEXPORT*/ EffectParameters {
+public:
+    EffectParameters() : effect(nullptr), stateCount(0) {}
+    virtual ~EffectParameters() {}
+    const Effect *effect;      /**< effect the settings were decoded for */
+    unsigned int stateCount;   /**< RenderBuffer::stateCount when they were decoded */
+};
+
 class /*NCCDLLEXPORT*/ RenderBuffer {
 public:
     RenderBuffer(xLightsFrame *frame);
@@ -402,6 +495,7 @@ public:
 
     void AlphaBlend(const RenderBuffer& src);
     bool IsNodeBuffer() const { return _nodeBuffer; }
+    const std::vector<NodeBaseClassPtr>& GetNodes() const { return Nodes; }
     void Clear();
     void SetPalette(xlColorVector& newcolors, xlColorCurveVector& newcc);
     size_t GetColorCount();
@@ -452,8 +546,14 @@ public:
     void Get2ColorBlend(xlColor& color, xlColor color2, float ratio);
     void Get2ColorAlphaBlend(const xlColor& c1, const xlColor& c2, float ratio, xlColor &color);
     void GetMultiColorBlend(float n, bool circular, xlColor &color, int reserveColors = 0);
+    // GetMultiColorBlend baked for the current palette for effects that colour every pixel from it.
+    // Call it once per frame outside any parallel loop, the table is rebuilt when the palette changes.
+    const MultiColorBlendTable &GetMultiColorBlendTable(bool circular, int reserveColors = 0);
     void SetRangeColor(const HSVValue& hsv1, const HSVValue& hsv2, HSVValue& newhsv);
     double RandomRange(double num1, double num2);
+    // same range as ::rand() but seeded from the frame so effects that can be
+    // rendered out of order give the same result whichever thread renders them
+    int rand();
     void Color2HSV(const xlColor& color, HSVValue& hsv);
     PaletteClass& GetPalette() { return palette; }
 
@@ -461,7 +561,6 @@ public:
     float GetEffectTimeIntervalPosition();
     float GetEffectTimeIntervalPosition(float cycles);
 
-    PathDrawingContext * GetPathDrawingContext();
     TextDrawingContext * GetTextDrawingContext();
 
     void CopyPixelsToDisplayListX(Effect *eff, int y, int sx, int ex, int inc = 1);
@@ -480,6 +579,7 @@ public:
     xlColorVector pixels; // this is the calculation buffer
     xlColorVector tempbuf;
     PaletteClass palette;
+    MultiColorBlendTable multiColorBlendTable;
     bool _nodeBuffer;
 
     xLightsFrame *frame;
@@ -495,17 +595,20 @@ public:
     int fadeoutsteps;
 
     bool needToInit;
+    unsigned int stateCount; /**< incremented every time the effect state is reset */
     bool allowAlpha;
+    std::minstd_rand frameRandom;
 
     /* Places to store and data that is needed from one frame to another */
     std::map<int, EffectRenderCache*> infoCache;
+    std::map<int, EffectParameters*> effectParameters;
     int tempInt;
     int tempInt2;
 
 private:
     friend class PixelBufferClass;
     std::vector<NodeBaseClassPtr> Nodes;
-    PathDrawingContext *_pathDrawingContext;
+    NodeTable nodeTable;
     TextDrawingContext *_textDrawingContext;
 };
 
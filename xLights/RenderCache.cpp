@@ -8,9 +8,180 @@
 #include <wx/filename.h>
 #include <wx/dir.h>
 #include <functional>
+#include <set>
+#include <algorithm>
+#include <chrono>
 #include "xLightsVersion.h"
 #include "UtilFunctions.h"
 
+#ifndef NO_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Cache file layout, all values in native byte order as the cache never leaves the machine
+//    "XLRC" uint32 version uint32 headerSize
+//    header: uint64 key, uint32 properties, key\0value\0 ..., uint32 models,
+//            name\0 int32 width int32 height uint32 frameSize uint64 geometry uint32 frames ...
+//    frame table: uint64 offset uint32 size for each frame of each model in header order
+//    frames: zstd compressed, or raw if size == frameSize
+#define RENDER_CACHE_MAGIC "XLRC"
+#define RENDER_CACHE_VERSION 3
+#define RENDER_CACHE_INDEX_MAGIC "XLRI"
+#define RENDER_CACHE_INDEX_FILE "RenderCache.index"
+// rendered frames waiting to be written before render threads are made to wait
+#define RENDER_CACHE_MAX_PENDING_SAVE (256 * 1024 * 1024)
+
+#pragma region Serialisation
+static void WriteU32(std::vector<unsigned char>& out, uint32_t v)
+{
+    out.insert(out.end(), (unsigned char*)&v, (unsigned char*)&v + sizeof(v));
+}
+
+static void WriteU64(std::vector<unsigned char>& out, uint64_t v)
+{
+    out.insert(out.end(), (unsigned char*)&v, (unsigned char*)&v + sizeof(v));
+}
+
+static void WriteString(std::vector<unsigned char>& out, const std::string& s)
+{
+    out.insert(out.end(), s.begin(), s.end());
+    out.push_back(0x00);
+}
+
+static bool ReadU32(const unsigned char* data, size_t len, size_t& pos, uint32_t& v)
+{
+    if (pos + sizeof(v) > len) return false;
+    memcpy(&v, &data[pos], sizeof(v));
+    pos += sizeof(v);
+    return true;
+}
+
+static bool ReadU64(const unsigned char* data, size_t len, size_t& pos, uint64_t& v)
+{
+    if (pos + sizeof(v) > len) return false;
+    memcpy(&v, &data[pos], sizeof(v));
+    pos += sizeof(v);
+    return true;
+}
+
+static bool ReadString(const unsigned char* data, size_t len, size_t& pos, std::string& s)
+{
+    if (pos >= len) return false;
+    const unsigned char* end = (const unsigned char*)memchr(&data[pos], 0x00, len - pos);
+    if (end == nullptr) return false;
+    s.assign((const char*)&data[pos], end - &data[pos]);
+    pos += s.size() + 1;
+    return true;
+}
+
+// FNV-1a
+static void HashBytes(uint64_t& hash, const void* data, size_t len)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+}
+
+static void HashString(uint64_t& hash, const std::string& s)
+{
+    // include the terminator so "ab","c" and "a","bc" differ
+    HashBytes(hash, s.c_str(), s.size() + 1);
+}
+#pragma endregion Serialisation
+
+#pragma region RenderCacheMappedFile
+// Read only view of a cache file.  The OS keeps the view valid after the
+// handles are closed so only the view itself is tracked.
+class RenderCacheMappedFile
+{
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+
+public:
+    ~RenderCacheMappedFile() { Close(); }
+    const unsigned char* Data() const { return _data; }
+    size_t Size() const { return _size; }
+
+    bool Open(const std::string& filename)
+    {
+        Close();
+#ifdef __WXMSW__
+        HANDLE file = CreateFileW(wxString(filename).wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz) || sz.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* data = mapping == nullptr ? nullptr : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        if (data == nullptr) return false;
+        _size = (size_t)sz.QuadPart;
+#else
+        int file = open(filename.c_str(), O_RDONLY);
+        if (file < 0) return false;
+        struct stat st;
+        if (fstat(file, &st) != 0 || st.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (data == MAP_FAILED) return false;
+        _size = st.st_size;
+#endif
+        _data = (const unsigned char*)data;
+        return true;
+    }
+
+    void Close()
+    {
+        if (_data != nullptr)
+        {
+#ifdef __WXMSW__
+            UnmapViewOfFile(_data);
+#else
+            munmap((void*)_data, _size);
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+
+    // gets the OS reading the file in the background
+    void WillNeed()
+    {
+        if (_data == nullptr) return;
+#ifdef __WXMSW__
+        // PrefetchVirtualMemory isn't available on all the versions we support so fault the pages in
+        volatile unsigned char sum = 0;
+        for (size_t i = 0; i < _size; i += 4096)
+        {
+            sum += _data[i];
+        }
+#else
+        madvise((void*)_data, _size, MADV_WILLNEED);
+#endif
+    }
+};
+#pragma endregion RenderCacheMappedFile
+
 #pragma region RenderCache
 
 class RenderCacheLoadThread : public wxThread
@@ -32,49 +203,226 @@ private:
 
         logger_base.debug("Loading cache.");
 
+        _cache->EnforceMaxSize();
+
         wxString cacheFolder = _cache->GetCacheFolder();
 
+        std::map<std::string, RenderCache::IndexEntry> index;
+        _cache->ReadIndex(index);
+
         wxDir dir(cacheFolder);
         wxArrayString files;
         dir.GetAllFiles(cacheFolder, &files, "*.cache");
 
+        int fromIndex = 0;
         for (auto it : files)
         {
-            // allow up to 3 times physical memory
-            // This means the render cache will be swapped out ... but I think that is still better than re-rendering
-            // Abandon loading render cache if we use too much memory
-            if (IsExcessiveMemoryUsage(3.0))
+            // items only hold their header until a frame is needed so there is no memory check here
+            RenderCacheItem* rci = nullptr;
+            auto idx = index.find(wxFileName(it).GetFullName().ToStdString());
+            if (idx != index.end() && idx->second.size == wxFileName::GetSize(it).GetValue())
             {
-                logger_base.warn("Render cache loading abandoned due to too much memory use.");
-                break;
+                rci = new RenderCacheItem(_cache, it.ToStdString(), idx->second.header);
+                fromIndex++;
+            }
+            else
+            {
+                rci = new RenderCacheItem(_cache, it.ToStdString());
             }
 
-            auto rci = new RenderCacheItem(_cache, it);
-            if (rci != nullptr && !rci->IsPurged())
+            if (!rci->IsPurged())
             {
                 _cache->AddCacheItem(rci);
             }
             else
             {
-                logger_base.warn("Failed to load cache item %s.", (const char*)it.c_str());
+                // most likely a cache file from an older version, it can never be used again
+                logger_base.warn("Failed to load cache item %s so removing it.", (const char*)it.c_str());
+                delete rci;
+                wxRemoveFile(it);
             }
         }
 
-        logger_base.debug("Cache contained %d files.", (int)files.size());
+        logger_base.debug("Cache contained %d files, %d read from the index.", (int)files.size(), fromIndex);
+        _cache->SaveIndex();
 
         return nullptr;
     }
 };
 
-RenderCache::RenderCache()
+RenderCache::RenderCache() : _statHits(0), _statMisses(0), _statPrefetches(0), _statBytesRead(0), _statBytesWritten(0), _statWriteStallUS(0)
 {
     _enabled = true;
 	_cacheFolder = "";
+    _maxSize = 0;
+    _ioItem = nullptr;
+    _pendingSaveBytes = 0;
+    _ioExit = false;
 }
 
 RenderCache::~RenderCache()
 {
     Close();
+    StopIOThread();
+}
+
+// must be called with _ioLock held
+void RenderCache::StartIOThread()
+{
+    if (!_ioThread.joinable())
+    {
+        _ioExit = false;
+        _ioThread = std::thread(&RenderCache::IOThread, this);
+    }
+}
+
+void RenderCache::StopIOThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(_ioLock);
+        _ioExit = true;
+    }
+    _ioSignal.notify_all();
+    if (_ioThread.joinable())
+    {
+        _ioThread.join();
+    }
+}
+
+void RenderCache::IOThread()
+{
+    std::unique_lock<std::mutex> lock(_ioLock);
+    while (true)
+    {
+        _ioSignal.wait(lock, [this] { return _ioExit || !_saveQueue.empty() || !_prefetchQueue.empty(); });
+        // pending saves are still written on the way out, prefetches aren't needed any more
+        if (_ioExit && _saveQueue.empty()) break;
+
+        // prefetches are cheap and the render is waiting on them so they go first
+        bool save = _prefetchQueue.empty() || _ioExit;
+        if (save)
+        {
+            _ioItem = _saveQueue.front();
+            _saveQueue.pop_front();
+        }
+        else
+        {
+            _ioItem = _prefetchQueue.front();
+            _prefetchQueue.pop_front();
+        }
+        size_t bytes = save ? _ioItem->GetRenderedSize() : 0;
+
+        lock.unlock();
+        if (save)
+        {
+            _ioItem->Save();
+        }
+        else
+        {
+            _ioItem->Prefetch();
+            ++_statPrefetches;
+        }
+        lock.lock();
+
+        _pendingSaveBytes -= std::min(bytes, _pendingSaveBytes);
+        _ioItem = nullptr;
+        _ioDone.notify_all();
+    }
+}
+
+void RenderCache::Prefetch(Effect* effect)
+{
+    if (!IsEnabled() || _cacheFolder == "") return;
+
+    // don't hold the render up if the cache is still loading
+    std::unique_lock<std::mutex> loadLock(_loadMutex, std::try_to_lock);
+    if (!loadLock.owns_lock()) return;
+    loadLock.unlock();
+
+    uint64_t key = RenderCacheItem::HashEffect(effect);
+
+    std::unique_lock<std::recursive_mutex> lock(_cacheLock);
+    for (auto it : _cache) {
+        if (it->GetKey() == key && !it->IsPurged()) {
+            QueuePrefetch(it);
+            return;
+        }
+    }
+}
+
+void RenderCache::QueuePrefetch(RenderCacheItem* item)
+{
+    std::unique_lock<std::mutex> lock(_ioLock);
+    if (_ioItem == item || std::find(_prefetchQueue.begin(), _prefetchQueue.end(), item) != _prefetchQueue.end()) return;
+    StartIOThread();
+    _prefetchQueue.push_back(item);
+    _ioSignal.notify_one();
+}
+
+void RenderCache::QueueSave(RenderCacheItem* item)
+{
+    size_t bytes = item->GetRenderedSize();
+
+    std::unique_lock<std::mutex> lock(_ioLock);
+    if (std::find(_saveQueue.begin(), _saveQueue.end(), item) != _saveQueue.end()) return;
+    StartIOThread();
+
+    if (_pendingSaveBytes > RENDER_CACHE_MAX_PENDING_SAVE)
+    {
+        // the disk isn't keeping up, hold this render thread until it does
+        auto start = std::chrono::steady_clock::now();
+        _ioDone.wait(lock, [this] { return _pendingSaveBytes <= RENDER_CACHE_MAX_PENDING_SAVE; });
+        _statWriteStallUS += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    _saveQueue.push_back(item);
+    _pendingSaveBytes += bytes;
+    _ioSignal.notify_one();
+}
+
+void RenderCache::CancelIO(RenderCacheItem* item, bool save)
+{
+    bool queued = false;
+    {
+        std::unique_lock<std::mutex> lock(_ioLock);
+        _prefetchQueue.remove(item);
+        auto it = std::find(_saveQueue.begin(), _saveQueue.end(), item);
+        if (it != _saveQueue.end())
+        {
+            _saveQueue.erase(it);
+            _pendingSaveBytes -= std::min(item->GetRenderedSize(), _pendingSaveBytes);
+            queued = true;
+            _ioDone.notify_all();
+        }
+        _ioDone.wait(lock, [this, item] { return _ioItem != item; });
+    }
+    if (queued && save)
+    {
+        item->Save();
+    }
+}
+
+void RenderCache::FlushSaves()
+{
+    std::unique_lock<std::mutex> lock(_ioLock);
+    _ioDone.wait(lock, [this] { return _saveQueue.empty() && _ioItem == nullptr; });
+}
+
+void RenderCache::LogStats()
+{
+    static log4cpp::Category &logger_render = log4cpp::Category::getInstance(std::string("log_render"));
+
+    int hits = _statHits.exchange(0);
+    int misses = _statMisses.exchange(0);
+    int prefetches = _statPrefetches.exchange(0);
+    uint64_t read = _statBytesRead.exchange(0);
+    uint64_t written = _statBytesWritten.exchange(0);
+    uint64_t stall = _statWriteStallUS.exchange(0);
+    if (hits + misses == 0 && written == 0) return;
+
+    logger_render.debug("Render cache: %d hits, %d misses (%d%%), %d prefetches, %lluKB read, %lluKB written, %llums write stall.",
+                        hits, misses, hits + misses == 0 ? 0 : (hits * 100) / (hits + misses), prefetches,
+                        (unsigned long long)(read / 1024), (unsigned long long)(written / 1024), (unsigned long long)(stall / 1000));
 }
 
 void RenderCache::LoadCache()
@@ -96,6 +444,147 @@ void RenderCache::AddCacheItem(RenderCacheItem* rci)
     }
 }
 
+std::string RenderCache::GetIndexFile() const
+{
+    if (_cacheFolder == "") return "";
+    return _cacheFolder + wxFileName::GetPathSeparator() + RENDER_CACHE_INDEX_FILE;
+}
+
+void RenderCache::IndexItem(const std::string& file, uint64_t size, const std::vector<unsigned char>& header)
+{
+    std::unique_lock<std::mutex> lock(_indexLock);
+    IndexEntry& entry = _index[wxFileName(file).GetFullName().ToStdString()];
+    entry.size = size;
+    entry.header = header;
+}
+
+void RenderCache::UnindexItem(const std::string& file)
+{
+    std::unique_lock<std::mutex> lock(_indexLock);
+    _index.erase(wxFileName(file).GetFullName().ToStdString());
+}
+
+void RenderCache::ReadIndex(std::map<std::string, IndexEntry>& index) const
+{
+    index.clear();
+    std::string fn = GetIndexFile();
+    if (fn == "" || !wxFile::Exists(fn)) return;
+
+    RenderCacheMappedFile file;
+    if (!file.Open(fn)) return;
+
+    const unsigned char* data = file.Data();
+    size_t len = file.Size();
+    size_t pos = 4;
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (len < 4 || memcmp(data, RENDER_CACHE_INDEX_MAGIC, 4) != 0 ||
+        !ReadU32(data, len, pos, version) || version != RENDER_CACHE_VERSION ||
+        !ReadU32(data, len, pos, count))
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::string name;
+        IndexEntry entry;
+        uint32_t headerSize = 0;
+        if (!ReadString(data, len, pos, name) || !ReadU64(data, len, pos, entry.size) ||
+            !ReadU32(data, len, pos, headerSize) || pos + headerSize > len)
+        {
+            // truncated, keep what we have
+            return;
+        }
+        entry.header.assign(&data[pos], &data[pos + headerSize]);
+        pos += headerSize;
+        index[name] = entry;
+    }
+}
+
+void RenderCache::SaveIndex()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::string fn = GetIndexFile();
+    if (fn == "") return;
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), RENDER_CACHE_INDEX_MAGIC, RENDER_CACHE_INDEX_MAGIC + 4);
+    WriteU32(out, RENDER_CACHE_VERSION);
+    {
+        std::unique_lock<std::mutex> lock(_indexLock);
+        WriteU32(out, (uint32_t)_index.size());
+        for (const auto& it : _index)
+        {
+            WriteString(out, it.first);
+            WriteU64(out, it.second.size);
+            WriteU32(out, (uint32_t)it.second.header.size());
+            out.insert(out.end(), it.second.header.begin(), it.second.header.end());
+        }
+    }
+
+    wxFile file;
+    if (file.Create(fn, true))
+    {
+        file.Write(&out[0], out.size());
+        file.Close();
+    }
+    else
+    {
+        logger_base.warn("Failed to write render cache index %s.", (const char*)fn.c_str());
+    }
+}
+
+// Removes the least recently used cache files across every sequence's render
+// cache in the show until they fit in the size limit.  Hits touch the file so
+// its modification time is when it was last used.
+void RenderCache::EnforceMaxSize()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_maxSize == 0 || _cacheFolder == "") return;
+
+    wxString root = wxFileName(_cacheFolder).GetPath();
+    wxArrayString files;
+    wxDir::GetAllFiles(root, &files, "*.cache");
+
+    struct CacheFile
+    {
+        time_t used;
+        uint64_t size;
+        wxString name;
+    };
+    std::vector<CacheFile> cacheFiles;
+    cacheFiles.reserve(files.size());
+    uint64_t total = 0;
+    for (const auto& it : files)
+    {
+        wxFileName fn(it);
+        CacheFile cf;
+        cf.used = fn.GetModificationTime().GetTicks();
+        cf.size = fn.GetSize().GetValue();
+        cf.name = it;
+        total += cf.size;
+        cacheFiles.push_back(cf);
+    }
+
+    if (total <= _maxSize) return;
+
+    std::sort(cacheFiles.begin(), cacheFiles.end(), [](const CacheFile& a, const CacheFile& b) { return a.used < b.used; });
+    int removed = 0;
+    for (const auto& it : cacheFiles)
+    {
+        if (total <= _maxSize) break;
+        if (wxRemoveFile(it.name))
+        {
+            total -= it.size;
+            removed++;
+        }
+    }
+    logger_base.debug("Render cache over %ldMB, removed %d least recently used files.", (long)(_maxSize / (1024 * 1024)), removed);
+}
+
 void RenderCache::SetSequence(const std::string& path, const std::string& sequenceFile)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -214,11 +703,15 @@ RenderCacheItem* RenderCache::GetItem(Effect* effect, RenderBuffer* buffer)
         std::unique_lock<std::mutex> lock(_loadMutex);
     }
 
+    uint64_t key = RenderCacheItem::HashEffect(effect);
+
     std::unique_lock<std::recursive_mutex> lock(_cacheLock);
     for (auto it = _cache.begin(); it != _cache.end(); ++it) {
-        if ((*it)->IsMatch(effect, buffer)) {
+        if ((*it)->GetKey() == key && (*it)->IsMatch(effect, buffer, key)) {
             RenderCacheItem *item = *it;
             _cache.erase(it);
+            // the modification time is used as the last used time when trimming the cache
+            wxFileName(item->GetCacheFile()).Touch();
             return item;
         }
     }
@@ -237,7 +730,14 @@ void RenderCache::Close()
         std::unique_lock<std::mutex> lock(_loadMutex);
     }
 
+    // let the write behind catch up so the index includes everything
+    FlushSaves();
     Purge(nullptr, false);
+    SaveIndex();
+    {
+        std::unique_lock<std::mutex> lock(_indexLock);
+        _index.clear();
+    }
     _cacheFolder = "";
 }
 
@@ -284,18 +784,24 @@ static void purgeCache(Element *em, bool del) {
     });
 }
 
-static bool findMatch(Element *em, RenderCacheItem* item) {
-    return doOnEffects(em, [item] (Effect* e) {
-        return item->IsMatch(e, nullptr);
-    });
-}
-
 void RenderCache::CleanupCache(SequenceElements* sequenceElements)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
     logger_base.debug("Cleaning up the cache.");
 
+    // hash every cacheable effect once rather than comparing each cache item against every effect
+    std::set<uint64_t> keys;
+    for (int i = 0; i < sequenceElements->GetElementCount(); i++) {
+        Element* em = sequenceElements->GetElement(i);
+        doOnEffects(em, [this, &keys] (Effect* e) {
+            if (IsEffectOkForCaching(e)) {
+                keys.insert(RenderCacheItem::HashEffect(e));
+            }
+            return false;
+        });
+    }
+
     // clean up cache
     // Because effects are removed from the cache then if you go from cache enabled to cache disabled this wont actually
     // clean out all the cache items ... as we dont know about them.
@@ -303,14 +809,7 @@ void RenderCache::CleanupCache(SequenceElements* sequenceElements)
     int deleted = 0;
     auto it = _cache.begin();
     while (it != _cache.end()) {
-        bool found = false;
-
-        for (int i = 0; i < sequenceElements->GetElementCount() && !found; i++) {
-            Element* em = sequenceElements->GetElement(i);
-            found = findMatch(em, *it);
-        }
-
-        if (!found) {
+        if ((*it)->IsPurged() || keys.find((*it)->GetKey()) == keys.end()) {
             auto todelete = it;
             ++it;
             (*todelete)->Delete();
@@ -366,18 +865,38 @@ void RenderCache::Purge(SequenceElements* sequenceElements, bool dodelete)
 #pragma region RenderCacheItem
 RenderCacheItem::~RenderCacheItem()
 {
-    PurgeFrames();
+    _renderCache->CancelIO(this, true);
+    ReleaseFrames();
+}
+
+void RenderCacheItem::Unmap()
+{
+    _mapped.reset();
+    for (auto& it : _models)
+    {
+        std::fill(it.second.compressed.begin(), it.second.compressed.end(), nullptr);
+        std::fill(it.second.compressedSize.begin(), it.second.compressedSize.end(), 0);
+    }
 }
 
 void RenderCacheItem::PurgeFrames()
 {
+    // a write behind still waiting is done now so the file is kept up to date
+    _renderCache->CancelIO(this, true);
+    ReleaseFrames();
+}
+
+void RenderCacheItem::ReleaseFrames()
+{
+    std::unique_lock<std::recursive_mutex> lock(_lock);
     _purged = true;
-    for (auto it = _frames.begin(); it != _frames.end(); ++it)
+    Unmap();
+    for (auto it = _models.begin(); it != _models.end(); ++it)
     {
-        for (int x = it->second.size() - 1; x >= 0; --x) {
-            if (it->second[x]) {
-                free(it->second[x]);
-                it->second[x] = nullptr;
+        for (int x = it->second.frames.size() - 1; x >= 0; --x) {
+            if (it->second.frames[x]) {
+                free(it->second.frames[x]);
+                it->second.frames[x] = nullptr;
             }
         }
     }
@@ -402,13 +921,66 @@ std::string RenderCacheItem::GetModelName(RenderBuffer* buffer)
     }
 }
 
+uint64_t RenderCacheItem::HashEffect(Effect* effect)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    HashString(hash, effect->GetEffectName());
+    HashString(hash, effect->GetParentEffectLayer()->GetParentElement()->GetFullName());
+    int v = effect->GetParentEffectLayer()->GetLayerNumber();
+    HashBytes(hash, &v, sizeof(v));
+    v = effect->GetStartTimeMS();
+    HashBytes(hash, &v, sizeof(v));
+    v = effect->GetEndTimeMS();
+    HashBytes(hash, &v, sizeof(v));
+    // the settings include the buffer style and transform
+    for (const auto& it : effect->GetSettings())
+    {
+        HashString(hash, it.first);
+        HashString(hash, it.second);
+    }
+    for (const auto& it : effect->GetPaletteMap())
+    {
+        HashString(hash, it.first);
+        HashString(hash, it.second);
+    }
+    return hash;
+}
+
+// The effect settings don't change when a model is moved, resized or rewired so
+// the node positions in the buffer are hashed too.
+uint64_t RenderCacheItem::HashGeometry(RenderBuffer* buffer)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int v = buffer->BufferWi;
+    HashBytes(hash, &v, sizeof(v));
+    v = buffer->BufferHt;
+    HashBytes(hash, &v, sizeof(v));
+    for (const auto& node : buffer->GetNodes())
+    {
+        v = node->Coords.size();
+        HashBytes(hash, &v, sizeof(v));
+        for (const auto& c : node->Coords)
+        {
+            HashBytes(hash, &c.bufX, sizeof(c.bufX));
+            HashBytes(hash, &c.bufY, sizeof(c.bufY));
+        }
+    }
+    return hash;
+}
+
 RenderCacheItem::RenderCacheItem(RenderCache* renderCache, Effect* effect, RenderBuffer* buffer) : _renderCache(renderCache)
 {
     _purged = false;
     _dirty = true;
+    _key = HashEffect(effect);
     std::string mname = GetModelName(buffer);
     wxASSERT(mname != "");
-    _frameSize[mname] = sizeof(xlColor) * buffer->pixels.size();
+    ModelFrames& mf = _models[mname];
+    mf.width = buffer->BufferWi;
+    mf.height = buffer->BufferHt;
+    mf.frameSize = sizeof(xlColor) * buffer->pixels.size();
+    mf.geometry = HashGeometry(buffer);
+    mf.geometryChecked = true;
     wxString elname = effect->GetParentEffectLayer()->GetParentElement()->GetFullName();
     elname.Replace("/", "_");
     elname.Replace("\\", "_");
@@ -428,61 +1000,29 @@ RenderCacheItem::RenderCacheItem(RenderCache* renderCache, Effect* effect, Rende
     _properties["StartMS"] = wxString::Format("%d", effect->GetStartTimeMS());
     _properties["EndMS"] = wxString::Format("%d", effect->GetEndTimeMS());
     _properties["Frames"] = wxString::Format("%d", buffer->curEffEndPer - buffer->curEffStartPer + 1);
-    _properties["Models"] = "-1";
-    for (auto it = effect->GetSettings().begin(); it != effect->GetSettings().end(); ++it)
-    {
-        _properties[it->first] = it->second;
-    }
-    for (auto it = effect->GetPaletteMap().begin(); it != effect->GetPaletteMap().end(); ++it)
-    {
-        _properties[it->first] = it->second;
-    }
 }
 
 bool RenderCacheItem::IsMatch(Effect* effect, RenderBuffer* buffer)
+{
+    return IsMatch(effect, buffer, HashEffect(effect));
+}
+
+bool RenderCacheItem::IsMatch(Effect* effect, RenderBuffer* buffer, uint64_t key)
 {
     if (_purged) return false;
+    if (key != _key) return false;
     if (!_renderCache->IsEffectOkForCaching(effect)) return false;
 
-    if (wxAtoi(_properties.at("StartMS")) != effect->GetStartTimeMS()) return false;
-
-    EffectLayer* el = effect->GetParentEffectLayer();
-    if (wxAtoi(_properties.at("EffectLayer")) != el->GetLayerNumber()) return false;
-
-    Element* e = el->GetParentElement();
-    if (_properties.at("Element") != e->GetFullName()) return false;
-
     if (buffer != nullptr)
     {
-        std::string mname = GetModelName(buffer);
-        if (_frameSize.at(mname) != sizeof(xlColor) * buffer->pixels.size()) return false;
-    }
-
-    if (wxAtoi(_properties.at("EndMS")) != effect->GetEndTimeMS()) return false;
-    if (_properties.at("Effect") != effect->GetEffectName()) return false;
-
-    // 8 is the number of predefined tags
-    if (_properties.size() - 7 != effect->GetSettings().size() + effect->GetPaletteMap().size()) return false;
-
-    for (auto it = effect->GetSettings().begin(); it != effect->GetSettings().end(); ++it)
-    {
-        if (_properties.find(it->first) == _properties.end()) {
-            return false;
-        }
-        else
+        // a model we haven't seen yet is fine, it gets added as it renders
+        auto it = _models.find(GetModelName(buffer));
+        if (it != _models.end())
         {
-            if (_properties.at(it->first) != it->second) return false;
-        }
-    }
-
-    for (auto it = effect->GetPaletteMap().begin(); it != effect->GetPaletteMap().end(); ++it)
-    {
-        if (_properties.find(it->first) == _properties.end()) {
-            return false;
-        }
-        else
-        {
-            if (_properties.at(it->first) != it->second) return false;
+            if (it->second.frameSize != (long)(sizeof(xlColor) * buffer->pixels.size())) return false;
+            if (it->second.width != buffer->BufferWi || it->second.height != buffer->BufferHt) return false;
+            if (it->second.geometry != HashGeometry(buffer)) return false;
+            it->second.geometryChecked = true;
         }
     }
 
@@ -491,10 +1031,14 @@ bool RenderCacheItem::IsMatch(Effect* effect, RenderBuffer* buffer)
 
 void RenderCacheItem::Delete()
 {
-    if (!_purged && wxFile::Exists(_cacheFile)) {
+    _renderCache->CancelIO(this, false);
+    // the file must be unmapped before it can be removed on windows
+    bool purged = _purged;
+    ReleaseFrames();
+    if (!purged && wxFile::Exists(_cacheFile)) {
         wxRemoveFile(_cacheFile);
+        _renderCache->UnindexItem(_cacheFile);
     }
-    PurgeFrames();
     _renderCache->RemoveItem(this);
 }
 
@@ -506,16 +1050,30 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
         logger_base.error("RenderCacheItem::AddFrame was passed a null buffer");
         return;
     }
-    
+
     if (buffer->pixels.size() == 0)
     {
         logger_base.error("RenderCacheItem::AddFrame was passed a buffer with no pixels in it");
         return;
     }
 
+    {
+        std::unique_lock<std::recursive_mutex> lock(_lock);
+        if (!AddFrameLocked(buffer)) return;
+    }
+
+    // written by the io thread, not held while queuing as the io thread may need it
+    _renderCache->QueueSave(this);
+}
+
+// returns true when every model has its last frame and the item can be saved
+bool RenderCacheItem::AddFrameLocked(RenderBuffer* buffer)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
     if (_purged)
     {
-        return;
+        return false;
     }
 
     // allow up to 3 times physical memory
@@ -523,156 +1081,404 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
     if (IsExcessiveMemoryUsage(3.0))
     {
         logger_base.error("RenderCacheItem::AddFrame failed memory available test. This is a bad sign. Rendering will be really slow.");
-        PurgeFrames();
+        ReleaseFrames();
         wxASSERT(false);
-        return;
+        return false;
     }
 
     int frame = buffer->curPeriod - buffer->curEffStartPer;
 
     std::string mname = GetModelName(buffer);
-    if (_frameSize.find(mname) == _frameSize.end())
+    long frameSize = sizeof(xlColor) * buffer->pixels.size();
+    auto mit = _models.find(mname);
+    if (mit == _models.end())
     {
-        _frameSize[mname] = sizeof(xlColor) * buffer->pixels.size();
+        mit = _models.insert(std::make_pair(mname, ModelFrames())).first;
+        mit->second.width = buffer->BufferWi;
+        mit->second.height = buffer->BufferHt;
+        mit->second.frameSize = frameSize;
+        mit->second.geometry = HashGeometry(buffer);
+        mit->second.geometryChecked = true;
     }
     else
     {
-        if (_frameSize[mname] != sizeof(xlColor) * buffer->pixels.size())
+        if (mit->second.frameSize != frameSize)
         {
             // the buffer size has changed ... we dont support this.
             logger_base.warn("RenderCacheItem::AddFrame buffer size changed ... we dont support this.");
-            PurgeFrames();
-            return;
+            ReleaseFrames();
+            return false;
         }
     }
+    ModelFrames& mf = mit->second;
 
-    if (_frames.find(mname) == _frames.end())
-    {
-        std::vector<unsigned char *> n;
-        _frames[mname] = n;
-    }
-
-    if (frame >= _frames.at(mname).size()) {
+    if (frame >= mf.frames.size()) {
         int maxframe = buffer->curEffEndPer - buffer->curEffStartPer + 1;
-        _frames.at(mname).resize(maxframe);
+        mf.frames.resize(maxframe);
+        mf.compressed.resize(maxframe);
+        mf.compressedSize.resize(maxframe);
     }
 
-    unsigned char* frameBuffer = (unsigned char *)malloc(_frameSize.at(mname));
+    unsigned char* frameBuffer = (unsigned char *)malloc(frameSize);
     if (frameBuffer == nullptr)
     {
         logger_base.warn("RenderCacheItem::AddFrame failed to allocate frameBuffer.");
-        PurgeFrames();
+        ReleaseFrames();
         wxASSERT(false);
-        return;
+        return false;
     }
-    memcpy(frameBuffer, &buffer->pixels[0], _frameSize.at(mname));
+    memcpy(frameBuffer, &buffer->pixels[0], frameSize);
 
-    if (_frames.at(mname)[frame] != nullptr) {
-        free(_frames.at(mname)[frame]);
-        _frames.at(mname)[frame] = nullptr;
+    if (mf.frames[frame] != nullptr) {
+        free(mf.frames[frame]);
+        mf.frames[frame] = nullptr;
     }
 
-    _frames.at(mname)[frame] = frameBuffer;
+    mf.frames[frame] = frameBuffer;
     _dirty = true;
 
     if (buffer->curPeriod == buffer->curEffEndPer)
     {
-        // if multi models in this cache then only call save when none of them have null pointers at the end
-        for (auto itm : _frames)
+        // if multi models in this cache then only call save when none of them are missing the last frame
+        for (const auto& itm : _models)
         {
-            if (itm.second.back() == nullptr)
+            if (itm.second.frames.empty() || (itm.second.frames.back() == nullptr && (!MapFile() || itm.second.compressed.back() == nullptr)))
             {
                 //logger_base.warn("RenderCacheItem::AddFrame save abandoned due to null frame.");
-                return;
+                return false;
             }
         }
-
-        Save();
+        return true;
     }
+    return false;
 }
 
 bool RenderCacheItem::GetFrame(RenderBuffer* buffer)
+{
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    if (GetFrameLocked(buffer))
+    {
+        _renderCache->AddHit();
+        return true;
+    }
+    _renderCache->AddMiss();
+    return false;
+}
+
+bool RenderCacheItem::GetFrameLocked(RenderBuffer* buffer)
 {
     std::string mname = GetModelName(buffer);
-    if (_frameSize.find(mname) == _frameSize.end()) return false;
+    auto mit = _models.find(mname);
+    if (mit == _models.end()) return false;
 
-    auto modelFrames = _frames[mname];
-    if (_frameSize.at(mname) != (sizeof(xlColor) * buffer->pixels.size()))
+    ModelFrames& mf = mit->second;
+    if (mf.frameSize != (long)(sizeof(xlColor) * buffer->pixels.size()))
     {
         return false;
     }
 
+    if (!mf.geometryChecked)
+    {
+        if (mf.geometry != HashGeometry(buffer))
+        {
+            // the model has changed shape since these frames were rendered so
+            // throw them away, they are added back as the model renders
+            for (auto& f : mf.frames)
+            {
+                if (f) free(f);
+            }
+            _models.erase(mit);
+            _dirty = true;
+            return false;
+        }
+        mf.geometryChecked = true;
+    }
+
     int frame = buffer->curPeriod - buffer->curEffStartPer;
+    if (frame < 0 || frame >= mf.frames.size()) return false;
 
-    if (frame < modelFrames.size() && modelFrames[frame]) {
+    if (mf.frames[frame]) {
         // its in memory ... read it from there
-        unsigned char* pc = modelFrames[frame];
-        memcpy(&buffer->pixels[0], pc, _frameSize.at(mname));
+        memcpy(&buffer->pixels[0], mf.frames[frame], mf.frameSize);
         return true;
     }
 
+    if (!MapFile() || mf.compressed[frame] == nullptr) return false;
+
+    _renderCache->AddBytesRead(mf.compressedSize[frame]);
+    if (mf.compressedSize[frame] == mf.frameSize)
+    {
+        memcpy(&buffer->pixels[0], mf.compressed[frame], mf.frameSize);
+        return true;
+    }
+#ifndef NO_ZSTD
+    size_t sz = ZSTD_decompress(&buffer->pixels[0], mf.frameSize, mf.compressed[frame], mf.compressedSize[frame]);
+    return !ZSTD_isError(sz) && sz == mf.frameSize;
+#else
     return false;
+#endif
+}
+
+void RenderCacheItem::Prefetch()
+{
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    if (!_purged && MapFile())
+    {
+        _mapped->WillNeed();
+    }
+}
+
+size_t RenderCacheItem::GetRenderedSize() const
+{
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    size_t size = 0;
+    for (const auto& itm : _models)
+    {
+        for (auto it : itm.second.frames)
+        {
+            if (it != nullptr) size += itm.second.frameSize;
+        }
+    }
+    return size;
+}
+
+void RenderCacheItem::WriteHeader(std::vector<unsigned char>& out) const
+{
+    WriteU64(out, _key);
+    WriteU32(out, (uint32_t)_properties.size());
+    for (const auto& it : _properties)
+    {
+        WriteString(out, it.first);
+        WriteString(out, it.second);
+    }
+    WriteU32(out, (uint32_t)_models.size());
+    for (const auto& it : _models)
+    {
+        WriteString(out, it.first);
+        WriteU32(out, (uint32_t)it.second.width);
+        WriteU32(out, (uint32_t)it.second.height);
+        WriteU32(out, (uint32_t)it.second.frameSize);
+        WriteU64(out, it.second.geometry);
+        WriteU32(out, (uint32_t)it.second.frames.size());
+    }
+}
+
+bool RenderCacheItem::ParseHeader(const unsigned char* data, size_t len, size_t& pos,
+                                  uint64_t& key, std::map<std::string, std::string>& properties, std::map<std::string, ModelFrames>& models)
+{
+    properties.clear();
+    models.clear();
+
+    uint32_t count = 0;
+    if (!ReadU64(data, len, pos, key) || !ReadU32(data, len, pos, count)) return false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::string name;
+        std::string value;
+        if (!ReadString(data, len, pos, name) || !ReadString(data, len, pos, value) || name == "") return false;
+        properties[name] = value;
+    }
+
+    if (!ReadU32(data, len, pos, count)) return false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::string model;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t frameSize = 0;
+        uint64_t geometry = 0;
+        uint32_t frames = 0;
+        if (!ReadString(data, len, pos, model) ||
+            !ReadU32(data, len, pos, width) || !ReadU32(data, len, pos, height) ||
+            !ReadU32(data, len, pos, frameSize) || !ReadU64(data, len, pos, geometry) ||
+            !ReadU32(data, len, pos, frames))
+        {
+            return false;
+        }
+        ModelFrames& mf = models[model];
+        mf.width = (int)width;
+        mf.height = (int)height;
+        mf.frameSize = frameSize;
+        mf.geometry = geometry;
+        mf.frames.resize(frames);
+        mf.compressed.resize(frames);
+        mf.compressedSize.resize(frames);
+    }
+    return true;
+}
+
+// Maps the cache file and points the frames that aren't in memory at their
+// compressed data in it.
+bool RenderCacheItem::MapFile()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_mapped) return true;
+    if (_purged || !wxFile::Exists(_cacheFile)) return false;
+
+    std::unique_ptr<RenderCacheMappedFile> mapped(new RenderCacheMappedFile());
+    if (!mapped->Open(_cacheFile)) return false;
+
+    const unsigned char* data = mapped->Data();
+    size_t len = mapped->Size();
+    size_t pos = 4;
+    uint32_t version = 0;
+    uint32_t headerSize = 0;
+    uint64_t key = 0;
+    if (len < 4 || memcmp(data, RENDER_CACHE_MAGIC, 4) != 0 ||
+        !ReadU32(data, len, pos, version) || version != RENDER_CACHE_VERSION ||
+        !ReadU32(data, len, pos, headerSize))
+    {
+        logger_base.warn("Cache file %s appears corrupt.", (const char*)_cacheFile.c_str());
+        return false;
+    }
+    // models may have been added since the file was written so the frame table
+    // is walked using the file's own header
+    std::map<std::string, std::string> properties;
+    std::map<std::string, ModelFrames> models;
+    size_t headerEnd = pos + headerSize;
+    if (!ParseHeader(data, std::min(len, headerEnd), pos, key, properties, models) || key != _key)
+    {
+        // the file was rewritten since it was indexed
+        logger_base.warn("Cache file %s no longer matches its index.", (const char*)_cacheFile.c_str());
+        return false;
+    }
+    pos = headerEnd;
+
+    for (const auto& it : models)
+    {
+        auto mit = _models.find(it.first);
+        bool use = mit != _models.end() && mit->second.frameSize == it.second.frameSize && mit->second.geometry == it.second.geometry && mit->second.frames.size() == it.second.frames.size();
+        for (size_t f = 0; f < it.second.frames.size(); f++)
+        {
+            uint64_t offset = 0;
+            uint32_t size = 0;
+            if (!ReadU64(data, len, pos, offset) || !ReadU32(data, len, pos, size) || offset + size > len)
+            {
+                logger_base.warn("Cache file %s appears truncated.", (const char*)_cacheFile.c_str());
+                Unmap();
+                return false;
+            }
+            if (use)
+            {
+                mit->second.compressed[f] = &data[offset];
+                mit->second.compressedSize[f] = size;
+            }
+        }
+    }
+
+    _mapped = std::move(mapped);
+    return true;
 }
 
 void RenderCacheItem::Save()
 {
+    std::unique_lock<std::recursive_mutex> lock(_lock);
     if (_purged) return;
     if (!_dirty) return;
 
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     //logger_base.debug("Saving render cache file %s.", (const char *)_cacheFile.c_str());
 
-    char zero = 0x00;
-
-    // check all the data is there
-    for (auto itm = _frames.begin(); itm != _frames.end(); ++itm)
+    // check all the data is there, frames not rendered this time must come from the existing file
+    bool needFile = false;
+    for (const auto& itm : _models)
     {
-        for (auto it = itm->second.begin(); it != itm->second.end(); ++it)
+        for (auto it : itm.second.frames)
+        {
+            if (it == nullptr) needFile = true;
+        }
+    }
+    if (needFile && !MapFile()) return;
+    long maxFrameSize = 0;
+    for (const auto& itm : _models)
+    {
+        for (size_t f = 0; f < itm.second.frames.size(); f++)
         {
             // we are missing data
             //wxASSERT(false);
-            if (*it == nullptr) return;
+            if (itm.second.frames[f] == nullptr && itm.second.compressed[f] == nullptr) return;
         }
+        maxFrameSize = std::max(maxFrameSize, itm.second.frameSize);
     }
 
-    wxFile file;
+    std::vector<unsigned char> header;
+    WriteHeader(header);
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), RENDER_CACHE_MAGIC, RENDER_CACHE_MAGIC + 4);
+    WriteU32(out, RENDER_CACHE_VERSION);
+    WriteU32(out, (uint32_t)header.size());
+    out.insert(out.end(), header.begin(), header.end());
+
+    size_t tablePos = out.size();
+    for (const auto& itm : _models)
+    {
+        out.resize(out.size() + itm.second.frames.size() * (sizeof(uint64_t) + sizeof(uint32_t)));
+    }
 
-    if (file.Create(_cacheFile, true))
+#ifndef NO_ZSTD
+    std::vector<unsigned char> scratch(ZSTD_compressBound(maxFrameSize));
+#endif
+    for (const auto& itm : _models)
     {
-        _properties["Models"] = wxString::Format("%d", (int)_frames.size());
-        // write the header fields
-        for (auto it = _properties.begin(); it != _properties.end(); ++it)
+        const ModelFrames& mf = itm.second;
+        for (size_t f = 0; f < mf.frames.size(); f++)
         {
-            file.Write(it->first);
-            file.Write(&zero, 1);
-            file.Write(it->second);
-            file.Write(&zero, 1);
+            uint64_t offset = out.size();
+            uint32_t size = 0;
+            if (mf.frames[f] != nullptr)
+            {
+                size = mf.frameSize;
+#ifndef NO_ZSTD
+                // mostly dark or flat frames shrink a lot even at the fastest level
+                size_t csz = ZSTD_compress(&scratch[0], scratch.size(), mf.frames[f], mf.frameSize, 1);
+                if (!ZSTD_isError(csz) && csz < (size_t)mf.frameSize)
+                {
+                    size = csz;
+                    out.insert(out.end(), scratch.begin(), scratch.begin() + csz);
+                }
+                else
+#endif
+                {
+                    out.insert(out.end(), mf.frames[f], mf.frames[f] + mf.frameSize);
+                }
+            }
+            else
+            {
+                size = mf.compressedSize[f];
+                out.insert(out.end(), mf.compressed[f], mf.compressed[f] + size);
+            }
+            memcpy(&out[tablePos], &offset, sizeof(offset));
+            tablePos += sizeof(offset);
+            memcpy(&out[tablePos], &size, sizeof(size));
+            tablePos += sizeof(size);
         }
+    }
 
-        file.Write("RC_HEADEREND");
-        file.Write(&zero, 1);
+    // the old view has to go before the file can be replaced
+    Unmap();
 
-        for (auto it = _frames.begin(); it != _frames.end(); ++it)
-        {
-            file.Write(it->first);
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%d", (int)it->second.size()));
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%ld", _frameSize.at(it->first)));
-            file.Write(&zero, 1);
-        }
+    wxFile file;
+
+    if (file.Create(_cacheFile, true) && file.Write(&out[0], out.size()) == out.size())
+    {
+        file.Close();
+        _dirty = false;
+        _renderCache->IndexItem(_cacheFile, out.size(), header);
+        _renderCache->AddBytesWritten(out.size());
 
-        // write the frames
-        for (auto itm = _frames.begin(); itm != _frames.end(); ++itm)
+        // everything is in the file now so the rendered frames can be released, they are read back on demand
+        for (auto& itm : _models)
         {
-            for (auto it = itm->second.begin(); it != itm->second.end(); ++it)
+            for (auto& it : itm.second.frames)
             {
-                wxASSERT(*it != nullptr);
-                file.Write(*it, _frameSize.at(itm->first));
+                if (it != nullptr) {
+                    free(it);
+                    it = nullptr;
+                }
             }
         }
-
-        file.Close();
     }
     else
     {
@@ -684,89 +1490,71 @@ bool RenderCacheItem::IsDone(RenderBuffer* buffer) const
 {
     int frame = buffer->curPeriod - buffer->curEffStartPer;
     std::string mname = GetModelName(buffer);
-    auto modelFrames = _frames.at(mname);
-    return modelFrames[frame];
+    const ModelFrames& mf = _models.at(mname);
+    return mf.frames[frame] != nullptr || mf.compressed[frame] != nullptr;
 }
 
-RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& filename) : _renderCache(renderCache)
+RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& filename, const std::vector<unsigned char>& header) : _renderCache(renderCache)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
     _cacheFile = filename;
-    wxFileName fn(_cacheFile);
     _purged = false;
     _dirty = false;
+    _key = 0;
 
-    wxFile file;
-
-    if (file.Open(_cacheFile)) {
-        char headerBuffer[8192];
-        memset(headerBuffer, 0x00, sizeof(headerBuffer));
-        file.Read(headerBuffer, sizeof(headerBuffer));
-
-        char* ps = headerBuffer;
+    size_t pos = 0;
+    if (header.empty() || !ParseHeader(&header[0], header.size(), pos, _key, _properties, _models))
+    {
+        logger_base.debug("Cache index entry for %s appears corrupt.", (const char*)filename.c_str());
+        _purged = true;
+        return;
+    }
+    _renderCache->IndexItem(_cacheFile, wxFileName::GetSize(_cacheFile).GetValue(), header);
+}
 
-        while (strcmp(ps, "RC_HEADEREND") != 0) {
-            std::string key(ps);
-            ps += strlen(ps) + 1;
-            std::string value(ps);
-            ps += strlen(ps) + 1;
+RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& filename) : _renderCache(renderCache)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-            if (key == "")
-            {
-                // file looks corrupt
-                logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
-                _purged = true;
-                return;
-            }
-            else
-            {
-                _properties[key] = value;
-            }
-        }
-        ps += strlen(ps) + 1;
+    _cacheFile = filename;
+    _purged = false;
+    _dirty = false;
+    _key = 0;
 
-        int models = wxAtoi(_properties["Models"]);
+    wxFile file;
 
-        for (int i = 0; i < models; i++)
+    if (file.Open(_cacheFile)) {
+        // only the header is read, frames are mapped when they are needed
+        unsigned char prefix[12];
+        uint32_t version = 0;
+        uint32_t headerSize = 0;
+        size_t pos = 4;
+        if (file.Read(prefix, sizeof(prefix)) != sizeof(prefix) || memcmp(prefix, RENDER_CACHE_MAGIC, 4) != 0 ||
+            !ReadU32(prefix, sizeof(prefix), pos, version) || version != RENDER_CACHE_VERSION ||
+            !ReadU32(prefix, sizeof(prefix), pos, headerSize))
         {
-            std::string model(ps);
-            ps += strlen(ps) + 1;
-            std::string frames(ps);
-            ps += strlen(ps) + 1;
-            int fs = wxAtoi(frames);
-            std::string frameSize(ps);
-            ps += strlen(ps) + 1;
-            long fsz = wxAtol(frameSize);
-
-            std::vector<unsigned char *> n;
-            _frames[model] = n;
-            _frames.at(model).resize(fs);
-            _frameSize[model] = fsz;
+            logger_base.debug("Cache file %s is not a current format cache file.", (const char*)filename.c_str());
+            _purged = true;
+            return;
         }
 
-        long firstFrameOffset = ps - headerBuffer;
-
-        file.Seek(firstFrameOffset);
-
-        for (auto itm = _frames.begin(); itm != _frames.end(); ++itm)
+        std::vector<unsigned char> header(headerSize);
+        pos = 0;
+        if (headerSize == 0 || file.Read(&header[0], headerSize) != headerSize || !ParseHeader(&header[0], header.size(), pos, _key, _properties, _models))
         {
-            for (int i = 0; i < itm->second.size(); i++) {
-                unsigned char* frameBuffer = (unsigned char *)malloc(_frameSize.at(itm->first));
-
-                if (frameBuffer == nullptr)
-                {
-                    file.Close();
-                    PurgeFrames();
-                    return;
-                }
-
-                file.Read(frameBuffer, _frameSize.at(itm->first));
-                itm->second[i] = frameBuffer;
-            }
+            // file looks corrupt
+            logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
+            _purged = true;
+            return;
         }
 
         file.Close();
+        _renderCache->IndexItem(_cacheFile, wxFileName::GetSize(_cacheFile).GetValue(), header);
+    }
+    else
+    {
+        _purged = true;
     }
 }
 #pragma endregion RenderCacheItem
@@ -6,25 +6,59 @@
 #include <map>
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 class Effect;
 class RenderCache;
 class SequenceElements;
 class RenderBuffer;
 class RenderCacheLoadThread;
+class RenderCacheMappedFile;
 
 class RenderCacheItem
 {
+    // frames rendered this session are held raw until saved, frames loaded
+    // from the cache file are decompressed straight out of the mapped file
+    struct ModelFrames
+    {
+        int width = 0;
+        int height = 0;
+        long frameSize = 0;
+        // digest of where each node sits in the buffer, checked against the
+        // model the first time its frames are used
+        uint64_t geometry = 0;
+        bool geometryChecked = false;
+        std::vector<unsigned char *> frames;
+        std::vector<const unsigned char *> compressed;
+        std::vector<uint32_t> compressedSize;
+    };
+
     RenderCache* _renderCache;
     std::string _cacheFile;
+    uint64_t _key;
     std::map<std::string, std::string> _properties;
-    std::map<std::string, std::vector<unsigned char *>> _frames;
-    std::map<std::string, long> _frameSize;
+    std::map<std::string, ModelFrames> _models;
+    std::unique_ptr<RenderCacheMappedFile> _mapped;
+    // the cache io thread saves and prefetches while the render threads use the item
+    mutable std::recursive_mutex _lock;
     bool _purged;
     bool _dirty;
     static std::string GetModelName(RenderBuffer* buffer);
+    static bool ParseHeader(const unsigned char* data, size_t len, size_t& pos,
+                            uint64_t& key, std::map<std::string, std::string>& properties, std::map<std::string, ModelFrames>& models);
+    void WriteHeader(std::vector<unsigned char>& out) const;
+    bool MapFile();
+    void Unmap();
+    void ReleaseFrames();
+    bool AddFrameLocked(RenderBuffer* buffer);
+    bool GetFrameLocked(RenderBuffer* buffer);
 
 public:
+    RenderCacheItem(RenderCache* renderCache, const std::string& file, const std::vector<unsigned char>& header);
     RenderCacheItem(RenderCache* renderCache, const std::string& file);
     RenderCacheItem(RenderCache* renderCache, Effect* effect, RenderBuffer* buffer);
     virtual ~RenderCacheItem();
@@ -33,21 +67,65 @@ public:
     void PurgeFrames();
     bool IsPurged() const { return _purged; }
     bool IsMatch(Effect* effect, RenderBuffer* buffer);
+    bool IsMatch(Effect* effect, RenderBuffer* buffer, uint64_t key);
     void Delete();
     void Save();
+    void Prefetch();
+    size_t GetRenderedSize() const;
     bool IsDone(RenderBuffer* buffer) const;
+    uint64_t GetKey() const { return _key; }
+    const std::string& GetCacheFile() const { return _cacheFile; }
+
+    // 64 bit hash of everything that affects what the effect renders
+    static uint64_t HashEffect(Effect* effect);
+    static uint64_t HashGeometry(RenderBuffer* buffer);
 };
 
 class RenderCache
 {
+    friend class RenderCacheLoadThread;
+
+    // what the index file records about each cache file so loading doesn't have to open them
+    struct IndexEntry
+    {
+        uint64_t size = 0;
+        std::vector<unsigned char> header;
+    };
+
     std::recursive_mutex  _cacheLock;
 	std::string _cacheFolder;
 	std::list<RenderCacheItem*> _cache;
     std::string _enabled; // Disabled | Locked Only | Enabled
     std::mutex _loadMutex;
+    size_t _maxSize;
+    std::map<std::string, IndexEntry> _index;
+    std::mutex _indexLock;
+
+    // io thread that reads ahead of the render and writes behind it
+    std::thread _ioThread;
+    std::mutex _ioLock;
+    std::condition_variable _ioSignal;
+    std::condition_variable _ioDone;
+    std::list<RenderCacheItem*> _prefetchQueue;
+    std::list<RenderCacheItem*> _saveQueue;
+    RenderCacheItem* _ioItem;
+    size_t _pendingSaveBytes;
+    bool _ioExit;
+
+    std::atomic_int _statHits;
+    std::atomic_int _statMisses;
+    std::atomic_int _statPrefetches;
+    std::atomic<uint64_t> _statBytesRead;
+    std::atomic<uint64_t> _statBytesWritten;
+    std::atomic<uint64_t> _statWriteStallUS;
 
     void Close();
     void LoadCache();
+    void ReadIndex(std::map<std::string, IndexEntry>& index) const;
+    void SaveIndex();
+    void StartIOThread();
+    void StopIOThread();
+    void IOThread();
 
     public:
 		RenderCache();
@@ -57,12 +135,34 @@ class RenderCache
 		RenderCacheItem* GetItem(Effect* effect, RenderBuffer* buffer);
         void RemoveItem(RenderCacheItem *item);
         std::string GetCacheFolder() const { return _cacheFolder; }
+        std::string GetIndexFile() const;
         void CleanupCache(SequenceElements* sequenceElements);
         void Purge(SequenceElements* sequenceElements, bool dodelete);
         void Enable(std::string enabled) { _enabled = enabled; }
+        // cap on the size of all the render caches in the show folder, 0 is unlimited
+        void SetMaxSize(size_t bytes) { _maxSize = bytes; }
+        size_t GetMaxSize() const { return _maxSize; }
+        void EnforceMaxSize();
         std::mutex& GetLoadMutex() { return _loadMutex; }
         void AddCacheItem(RenderCacheItem* rci);
+        void IndexItem(const std::string& file, uint64_t size, const std::vector<unsigned char>& header);
+        void UnindexItem(const std::string& file);
         bool IsEffectOkForCaching(Effect* effect) const;
+
+        // asks the io thread to read an item in before the render reaches it
+        void Prefetch(Effect* effect);
+        void QueuePrefetch(RenderCacheItem* item);
+        // saves the item on the io thread, blocks only if too much is already waiting to be written
+        void QueueSave(RenderCacheItem* item);
+        // takes the item out of the io queues, saving it now if it was waiting to be saved and save is true
+        void CancelIO(RenderCacheItem* item, bool save);
+        void FlushSaves();
+
+        void AddHit() { ++_statHits; }
+        void AddMiss() { ++_statMisses; }
+        void AddBytesRead(uint64_t bytes) { _statBytesRead += bytes; }
+        void AddBytesWritten(uint64_t bytes) { _statBytesWritten += bytes; }
+        void LogStats();
 };
 
 #endif // RENDERCACHE_H
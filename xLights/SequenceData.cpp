@@ -7,40 +7,366 @@
 //#include <cstddef>
 
 #include <wx/wx.h>
+#include <wx/filename.h>
 
 #include "SequenceData.h"
 #include "UtilFunctions.h"
 
 #include <log4cpp/Category.hh>
 
+#ifndef NO_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 const unsigned char FrameData::_constzero = 0;
 
-SequenceData::SequenceData() {
+// default budget, xLightsFrame replaces this with the user's setting
+size_t SequenceData::_memoryBudget = (size_t)2048 * 1024 * 1024;
+bool SequenceData::_compressPages = false;
+
+// size of the pages of frames the paged data is tracked in
+#define SEQUENCE_DATA_PAGE_SIZE (4 * 1024 * 1024)
+
+SequenceData::SequenceData() : _residentPages(0), _pageEpoch(0) {
     _data = nullptr;
     _invalidData = nullptr;
     _numFrames = 0;
     _numChannels = 0;
     _bytesPerFrame = 0;
     _frameTime = 50;
+    _mapped = false;
+    _compressed = false;
+    _compressedBytes = 0;
+#ifdef __WXMSW__
+    _mapFile = INVALID_HANDLE_VALUE;
+    _mapHandle = nullptr;
+#else
+    _mapFile = -1;
+#endif
+    _mappedSize = 0;
+    _framesPerPage = 1;
+    _numPages = 0;
+    _maxResidentPages = 0;
 }
 
 SequenceData::~SequenceData() {
-    if (_data != nullptr) {
-        free(_data);
-    }
+    FreeData();
     if (_invalidData != nullptr) {
         free(_invalidData);
     }
 }
 
-void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4) {
+void SequenceData::FreeData() {
+    if (_data != nullptr) {
+        if (_compressed) {
+#ifdef __WXMSW__
+            VirtualFree(_data, 0, MEM_RELEASE);
+#else
+            munmap(_data, _mappedSize);
+#endif
+        } else if (_mapped) {
+#ifdef __WXMSW__
+            UnmapViewOfFile(_data);
+            CloseHandle(_mapHandle);
+            CloseHandle(_mapFile);
+            _mapHandle = nullptr;
+            _mapFile = INVALID_HANDLE_VALUE;
+#else
+            munmap(_data, _mappedSize);
+            close(_mapFile);
+            _mapFile = -1;
+#endif
+        } else {
+            free(_data);
+        }
+        _data = nullptr;
+    }
+    _mapped = false;
+    _compressed = false;
+    _mappedSize = 0;
+    _numPages = 0;
+    _pageLastUsed.reset();
+    _pageResident.reset();
+    _pageDirty.reset();
+    _pagePins.reset();
+    _pageCompressed.reset();
+    _compressedBytes = 0;
+    _residentPages = 0;
+}
 
+// Backs the frame data with a scratch file that is deleted when closed.  A new
+// file reads as zeros, same as calloc.
+bool SequenceData::MapData(size_t sz) {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    if (_data != nullptr) {
-        free(_data);
-        _data = nullptr;
+    wxString fn = wxFileName::CreateTempFileName(wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "xLightsSeqData");
+    if (fn == "") {
+        logger_base.warn("Could not create scratch file for sequence data.");
+        return false;
+    }
+#ifdef __WXMSW__
+    HANDLE file = CreateFileW(fn.wc_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        logger_base.warn("Could not open scratch file %s for sequence data.", (const char *)fn.c_str());
+        return false;
+    }
+    HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)sz >> 32), (DWORD)(sz & 0xFFFFFFFF), nullptr);
+    void *data = mapping == nullptr ? nullptr : MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sz);
+    if (data == nullptr) {
+        logger_base.warn("Could not map scratch file %s for sequence data.", (const char *)fn.c_str());
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    _mapFile = file;
+    _mapHandle = mapping;
+#else
+    int file = open(fn.c_str(), O_RDWR);
+    // the file goes away as soon as we close it
+    unlink(fn.c_str());
+    if (file < 0) {
+        logger_base.warn("Could not open scratch file %s for sequence data.", (const char *)fn.c_str());
+        return false;
+    }
+    void *data = MAP_FAILED;
+    if (ftruncate(file, sz) == 0) {
+        data = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    if (data == MAP_FAILED) {
+        logger_base.warn("Could not map scratch file %s for sequence data.", (const char *)fn.c_str());
+        close(file);
+        return false;
+    }
+    _mapFile = file;
+#endif
+    _data = (unsigned char *)data;
+    _mapped = true;
+    _mappedSize = sz;
+    InitPages(sz);
+    logger_base.debug("Sequence data paged to %s. Pages=%u, FramesPerPage=%u, MaxResidentPages=%u.",
+                      (const char *)fn.c_str(), _numPages, _framesPerPage, _maxResidentPages);
+    return true;
+}
+
+// Reserves address space for the frame data without a file behind it.  Pages
+// that are evicted are compressed into _pageCompressed and their memory
+// released, which reads back as zeros until the page is decompressed again.
+bool SequenceData::AllocCompressedData(size_t sz) {
+#ifdef NO_ZSTD
+    return false;
+#else
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+#ifdef __WXMSW__
+    void *data = VirtualAlloc(nullptr, sz, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (data == nullptr) {
+#else
+    void *data = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+#endif
+        logger_base.warn("Could not reserve %ld bytes for compressed sequence data.", sz);
+        return false;
+    }
+    _data = (unsigned char *)data;
+    _mapped = true;
+    _compressed = true;
+    _mappedSize = sz;
+    InitPages(sz);
+    _pageCompressed.reset(new std::vector<unsigned char>[_numPages]);
+    _pagePins.reset(new std::atomic_int[_numPages]);
+    for (unsigned int x = 0; x < _numPages; x++) {
+        _pagePins[x] = 0;
+    }
+    logger_base.debug("Sequence data compressed in memory. Pages=%u, FramesPerPage=%u, MaxResidentPages=%u.",
+                      _numPages, _framesPerPage, _maxResidentPages);
+    return true;
+#endif
+}
+
+void SequenceData::InitPages(size_t sz) {
+    _framesPerPage = std::max(1u, (unsigned int)(SEQUENCE_DATA_PAGE_SIZE / _bytesPerFrame));
+    _numPages = (_numFrames + _framesPerPage - 1) / _framesPerPage;
+    size_t pageBytes = (size_t)_framesPerPage * _bytesPerFrame;
+    _maxResidentPages = std::max((size_t)2, _memoryBudget / pageBytes);
+    _pageLastUsed.reset(new std::atomic_uint[_numPages]);
+    _pageResident.reset(new std::atomic_bool[_numPages]);
+    _pageDirty.reset(new std::atomic_bool[_numPages]);
+    for (unsigned int x = 0; x < _numPages; x++) {
+        _pageLastUsed[x] = 0;
+        _pageResident[x] = false;
+        _pageDirty[x] = false;
+    }
+    _residentPages = 0;
+    _pageEpoch = 0;
+    _compressedBytes = 0;
+}
+
+void SequenceData::PageIn(unsigned int page) const {
+    std::unique_lock<std::mutex> lock(_pageLock);
+    if (_pageResident[page]) {
+        return;
+    }
+    if (_compressed) {
+        // must be complete before the page is flagged resident as other
+        // threads don't take the lock once it is
+        DecompressPage(page);
+    }
+    _pageLastUsed[page] = ++_pageEpoch;
+    _pageResident[page].store(true, std::memory_order_release);
+    if (++_residentPages <= _maxResidentPages) {
+        return;
+    }
+
+    // evict the least recently used pages, a few at a time so we aren't
+    // scanning the pages on every new page touched
+    unsigned int target = _maxResidentPages - std::max(1u, _maxResidentPages / 8);
+    while (_residentPages > target) {
+        unsigned int oldest = _numPages;
+        for (unsigned int x = 0; x < _numPages; x++) {
+            if (x != page && _pageResident[x] && (!_compressed || _pagePins[x] == 0) &&
+                (oldest == _numPages || _pageLastUsed[x] < _pageLastUsed[oldest])) {
+                oldest = x;
+            }
+        }
+        if (oldest == _numPages) {
+            break;
+        }
+        if (_compressed) {
+            // compressing changes the memory in place so nobody can be using it
+            _pageResident[oldest] = false;
+            if (_pagePins[oldest] != 0) {
+                _pageResident[oldest] = true;
+                break;
+            }
+            if (_pageDirty[oldest] || _pageCompressed[oldest].empty()) {
+                CompressPage(oldest);
+            }
+        }
+        _pageDirty[oldest] = false;
+        PageOut(oldest);
+        _pageResident[oldest] = false;
+        --_residentPages;
+    }
+}
+
+// Hands a page's memory back to the OS.  The mapping stays valid, the data is
+// written to the scratch file and read back in when the page is next touched.
+// Only whole OS pages inside the page of frames are released as the ones on
+// the boundary are shared with the neighbouring page.
+void SequenceData::PageOut(unsigned int page) const {
+    static size_t osPageSize = 0;
+    if (osPageSize == 0) {
+#ifdef __WXMSW__
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        osPageSize = si.dwPageSize;
+#else
+        osPageSize = sysconf(_SC_PAGESIZE);
+#endif
+    }
+    size_t start = (size_t)page * _framesPerPage * _bytesPerFrame;
+    size_t end = std::min(start + (size_t)_framesPerPage * _bytesPerFrame, _mappedSize);
+    start = (start + osPageSize - 1) / osPageSize * osPageSize;
+    end = end / osPageSize * osPageSize;
+    if (end <= start) {
+        return;
+    }
+#ifdef __WXMSW__
+    if (_compressed) {
+        VirtualFree(&_data[start], end - start, MEM_DECOMMIT);
+        VirtualAlloc(&_data[start], end - start, MEM_COMMIT, PAGE_READWRITE);
+    } else {
+        // removes the pages from the working set, unlocking pages that aren't locked is documented to do this
+        VirtualUnlock(&_data[start], end - start);
+    }
+#else
+    if (!_compressed) {
+        msync(&_data[start], end - start, MS_ASYNC);
+    }
+    // anonymous memory reads back as zeros after this and takes no space until written
+    madvise(&_data[start], end - start, MADV_DONTNEED);
+#endif
+}
+
+// Each frame is stored as the XOR against the frame before it so unchanged
+// channels become runs of zeros, then the page is zstd compressed.  The delta
+// is done in place, working backwards, as the memory is released straight after.
+void SequenceData::CompressPage(unsigned int page) const {
+#ifndef NO_ZSTD
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    unsigned int firstFrame = page * _framesPerPage;
+    unsigned int frames = std::min(_framesPerPage, _numFrames - firstFrame);
+    unsigned char *data = &_data[(size_t)firstFrame * _bytesPerFrame];
+    size_t len = (size_t)frames * _bytesPerFrame;
+    for (unsigned int f = frames - 1; f > 0; f--) {
+        unsigned char *cur = &data[(size_t)f * _bytesPerFrame];
+        const unsigned char *prev = cur - _bytesPerFrame;
+        for (unsigned int c = 0; c < _bytesPerFrame; c++) {
+            cur[c] ^= prev[c];
+        }
+    }
+
+    std::vector<unsigned char> &out = _pageCompressed[page];
+    _compressedBytes -= out.size();
+    out.resize(ZSTD_compressBound(len));
+    size_t csz = ZSTD_compress(&out[0], out.size(), data, len, 1);
+    if (ZSTD_isError(csz)) {
+        logger_base.crit("Could not compress sequence data page %u: %s.", page, ZSTD_getErrorName(csz));
+        out.clear();
+    } else {
+        out.resize(csz);
+        out.shrink_to_fit();
+    }
+    _compressedBytes += out.size();
+#endif
+}
+
+void SequenceData::DecompressPage(unsigned int page) const {
+#ifndef NO_ZSTD
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    const std::vector<unsigned char> &in = _pageCompressed[page];
+    if (in.empty()) {
+        // never written so still zeros
+        return;
+    }
+    unsigned int firstFrame = page * _framesPerPage;
+    unsigned int frames = std::min(_framesPerPage, _numFrames - firstFrame);
+    unsigned char *data = &_data[(size_t)firstFrame * _bytesPerFrame];
+    size_t len = (size_t)frames * _bytesPerFrame;
+    size_t dsz = ZSTD_decompress(data, len, &in[0], in.size());
+    if (ZSTD_isError(dsz) || dsz != len) {
+        logger_base.crit("Could not decompress sequence data page %u.", page);
+        memset(data, 0x00, len);
+        return;
     }
+    for (unsigned int f = 1; f < frames; f++) {
+        unsigned char *cur = &data[(size_t)f * _bytesPerFrame];
+        const unsigned char *prev = cur - _bytesPerFrame;
+        for (unsigned int c = 0; c < _bytesPerFrame; c++) {
+            cur[c] ^= prev[c];
+        }
+    }
+#endif
+}
+
+void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsigned int frameTime, bool roundto4) {
+
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    FreeData();
     if (_invalidData != nullptr) {
         free(_invalidData);
         _invalidData = nullptr;
@@ -59,7 +385,16 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
 
     if (numFrames > 0 && numChannels > 0) {
         size_t sz = (size_t)_bytesPerFrame * (size_t)_numFrames;
-        _data = (unsigned char *)calloc(1, sz);
+        if (_memoryBudget != 0 && sz > _memoryBudget && _compressPages && AllocCompressedData(sz)) {
+            logger_base.debug("Frame data larger than memory budget of %ld so compressed. Frames=%d, Channels=%d, Memory=%ld.", _memoryBudget, _numFrames, _numChannels, sz);
+        }
+        else if (_memoryBudget != 0 && sz > _memoryBudget && MapData(sz)) {
+            logger_base.debug("Frame data larger than memory budget of %ld so paged. Frames=%d, Channels=%d, Memory=%ld.", _memoryBudget, _numFrames, _numChannels, sz);
+        }
+        else
+        {
+            _data = (unsigned char *)calloc(1, sz);
+        }
         wxASSERT(_data != nullptr); // if this fails then we have a memory allocation error
         if (_data == nullptr)
         {
@@ -68,7 +403,7 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
             wxString settings = wxString::Format("Frames=%d, Channels=%d, Memory=%ld.", _numFrames, _numChannels, sz);
             DisplayError("Bad news ... xLights is about to crash because it could not get memory it needed. If you are running 32 bit xLights then moving to 64 bit will probably fix this. Alternatively look to reduce memory usage by shortening sequences and/or reducing channels.\n" + settings);
         }
-        else
+        else if (!_mapped)
         {
             logger_base.debug("Memory allocated for frame data. Frames=%d, Channels=%d, Memory=%ld.", _numFrames, _numChannels, sz);
         }
@@ -84,18 +419,20 @@ FrameData SequenceData::operator[](unsigned int frame) {
     if (frame >= _numFrames) {
         return FrameData(_numChannels, _invalidData);
     }
+    std::atomic_int *pin = TouchFrame(frame, true);
     std::ptrdiff_t offset = frame;
     offset *= _bytesPerFrame;
-    return FrameData(_numChannels, &_data[offset]);
+    return FrameData(_numChannels, &_data[offset], pin);
 }
 
 const FrameData SequenceData::operator[](unsigned int frame) const {
     if (frame >= _numFrames) {
         return FrameData(_numChannels, _invalidData);
     }
+    std::atomic_int *pin = TouchFrame(frame, false);
     std::ptrdiff_t offset = frame;
     offset *= _bytesPerFrame;
-    return FrameData(_numChannels, &_data[offset]);
+    return FrameData(_numChannels, &_data[offset], pin);
 }
 
 // This encodes the sequence data grouped by channel
@@ -10,12 +10,18 @@
 #define SEQUENCEDATA_H
 
 #include <wx/wx.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class FrameData {
     static const unsigned char _constzero;
     unsigned char _zero;
     unsigned int _numChannels;
     unsigned char* _data;
+    // compressed sequence data keeps the page pinned in memory while this exists
+    std::atomic_int* _pin;
 
 public:
     void Zero()
@@ -29,12 +35,28 @@ public:
         if (start + count > _numChannels) return;
         memset(&_data[start], 0x00, count);
     }
-    FrameData(unsigned int nc, unsigned char *d) {
+    FrameData(unsigned int nc, unsigned char *d, std::atomic_int *pin = nullptr) {
         _numChannels = nc;
         _data = d;
         _zero = 0;
+        _pin = pin;
     }
-    
+    FrameData(const FrameData &fd) {
+        _numChannels = fd._numChannels;
+        _data = fd._data;
+        _zero = 0;
+        _pin = fd._pin;
+        if (_pin != nullptr) {
+            ++(*_pin);
+        }
+    }
+    ~FrameData() {
+        if (_pin != nullptr) {
+            --(*_pin);
+        }
+    }
+    FrameData &operator=(const FrameData &fd) = delete;
+
     unsigned char &operator[](unsigned int channel) {
         wxASSERT(_zero == 0);
         return channel < _numChannels ? _data[channel] : _zero;
@@ -54,9 +76,76 @@ class SequenceData {
     unsigned int _numFrames;
     unsigned int _frameTime;
 
+    // When the data is bigger than the memory budget it lives in a memory mapped
+    // scratch file instead of the heap.  It is still one contiguous block so
+    // FrameData works as before, but it is tracked in pages of frames and the
+    // least recently used pages beyond the budget are handed back to the OS.
+    // In compressed mode there is no file, pages are delta/zstd compressed in
+    // memory when evicted and decompressed when next touched.
+    static size_t _memoryBudget;
+    static bool _compressPages;
+    bool _mapped;
+    bool _compressed;
+#ifdef __WXMSW__
+    void *_mapFile;
+    void *_mapHandle;
+#else
+    int _mapFile;
+#endif
+    size_t _mappedSize;
+    unsigned int _framesPerPage;
+    unsigned int _numPages;
+    unsigned int _maxResidentPages;
+    std::unique_ptr<std::atomic_uint[]> _pageLastUsed;
+    std::unique_ptr<std::atomic_bool[]> _pageResident;
+    std::unique_ptr<std::atomic_bool[]> _pageDirty;
+    std::unique_ptr<std::atomic_int[]> _pagePins;
+    std::unique_ptr<std::vector<unsigned char>[]> _pageCompressed;
+    mutable size_t _compressedBytes;
+    mutable std::atomic_uint _residentPages;
+    mutable std::atomic_uint _pageEpoch;
+    mutable std::mutex _pageLock;
+
     SequenceData(const SequenceData&);  //make sure we cannot "copy" these
     SequenceData &operator=(const SequenceData& rgb);
 
+    void FreeData();
+    bool MapData(size_t sz);
+    bool AllocCompressedData(size_t sz);
+    void InitPages(size_t sz);
+    // returns the pin to hand to FrameData when the page needs pinning
+    std::atomic_int *TouchFrame(unsigned int frame, bool write) const {
+        std::atomic_int *pin = nullptr;
+        if (_mapped) {
+            unsigned int page = frame / _framesPerPage;
+            unsigned int epoch = _pageEpoch.load(std::memory_order_relaxed);
+            if (_pageLastUsed[page].load(std::memory_order_relaxed) != epoch) {
+                _pageLastUsed[page].store(epoch, std::memory_order_relaxed);
+            }
+            if (_compressed) {
+                // pin then check, eviction unflags then checks the pins, so one
+                // of us always sees the other
+                pin = &_pagePins[page];
+                ++(*pin);
+                while (!_pageResident[page].load()) {
+                    --(*pin);
+                    PageIn(page);
+                    ++(*pin);
+                }
+            } else if (!_pageResident[page].load(std::memory_order_acquire)) {
+                PageIn(page);
+            }
+            if (write && !_pageDirty[page].load(std::memory_order_relaxed)) {
+                _pageDirty[page].store(true, std::memory_order_relaxed);
+            }
+        }
+        return pin;
+    }
+    void PageIn(unsigned int page) const;
+    void PageOut(unsigned int page) const;
+    void CompressPage(unsigned int page) const;
+    void DecompressPage(unsigned int page) const;
+
 public:
     SequenceData();
     virtual ~SequenceData();
@@ -72,6 +161,15 @@ public:
     unsigned int NumFrames() const { return _numFrames;}
     unsigned int FrameTime() const { return _frameTime;}
     bool IsValidData() const { return _data != nullptr; }
+    bool IsPaged() const { return _mapped; }
+    bool IsCompressed() const { return _compressed; }
+
+    // sequences needing more than this many bytes are paged to a scratch file
+    static void SetMemoryBudget(size_t bytes) { _memoryBudget = bytes; }
+    static size_t GetMemoryBudget() { return _memoryBudget; }
+    // page into compressed memory rather than a scratch file
+    static void SetCompressPages(bool compress) { _compressPages = compress; }
+    static bool GetCompressPages() { return _compressPages; }
 
     // encodes contents of SeqData in channel order
     wxString base64_encode();
@@ -684,10 +684,11 @@ void xLightsFrame:: WriteFalconPiModelFile(const wxString& filename, long numCha
         buf[19] = (wxUint8)((modelSize >> 24) & 0xFF);
         f.Write(buf, ESEQ_HEADER_LENGTH);
 
-        size_t size = dataBuf->NumFrames();
-        size *= stepSize;
-
-        f.Write(&(*dataBuf)[0][0], size);
+        // write a frame at a time, paged and compressed sequence data is only
+        // contiguous within a frame
+        for (unsigned int frame = 0; frame < dataBuf->NumFrames(); frame++) {
+            f.Write(&(*dataBuf)[frame][0], stepSize);
+        }
 
         f.Close();
     }
@@ -12,6 +12,7 @@
 #include <log4cpp/Category.hh>
 
 AudioManager* ValueCurve::__audioManager = nullptr;
+thread_local int ValueCurve::__frameMS = 0;
 
 float ValueCurve::SafeParameter(size_t p, float v)
 {
@@ -447,6 +448,7 @@ void ValueCurve::GetRangeParm4(const std::string& type, float& low, float &high)
 
 void ValueCurve::Reverse()
 {
+    InvalidateBake();
     // Only reverse the time offset if a non zero value was used
     if (_timeOffset != 0)
     {
@@ -528,6 +530,7 @@ void ValueCurve::Reverse()
 
 void ValueCurve::Flip()
 {
+    InvalidateBake();
     if (_type == "Custom")
     {
         for (auto it = _values.begin(); it != _values.end(); ++it)
@@ -612,6 +615,7 @@ float ValueCurve::Normalise(int parm, float value)
 // unfixes the changed scale from whatever it is now to 0-100
 void ValueCurve::UnFixChangedScale(float newmin, float newmax)
 {
+    InvalidateBake();
     if (newmin == 0 && newmax == 100) return;
 
     float oldrange = newmax - newmin;
@@ -647,6 +651,7 @@ void ValueCurve::UnFixChangedScale(float newmin, float newmax)
 // fixes curves that were saved with the wrong scale
 void ValueCurve::FixScale(int scale)
 {
+    InvalidateBake();
     float min, max;
     GetRangeParm(1, _type, min, max);
     if (min == MINVOID)
@@ -676,6 +681,7 @@ void ValueCurve::FixScale(int scale)
 // fixes the changed scale from 0-100 to whatever it is now
 void ValueCurve::FixChangedScale(float newmin, float newmax, int divisor)
 {
+    InvalidateBake();
     if (newmin == 0 && newmax == 100 && divisor == 1) return;
 
     float newrange = newmax - newmin;
@@ -710,6 +716,7 @@ void ValueCurve::FixChangedScale(float newmin, float newmax, int divisor)
 
 void ValueCurve::ConvertChangedScale(float newmin, float newmax)
 {
+    InvalidateBake();
     if (newmin == _min && newmax == _max) return;
 
     float newrange = newmax - newmin;
@@ -738,6 +745,7 @@ void ValueCurve::ConvertChangedScale(float newmin, float newmax)
 
 void ValueCurve::RenderType()
 {
+    InvalidateBake();
     // dont render if we dont know our limits
     if (_min == MINVOIDF || _max == MAXVOIDF || _divisor == MAXVOID) return;
 
@@ -1223,6 +1231,7 @@ ValueCurve::ValueCurve(const std::string& s)
 
 void ValueCurve::Deserialise(const std::string& s, bool holdminmax)
 {
+    InvalidateBake();
     if (s == "")
     {
         SetDefault(0, 100);
@@ -1476,6 +1485,7 @@ void ValueCurve::SaveXVC(const std::string& filename)
 
 void ValueCurve::SetSerialisedValue(std::string k, std::string s)
 {
+    InvalidateBake();
     wxString kk = wxString(k.c_str());
     if (kk == "Id")
     {
@@ -1581,16 +1591,66 @@ float ValueCurve::ApplyGain(float value, int gain) const
     return v;
 }
 
+int ValueCurve::GetBakeFrames(long startMS, long endMS)
+{
+    // the frames RenderBuffer::SetEffectDuration gives the effect, render offsets run
+    // from 0 at the first to 1 at the last so land exactly on the table entries
+    if (__frameMS <= 0 || endMS <= startMS) return 0;
+    return (endMS - 1) / __frameMS - startMS / __frameMS + 1;
+}
+
+void ValueCurve::Bake(long startMS, long endMS, int frames)
+{
+    if (IsBaked(startMS, endMS) && (int)_baked.size() == frames) return;
+
+    InvalidateBake();
+
+    // music curves depend on the audio at render time so are always evaluated
+    if (!IsActive() || frames < 2 || frames > 1000000 ||
+        _type == "Music" || _type == "Inverted Music" || _type == "Music Trigger Fade")
+    {
+        return;
+    }
+
+    std::vector<float> baked(frames);
+    for (int i = 0; i < frames; i++)
+    {
+        baked[i] = GetValueAt((float)i / (float)(frames - 1), startMS, endMS);
+    }
+    _baked.swap(baked);
+    _bakedStartMS = startMS;
+    _bakedEndMS = endMS;
+}
+
 float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
 {
+    if (IsBaked(startMS, endMS))
+    {
+        // only offsets that land exactly on a frame come from the table
+        const int last = _baked.size() - 1;
+        const int frame = (int)(offset * last + 0.5f);
+        if (frame >= 0 && frame <= last && (float)frame / (float)last == offset)
+        {
+            return _baked[frame];
+        }
+    }
+
     float res = 0.0f;
 
+    // points to interpolate over ... music trigger fade adds its own for this call only
+    // so a curve that is kept and reused across frames never accumulates them
+    const std::list<vcSortablePoint>* points = &_values;
+    std::list<vcSortablePoint> fadePoints;
+
     // If we are music trigger fade and we dont have values ... calculate them on the fly
     if (_type == "Music Trigger Fade")
     {
         // Just generate what we need on the fly
         if (__audioManager != nullptr)
         {
+            fadePoints = _values;
+            points = &fadePoints;
+
             float min = (GetParameter1() - _min) / (_max - _min);
             float max = (GetParameter2() - _min) / (_max - _min);
             int step = (endMS - startMS) / VC_X_POINTS;
@@ -1605,9 +1665,9 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
                 float x = (float)(cur - startMS) / (float)(endMS - startMS);
                 float f = 0.0;
                 auto pf = __audioManager->GetFrameData(FRAMEDATATYPE::FRAMEDATA_HIGH, "", cur);
-                if (pf != nullptr)
+                if (!pf.empty())
                 {
-                    f = *pf->begin();
+                    f = pf.front();
                 }
 
                 float y = min;
@@ -1626,7 +1686,7 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
                     }
                 }
 
-                _values.push_back(vcSortablePoint(x, y, _wrap));
+                fadePoints.push_back(vcSortablePoint(x, y, _wrap));
             }
         }
     }
@@ -1638,9 +1698,9 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
             long time = (float)startMS + offset * (endMS - startMS);
             float f = 0.0;
             auto pf = __audioManager->GetFrameData(FRAMEDATATYPE::FRAMEDATA_HIGH, "", time);
-            if (pf != nullptr)
+            if (!pf.empty())
             {
-                f = ApplyGain(*pf->begin(), GetParameter3());
+                f = ApplyGain(pf.front(), GetParameter3());
                 if (_type == "Inverted Music")
                 {
                     f = 1.0 - f;
@@ -1654,7 +1714,7 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
     }
     else
     {
-        if (_values.size() < 2) return 1.0f;
+        if (points->size() < 2) return 1.0f;
         if (!_active) return 1.0f;
 
         if (offset < 0.0f) offset = 0.0;
@@ -1663,19 +1723,19 @@ float ValueCurve::GetValueAt(float offset, long startMS, long endMS)
         offset += (float)_timeOffset / 100;
         if (offset > 1.0) offset -= 1.0;
 
-        vcSortablePoint last = _values.front();
-        auto it = _values.begin();
+        vcSortablePoint last = points->front();
+        auto it = points->begin();
         ++it;
 
-        while (it != _values.end() && it->x < offset)
+        while (it != points->end() && it->x < offset)
         {
             last = *it;
             ++it;
         }
 
-        if (it == _values.end())
+        if (it == points->end())
         {
-            res = _values.back().y;
+            res = points->back().y;
         }
         else if (it->x == last.x)
         {
@@ -1728,6 +1788,7 @@ bool ValueCurve::IsSetPoint(float offset)
 
 void ValueCurve::DeletePoint(float offset)
 {
+    InvalidateBake();
     if (GetPointCount() > 2)
     {
         auto it = _values.begin();
@@ -1745,6 +1806,7 @@ void ValueCurve::DeletePoint(float offset)
 
 void ValueCurve::RemoveExcessCustomPoints()
 {
+    InvalidateBake();
     // go through list and remove middle points where 3 in a row have the same value
     auto it1 = _values.begin();
     auto it2 = it1;
@@ -1773,6 +1835,7 @@ void ValueCurve::RemoveExcessCustomPoints()
 
 void ValueCurve::SetValueAt(float offset, float value)
 {
+    InvalidateBake();
     auto it = _values.begin();
     while (it != _values.end() && *it <= offset)
     {
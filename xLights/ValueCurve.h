@@ -4,6 +4,7 @@
 #include <wx/position.h>
 #include <string>
 #include <list>
+#include <vector>
 
 #define MINVOID -91234
 #define MAXVOID 91234
@@ -84,9 +85,15 @@ class ValueCurve
     bool _active;
     bool _wrap;
     bool _realValues;
+    // the curve evaluated at each frame of the effect it was last baked for
+    std::vector<float> _baked;
+    long _bakedStartMS = 0;
+    long _bakedEndMS = 0;
     static AudioManager* __audioManager;
+    static thread_local int __frameMS;
 
     void RenderType();
+    void InvalidateBake() { _baked.clear(); }
     void SetSerialisedValue(std::string k, std::string s);
     float SafeParameter(size_t p, float v);
     float Safe01(float v);
@@ -98,6 +105,9 @@ class ValueCurve
 public:
 
     static void SetAudio(AudioManager* am) { __audioManager = am; }
+    // frame time of the effect being rendered on this thread, used to size baked tables
+    static void SetFrameTime(int frameMS) { __frameMS = frameMS; }
+    static int GetBakeFrames(long startMS, long endMS);
     static std::string GetValueCurveFolder(const std::string& showFolder);
 
     ValueCurve() { _divisor = 1; SetDefault(); _min = MINVOIDF; _max = MAXVOIDF; }
@@ -121,19 +131,22 @@ public:
     float GetMin() const { wxASSERT(_min != MINVOIDF); return _min; }
     int GetDivisor() const { wxASSERT(_divisor != MAXVOID); return (int)_divisor; }
     void SetRealValue() { _realValues = true; }
-    void SetLimits(float min, float max) { _min = min; _max = max; }
+    void SetLimits(float min, float max) { _min = min; _max = max; InvalidateBake(); }
     void FixScale(int scale);
     float GetValueAt(float offset, long startMS, long endMS);
     float GetOutputValueAt(float offset, long startMS, long endMS);
     float GetOutputValueAtDivided(float offset, long startMS, long endMS);
     float GetScaledValue(float offset) const;
+    // evaluates the curve once per frame so GetValueAt for those times becomes a table lookup
+    void Bake(long startMS, long endMS, int frames);
+    bool IsBaked(long startMS, long endMS) const { return !_baked.empty() && _bakedStartMS == startMS && _bakedEndMS == endMS; }
     void SetActive(bool a) { _active = a; RenderType(); }
     bool IsActive() const { return _active && IsOk(); }
-    void ToggleActive() { _active = !_active; if (_active) RenderType(); }
+    void ToggleActive() { _active = !_active; InvalidateBake(); if (_active) RenderType(); }
     void SetValueAt(float offset, float value);
     void DeletePoint(float offset);
     bool IsSetPoint(float offset);
-    void SetDivisor(float divisor) { _divisor = divisor; }
+    void SetDivisor(float divisor) { _divisor = divisor; InvalidateBake(); }
     bool IsRealValue() const { return _realValues; }
     int GetPointCount() const { return _values.size(); }
     void SetParameter1(float parameter1) { _parameter1 = SafeParameter(1, parameter1); RenderType(); }
@@ -5,6 +5,11 @@
 
 #undef min
 #include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <wx/filename.h>
 
 VideoReader::VideoReader(const std::string& filename, int maxwidth, int maxheight, bool keepaspectratio, bool usenativeresolution/*false*/)
@@ -519,3 +524,319 @@ AVFrame* VideoReader::GetNextFrame(int timestampMS, int gracetime)
 		return _dstFrame;
 	}
 }
+
+// frames decoded past the furthest position any reader has asked for
+#define VIDEO_FRAMES_AHEAD 8
+// frames behind that position are kept, up to this many bytes, for readers running a little late
+#define VIDEO_RING_BYTES (32 * 1024 * 1024)
+#define VIDEO_RING_MIN_FRAMES (2 * VIDEO_FRAMES_AHEAD)
+// a reader this far past the decoded frames seeks rather than waiting for decode to catch up
+#define VIDEO_SEEK_AHEAD_MS 2000
+
+class SharedVideoDecoder
+{
+public:
+    enum class Result { FRAME, END, MISS };
+
+    SharedVideoDecoder(const std::string& filename, int width, int height, bool keepaspectratio) :
+        _reader(filename, width, height, keepaspectratio)
+    {
+        _frameMS = std::max(_reader.GetFrameMS(), 1);
+        size_t frameBytes = std::max((size_t)_reader.GetWidth() * _reader.GetHeight() * 3, (size_t)1);
+        _ringFrames = std::max(VIDEO_RING_BYTES / frameBytes, (size_t)VIDEO_RING_MIN_FRAMES);
+        if (_reader.IsValid())
+        {
+            _thread = std::thread(&SharedVideoDecoder::Run, this);
+        }
+    }
+
+    ~SharedVideoDecoder()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _exit = true;
+        }
+        _signal.notify_all();
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+    // these do not change once the reader is open so they are safe to call from any thread
+    bool IsValid() const { return _reader.IsValid(); }
+    int GetLengthMS() const { return _reader.GetLengthMS(); }
+    int GetWidth() const { return _reader.GetWidth(); }
+    int GetHeight() const { return _reader.GetHeight(); }
+
+    static std::shared_ptr<SharedVideoDecoder> Acquire(const std::string& key, const std::string& filename, int width, int height, bool keepaspectratio,
+                                                       int timestampMS, SharedVideoDecoder* exclude, bool createNew = false);
+    void Release()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _users--;
+    }
+
+    // MISS means the frame is outside what this decoder has buffered and other readers are relying on it
+    // staying where it is, so the caller should move to a different decoder
+    Result GetFrame(int timestampMS, std::shared_ptr<std::vector<uint8_t>>& frame)
+    {
+        if (timestampMS > GetLengthMS())
+        {
+            return Result::END;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        if (!_started || !Covers(timestampMS))
+        {
+            if (_started && _users > 1)
+            {
+                return Result::MISS;
+            }
+            StartAt(timestampMS);
+        }
+        _requestMS = std::max(_requestMS, timestampMS);
+        _signal.notify_all();
+
+        for (;;)
+        {
+            for (const auto& it : _ring)
+            {
+                if (timestampMS <= it.endMS)
+                {
+                    frame = it.data;
+                    return Result::FRAME;
+                }
+            }
+            if (_atEnd && !_seekPending)
+            {
+                return Result::END;
+            }
+            _signal.wait(lock);
+
+            // the frames we were waiting on may have been dropped in favour of a reader further along
+            if (timestampMS <= _ringStartMS)
+            {
+                if (_users > 1)
+                {
+                    return Result::MISS;
+                }
+                StartAt(timestampMS);
+                _signal.notify_all();
+            }
+        }
+    }
+
+private:
+    struct Frame
+    {
+        double endMS; // the frame is returned for requests after the previous frame's endMS up to this
+        std::shared_ptr<std::vector<uint8_t>> data;
+    };
+
+    // a decoder that has not been asked for anything yet can start anywhere
+    bool Covers(int timestampMS) const
+    {
+        if (!_started) return true;
+        double endMS = _ring.empty() ? _ringStartMS : _ring.back().endMS;
+        return timestampMS > _ringStartMS && timestampMS <= endMS + VIDEO_SEEK_AHEAD_MS;
+    }
+
+    void StartAt(int timestampMS)
+    {
+        _started = true;
+        _seekPending = true;
+        _seekMS = timestampMS;
+        _ringStartMS = timestampMS - 1;
+        _requestMS = timestampMS;
+        _atEnd = false;
+        _ring.clear();
+    }
+
+    bool WantsFrame()
+    {
+        if (_seekPending) return true;
+        if (!_started || _atEnd) return false;
+        if (!_ring.empty() && _ring.back().endMS >= _requestMS + VIDEO_FRAMES_AHEAD * _frameMS) return false;
+        if (_ring.size() >= _ringFrames)
+        {
+            if (_ring.front().endMS >= _requestMS) return false;
+            _ringStartMS = _ring.front().endMS;
+            _ring.pop_front();
+        }
+        return true;
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (!_exit)
+        {
+            if (!WantsFrame())
+            {
+                _signal.wait(lock);
+                continue;
+            }
+
+            bool seek = _seekPending;
+            int timestampMS = seek ? _seekMS : _nextMS;
+            _seekPending = false;
+
+            // the reader is only ever touched on this thread
+            lock.unlock();
+            if (seek)
+            {
+                _reader.Seek(timestampMS);
+            }
+            AVFrame* image = _reader.GetNextFrame(timestampMS);
+            std::shared_ptr<std::vector<uint8_t>> data;
+            int pos = 0;
+            if (image != nullptr)
+            {
+                data = std::make_shared<std::vector<uint8_t>>(image->data[0], image->data[0] + _reader.GetWidth() * _reader.GetHeight() * 3);
+                pos = _reader.GetPos();
+            }
+            lock.lock();
+
+            if (_seekPending)
+            {
+                // a reader moved the decoder while we were decoding
+                continue;
+            }
+            if (data == nullptr)
+            {
+                _atEnd = true;
+            }
+            else
+            {
+                _ring.push_back({ pos + _frameMS / 2.0, data });
+                _nextMS = pos + _frameMS;
+            }
+            _signal.notify_all();
+        }
+    }
+
+    VideoReader _reader;
+    int _frameMS;
+    size_t _ringFrames;
+
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::list<Frame> _ring;
+    double _ringStartMS = 0;
+    int _requestMS = 0;
+    int _nextMS = 0;
+    int _seekMS = 0;
+    int _users = 0;
+    bool _started = false;
+    bool _seekPending = false;
+    bool _atEnd = false;
+    bool _exit = false;
+};
+
+static std::mutex VIDEO_DECODERS_LOCK;
+static std::map<std::string, std::list<std::weak_ptr<SharedVideoDecoder>>> VIDEO_DECODERS;
+
+std::shared_ptr<SharedVideoDecoder> SharedVideoDecoder::Acquire(const std::string& key, const std::string& filename, int width, int height, bool keepaspectratio,
+                                                                int timestampMS, SharedVideoDecoder* exclude, bool createNew)
+{
+    std::unique_lock<std::mutex> lock(VIDEO_DECODERS_LOCK);
+    auto& decoders = VIDEO_DECODERS[key];
+    for (auto it = decoders.begin(); it != decoders.end(); )
+    {
+        std::shared_ptr<SharedVideoDecoder> decoder = it->lock();
+        if (decoder == nullptr)
+        {
+            it = decoders.erase(it);
+            continue;
+        }
+        if (!createNew && decoder.get() != exclude)
+        {
+            std::unique_lock<std::mutex> dlock(decoder->_lock);
+            // a reader that has not asked for a frame yet can share any of them
+            if (timestampMS < 0 || decoder->Covers(timestampMS))
+            {
+                decoder->_users++;
+                return decoder;
+            }
+        }
+        ++it;
+    }
+
+    // opening the file is done under the lock so readers starting together end up sharing it
+    std::shared_ptr<SharedVideoDecoder> decoder = std::make_shared<SharedVideoDecoder>(filename, width, height, keepaspectratio);
+    decoder->_users++;
+    decoders.push_back(decoder);
+    return decoder;
+}
+
+SharedVideoReader::SharedVideoReader(const std::string& filename, int width, int height, bool keepaspectratio)
+{
+    _filename = filename;
+    _width = width;
+    _height = height;
+    _keepaspectratio = keepaspectratio;
+    _atEnd = false;
+    _key = filename + "|" + std::to_string(width) + "|" + std::to_string(height) + "|" + (keepaspectratio ? "1" : "0");
+    _decoder = SharedVideoDecoder::Acquire(_key, _filename, _width, _height, _keepaspectratio, -1, nullptr);
+}
+
+SharedVideoReader::~SharedVideoReader()
+{
+    _frame = nullptr;
+    if (_decoder != nullptr)
+    {
+        _decoder->Release();
+        _decoder = nullptr;
+    }
+}
+
+int SharedVideoReader::GetLengthMS() const
+{
+    return _decoder->GetLengthMS();
+}
+
+bool SharedVideoReader::IsValid() const
+{
+    return _decoder->IsValid();
+}
+
+int SharedVideoReader::GetWidth() const
+{
+    return _decoder->GetWidth();
+}
+
+int SharedVideoReader::GetHeight() const
+{
+    return _decoder->GetHeight();
+}
+
+const uint8_t* SharedVideoReader::GetNextFrame(int timestampMS)
+{
+    _atEnd = false;
+    if (!IsValid())
+    {
+        return nullptr;
+    }
+    timestampMS = std::max(timestampMS, 0);
+
+    SharedVideoDecoder::Result res = _decoder->GetFrame(timestampMS, _frame);
+    for (int tries = 0; res == SharedVideoDecoder::Result::MISS; tries++)
+    {
+        // other readers are using our decoder somewhere else in the video so move to one that suits us,
+        // or after a couple of goes a new one nobody else can move
+        std::shared_ptr<SharedVideoDecoder> previous = _decoder;
+        _decoder = SharedVideoDecoder::Acquire(_key, _filename, _width, _height, _keepaspectratio, timestampMS, previous.get(), tries >= 2);
+        previous->Release();
+        res = _decoder->GetFrame(timestampMS, _frame);
+    }
+
+    if (res == SharedVideoDecoder::Result::END)
+    {
+        _atEnd = true;
+        _frame = nullptr;
+        return nullptr;
+    }
+    return _frame->data();
+}
@@ -2,6 +2,8 @@
 #define VIDEOREADER_H
 
 #include <string>
+#include <memory>
+#include <vector>
 
 extern "C"
 {
@@ -25,6 +27,7 @@ public:
 	int GetHeight() const { return _height; };
 	bool AtEnd() const { return _atEnd; };
     int GetPos();
+    int GetFrameMS() const { return _frameMS; }
     std::string GetFilename() const { return _filename; }
 
 private:
@@ -47,4 +50,33 @@ private:
 	bool _atEnd;
     std::string _filename;
 };
+
+class SharedVideoDecoder;
+
+// Reads frames from a decoder shared with every other SharedVideoReader that has the same file open
+// at the same size. The decoder runs on its own thread a few frames ahead of the furthest reader so
+// renders only wait on decode when they jump around in the video.
+class SharedVideoReader
+{
+public:
+    SharedVideoReader(const std::string& filename, int width, int height, bool keepaspectratio);
+    ~SharedVideoReader();
+    int GetLengthMS() const;
+    const uint8_t* GetNextFrame(int timestampMS); // RGB24, GetWidth() * 3 bytes per row, valid until the next call
+    bool IsValid() const;
+    int GetWidth() const;
+    int GetHeight() const;
+    bool AtEnd() const { return _atEnd; };
+    std::string GetFilename() const { return _filename; }
+
+private:
+    std::shared_ptr<SharedVideoDecoder> _decoder;
+    std::shared_ptr<std::vector<uint8_t>> _frame;
+    std::string _filename;
+    std::string _key;
+    int _width;
+    int _height;
+    bool _keepaspectratio;
+    bool _atEnd;
+};
 #endif // VIDEOREADER_H
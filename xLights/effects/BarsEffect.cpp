@@ -101,17 +101,40 @@ void BarsEffect::GetSpatialColor(xlColor& color, size_t colorIndex, float x, flo
     }
 }
 
+class BarsParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter barCount;
+    ValueCurveParameter cycles;
+    ValueCurveParameter center;
+    int direction;
+    bool highlight;
+    bool show3D;
+    bool gradient;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        barCount.DecodeInt("Bars_BarCount", 1, SettingsMap, BARCOUNT_MIN, BARCOUNT_MAX, buffer);
+        cycles.DecodeDouble("Bars_Cycles", 1.0, SettingsMap, BARCYCLES_MIN, BARCYCLES_MAX, buffer, 10);
+        center.DecodeDouble("Bars_Center", 0, SettingsMap, BARCENTER_MIN, BARCENTER_MAX, buffer);
+        direction = GetDirection(SettingsMap["CHOICE_Bars_Direction"]);
+        highlight = SettingsMap.GetBool("CHECKBOX_Bars_Highlight", false);
+        show3D = SettingsMap.GetBool("CHECKBOX_Bars_3D", false);
+        gradient = SettingsMap.GetBool("CHECKBOX_Bars_Gradient", false);
+    }
+};
+
 void BarsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
 
+    BarsParameters &params = GetParameters<BarsParameters>(effect, SettingsMap, buffer);
     float offset = buffer.GetEffectTimeIntervalPosition();
-    int PaletteRepeat = GetValueCurveInt("Bars_BarCount", 1, SettingsMap, offset, BARCOUNT_MIN, BARCOUNT_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    double cycles = GetValueCurveDouble("Bars_Cycles", 1.0, SettingsMap, offset, BARCYCLES_MIN, BARCYCLES_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 10);
+    int PaletteRepeat = params.barCount.GetInt(offset, buffer);
+    double cycles = params.cycles.GetDouble(offset, buffer);
     double position = buffer.GetEffectTimeIntervalPosition(cycles);
-    double Center = GetValueCurveDouble("Bars_Center", 0, SettingsMap, position, BARCENTER_MIN, BARCENTER_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int Direction = GetDirection(SettingsMap["CHOICE_Bars_Direction"]);
-    bool Highlight = SettingsMap.GetBool("CHECKBOX_Bars_Highlight", false);
-    bool Show3D = SettingsMap.GetBool("CHECKBOX_Bars_3D", false);
-    bool Gradient = SettingsMap.GetBool("CHECKBOX_Bars_Gradient", false);
+    double Center = params.center.GetDouble(position, buffer);
+    int Direction = params.direction;
+    bool Highlight = params.highlight;
+    bool Show3D = params.show3D;
+    bool Gradient = params.gradient;
 
     int x,y,n,ColorIdx;
     size_t colorcnt = buffer.GetColorCount();
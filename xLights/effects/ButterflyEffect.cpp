@@ -68,16 +68,37 @@ void ButterflyEffect::SetDefaultParameters() {
     SetSliderValue(bp->Slider_Butterfly_Speed, 10);
 }
 
+class ButterflyParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter chunks;
+    ValueCurveParameter skip;
+    ValueCurveParameter speed;
+    int style;
+    int colorScheme;
+    int direction;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        chunks.DecodeInt("Butterfly_Chunks", 1, SettingsMap, BUTTERFLY_CHUNKS_MIN, BUTTERFLY_CHUNKS_MAX, buffer);
+        skip.DecodeInt("Butterfly_Skip", 2, SettingsMap, BUTTERFLY_SKIP_MIN, BUTTERFLY_SKIP_MAX, buffer);
+        speed.DecodeInt("Butterfly_Speed", 10, SettingsMap, BUTTERFLY_SPEED_MIN, BUTTERFLY_SPEED_MAX, buffer);
+        style = SettingsMap.GetInt("SLIDER_Butterfly_Style", 1);
+        colorScheme = GetButterflyColorScheme(SettingsMap["CHOICE_Butterfly_Colors"]);
+        direction = SettingsMap["CHOICE_Butterfly_Direction"] == "Reverse" ? 1 : 0;
+    }
+};
+
 void ButterflyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer)
 {
+    ButterflyParameters &params = GetParameters<ButterflyParameters>(effect, SettingsMap, buffer);
     float oset = buffer.GetEffectTimeIntervalPosition();
-    const int Chunks = GetValueCurveInt("Butterfly_Chunks", 1, SettingsMap, oset, BUTTERFLY_CHUNKS_MIN, BUTTERFLY_CHUNKS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int Skip = GetValueCurveInt("Butterfly_Skip", 2, SettingsMap, oset, BUTTERFLY_SKIP_MIN, BUTTERFLY_SKIP_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int butterFlySpeed = GetValueCurveInt("Butterfly_Speed", 10, SettingsMap, oset, BUTTERFLY_SPEED_MIN, BUTTERFLY_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    const int Chunks = params.chunks.GetInt(oset, buffer);
+    int Skip = params.skip.GetInt(oset, buffer);
+    int butterFlySpeed = params.speed.GetInt(oset, buffer);
 
-    const int Style = SettingsMap.GetInt("SLIDER_Butterfly_Style", 1);
-    int ColorScheme = GetButterflyColorScheme(SettingsMap["CHOICE_Butterfly_Colors"]);
-    int ButterflyDirection = SettingsMap["CHOICE_Butterfly_Direction"] == "Reverse" ? 1 : 0;
+    const int Style = params.style;
+    int ColorScheme = params.colorScheme;
+    int ButterflyDirection = params.direction;
     
     static const double pi2=6.283185307;
     //  These are for Plasma effect
@@ -90,8 +111,9 @@ void ButterflyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuf
     const double offset = (ButterflyDirection==1 ? -1 : 1) * double(curState)/200.0;
     const int xc=buffer.BufferWi/2;
     const int yc=buffer.BufferHt/2;
+    const MultiColorBlendTable &blend = buffer.GetMultiColorBlendTable(false);
     int block = buffer.BufferHt * buffer.BufferWi > 100 ? 1 : -1;
-    parallel_for(0, buffer.BufferWi, [&buffer, Style, &xc, &yc, &offset, frame, maxframe, Chunks, colorcnt, Skip, ColorScheme, butterFlySpeed](int x) {
+    parallel_for(0, buffer.BufferWi, [&buffer, &blend, Style, &xc, &yc, &offset, frame, maxframe, Chunks, colorcnt, Skip, ColorScheme, butterFlySpeed](int x) {
         double  fractpart, intpart;
         double h=0.0,hue1,hue2;
         xlColor color;
@@ -207,7 +229,7 @@ void ButterflyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuf
                     }
                     else
                     {
-                        buffer.GetMultiColorBlend(h,false,color);
+                        color = blend.Get(h);
                         buffer.SetPixel(x,y,color);
                     }
                 }
@@ -249,7 +271,7 @@ void ButterflyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuf
                 // vec3 col = vec3(1, sin(PI*v), cos(PI*v));
                 //   gl_FragColor = vec4(col*.5 + .5, 1);
                 
-                buffer.GetMultiColorBlend(h,false,color);
+                color = blend.Get(h);
                 //color.red=color.green=color.blue=h*255;
                 switch (Style)
                 {
@@ -276,7 +298,7 @@ void ButterflyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuf
                     case 10:
                         if(colorcnt>=2)
                         {
-                            buffer.GetMultiColorBlend(h,false,color);
+                            color = blend.Get(h);
                             
                             hue1=.1;
                             hue1=0;
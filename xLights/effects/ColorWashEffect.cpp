@@ -142,15 +142,34 @@ void ColorWashEffect::RemoveDefaults(const std::string &version, Effect *effect)
     RenderableEffect::RemoveDefaults(version, effect);
 }
 
+class ColorWashParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter cycles;
+    bool horizFade;
+    bool vertFade;
+    bool shimmer;
+    bool circularPalette;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        cycles.DecodeDouble("ColorWash_Cycles", 1.0, SettingsMap, COLOURWASH_CYCLES_MIN, COLOURWASH_CYCLES_MAX, buffer);
+        horizFade = SettingsMap.GetBool(CHECKBOX_ColorWash_HFade);
+        vertFade = SettingsMap.GetBool(CHECKBOX_ColorWash_VFade);
+        shimmer = SettingsMap.GetBool(CHECKBOX_ColorWash_Shimmer);
+        circularPalette = SettingsMap.GetBool(CHECKBOX_ColorWash_CircularPalette);
+    }
+};
+
 void ColorWashEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
 
+    ColorWashParameters &params = GetParameters<ColorWashParameters>(effect, SettingsMap, buffer);
     float oset = buffer.GetEffectTimeIntervalPosition();
-    float cycles = GetValueCurveDouble("ColorWash_Cycles", 1.0, SettingsMap, oset, COLOURWASH_CYCLES_MIN, COLOURWASH_CYCLES_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    float cycles = params.cycles.GetDouble(oset, buffer);
 
-    bool HorizFade = SettingsMap.GetBool(CHECKBOX_ColorWash_HFade);
-    bool VertFade = SettingsMap.GetBool(CHECKBOX_ColorWash_VFade);
-    bool shimmer = SettingsMap.GetBool(CHECKBOX_ColorWash_Shimmer);
-    bool circularPalette = SettingsMap.GetBool(CHECKBOX_ColorWash_CircularPalette);
+    bool HorizFade = params.horizFade;
+    bool VertFade = params.vertFade;
+    bool shimmer = params.shimmer;
+    bool circularPalette = params.circularPalette;
 
     int y;
     xlColor color, orig;
@@ -102,23 +102,62 @@ void FanEffect::SetDefaultParameters() {
 
 const double PI  =3.141592653589793238463;
 
+class FanParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter center_x;
+    ValueCurveParameter center_y;
+    ValueCurveParameter start_radius;
+    ValueCurveParameter end_radius;
+    ValueCurveParameter start_angle;
+    ValueCurveParameter revolutions;
+    ValueCurveParameter num_blades;
+    ValueCurveParameter blade_width;
+    ValueCurveParameter blade_angle;
+    ValueCurveParameter num_elements;
+    ValueCurveParameter element_width;
+    ValueCurveParameter duration;
+    ValueCurveParameter acceleration;
+    bool reverse_dir;
+    bool blend_edges;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        center_x.DecodeInt("Fan_CenterX", 50, SettingsMap, FAN_CENTREX_MIN, FAN_CENTREX_MAX, buffer);
+        center_y.DecodeInt("Fan_CenterY", 50, SettingsMap, FAN_CENTREY_MIN, FAN_CENTREY_MAX, buffer);
+        start_radius.DecodeInt("Fan_Start_Radius", 1, SettingsMap, FAN_STARTRADIUS_MIN, FAN_STARTRADIUS_MAX, buffer);
+        end_radius.DecodeInt("Fan_End_Radius", 10, SettingsMap, FAN_ENDRADIUS_MIN, FAN_ENDRADIUS_MAX, buffer);
+        start_angle.DecodeInt("Fan_Start_Angle", 0, SettingsMap, FAN_STARTANGLE_MIN, FAN_STARTANGLE_MAX, buffer);
+        revolutions.DecodeInt("Fan_Revolutions", 720, SettingsMap, FAN_REVOLUTIONS_MIN, FAN_REVOLUTIONS_MAX, buffer, 360);
+        num_blades.DecodeInt("Fan_Num_Blades", 3, SettingsMap, FAN_BLADES_MIN, FAN_BLADES_MAX, buffer);
+        blade_width.DecodeInt("Fan_Blade_Width", 50, SettingsMap, FAN_BLADEWIDTH_MIN, FAN_BLADEWIDTH_MAX, buffer);
+        blade_angle.DecodeInt("Fan_Blade_Angle", 90, SettingsMap, FAN_BLADEANGLE_MIN, FAN_BLADEANGLE_MAX, buffer);
+        num_elements.DecodeInt("Fan_Num_Elements", 1, SettingsMap, FAN_NUMELEMENTS_MIN, FAN_NUMELEMENTS_MAX, buffer);
+        element_width.DecodeInt("Fan_Element_Width", 100, SettingsMap, FAN_ELEMENTWIDTH_MIN, FAN_ELEMENTWIDTH_MAX, buffer);
+        duration.DecodeInt("Fan_Duration", 80, SettingsMap, FAN_DURATION_MIN, FAN_DURATION_MAX, buffer);
+        acceleration.DecodeInt("Fan_Accel", 0, SettingsMap, FAN_ACCEL_MIN, FAN_ACCEL_MAX, buffer);
+        reverse_dir = SettingsMap.GetBool("CHECKBOX_Fan_Reverse");
+        blend_edges = SettingsMap.GetBool("CHECKBOX_Fan_Blend_Edges");
+    }
+};
+
 void FanEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    FanParameters &params = GetParameters<FanParameters>(effect, SettingsMap, buffer);
     double eff_pos = buffer.GetEffectTimeIntervalPosition();
-    int center_x = GetValueCurveInt("Fan_CenterX", 50, SettingsMap, eff_pos, FAN_CENTREX_MIN , FAN_CENTREX_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int center_y = GetValueCurveInt("Fan_CenterY", 50, SettingsMap, eff_pos, FAN_CENTREY_MIN, FAN_CENTREY_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_radius = GetValueCurveInt("Fan_Start_Radius", 1, SettingsMap, eff_pos, FAN_STARTRADIUS_MIN, FAN_STARTRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int end_radius = GetValueCurveInt("Fan_End_Radius", 10, SettingsMap, eff_pos, FAN_ENDRADIUS_MIN, FAN_ENDRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_angle = GetValueCurveInt("Fan_Start_Angle", 0, SettingsMap, eff_pos, FAN_STARTANGLE_MIN, FAN_STARTANGLE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int revolutions = GetValueCurveInt("Fan_Revolutions", 720, SettingsMap, eff_pos, FAN_REVOLUTIONS_MIN, FAN_REVOLUTIONS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 360);
-    int num_blades = GetValueCurveInt("Fan_Num_Blades", 3, SettingsMap, eff_pos, FAN_BLADES_MIN, FAN_BLADES_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int blade_width = GetValueCurveInt("Fan_Blade_Width", 50, SettingsMap, eff_pos, FAN_BLADEWIDTH_MIN, FAN_BLADEWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int blade_angle = GetValueCurveInt("Fan_Blade_Angle", 90, SettingsMap, eff_pos, FAN_BLADEANGLE_MIN, FAN_BLADEANGLE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int num_elements = GetValueCurveInt("Fan_Num_Elements", 1, SettingsMap, eff_pos, FAN_NUMELEMENTS_MIN, FAN_NUMELEMENTS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int element_width = GetValueCurveInt("Fan_Element_Width", 100, SettingsMap, eff_pos, FAN_ELEMENTWIDTH_MIN, FAN_ELEMENTWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int duration = GetValueCurveInt("Fan_Duration", 80, SettingsMap, eff_pos, FAN_DURATION_MIN, FAN_DURATION_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int acceleration = GetValueCurveInt("Fan_Accel", 0, SettingsMap, eff_pos, FAN_ACCEL_MIN, FAN_ACCEL_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    bool reverse_dir = SettingsMap.GetBool("CHECKBOX_Fan_Reverse");
-    bool blend_edges = SettingsMap.GetBool("CHECKBOX_Fan_Blend_Edges");
+    int center_x = params.center_x.GetInt(eff_pos, buffer);
+    int center_y = params.center_y.GetInt(eff_pos, buffer);
+    int start_radius = params.start_radius.GetInt(eff_pos, buffer);
+    int end_radius = params.end_radius.GetInt(eff_pos, buffer);
+    int start_angle = params.start_angle.GetInt(eff_pos, buffer);
+    int revolutions = params.revolutions.GetInt(eff_pos, buffer);
+    int num_blades = params.num_blades.GetInt(eff_pos, buffer);
+    int blade_width = params.blade_width.GetInt(eff_pos, buffer);
+    int blade_angle = params.blade_angle.GetInt(eff_pos, buffer);
+    int num_elements = params.num_elements.GetInt(eff_pos, buffer);
+    int element_width = params.element_width.GetInt(eff_pos, buffer);
+    int duration = params.duration.GetInt(eff_pos, buffer);
+    int acceleration = params.acceleration.GetInt(eff_pos, buffer);
+    bool reverse_dir = params.reverse_dir;
+    bool blend_edges = params.blend_edges;
 
     HSVValue hsv, hsv1;
     int num_colors = buffer.palette.Size();
@@ -201,10 +201,10 @@ void FireEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &
         if (buffer.GetMedia() != nullptr)
         {
             float f = 0.0;
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty())
             {
-                f = *pf->begin();
+                f = pf.front();
             }
             HeightPct += 90 * f;
         }
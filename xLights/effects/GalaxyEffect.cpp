@@ -125,21 +125,56 @@ double GetStep(double radius)
     return (0.5 * 360.0 / (2.0 * PI * radius));
 }
 
+class GalaxyParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter center_x;
+    ValueCurveParameter center_y;
+    ValueCurveParameter start_radius;
+    ValueCurveParameter end_radius;
+    ValueCurveParameter start_angle;
+    ValueCurveParameter revolutions;
+    ValueCurveParameter start_width;
+    ValueCurveParameter end_width;
+    ValueCurveParameter duration;
+    ValueCurveParameter acceleration;
+    bool reverse_dir;
+    bool blend_edges;
+    bool inward;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        center_x.DecodeInt("Galaxy_CenterX", 50, SettingsMap, GALAXY_CENTREX_MIN, GALAXY_CENTREX_MAX, buffer);
+        center_y.DecodeInt("Galaxy_CenterY", 50, SettingsMap, GALAXY_CENTREY_MIN, GALAXY_CENTREY_MAX, buffer);
+        start_radius.DecodeInt("Galaxy_Start_Radius", 1, SettingsMap, GALAXY_STARTRADIUS_MIN, GALAXY_STARTRADIUS_MAX, buffer);
+        end_radius.DecodeInt("Galaxy_End_Radius", 10, SettingsMap, GALAXY_ENDRADIUS_MIN, GALAXY_ENDRADIUS_MAX, buffer);
+        start_angle.DecodeInt("Galaxy_Start_Angle", 0, SettingsMap, GALAXY_STARTANGLE_MIN, GALAXY_STARTANGLE_MAX, buffer);
+        revolutions.DecodeInt("Galaxy_Revolutions", 1440, SettingsMap, GALAXY_REVOLUTIONS_MIN, GALAXY_REVOLUTIONS_MAX, buffer, 360);
+        start_width.DecodeInt("Galaxy_Start_Width", 5, SettingsMap, GALAXY_STARTWIDTH_MIN, GALAXY_STARTWIDTH_MAX, buffer);
+        end_width.DecodeInt("Galaxy_End_Width", 5, SettingsMap, GALAXY_ENDWIDTH_MIN, GALAXY_ENDWIDTH_MAX, buffer);
+        duration.DecodeInt("Galaxy_Duration", 20, SettingsMap, GALAXY_DURATION_MIN, GALAXY_DURATION_MAX, buffer);
+        acceleration.DecodeInt("Galaxy_Accel", 0, SettingsMap, GALAXY_ACCEL_MIN, GALAXY_ACCEL_MAX, buffer);
+        reverse_dir = SettingsMap.GetBool("CHECKBOX_Galaxy_Reverse");
+        blend_edges = SettingsMap.GetBool("CHECKBOX_Galaxy_Blend_Edges");
+        inward = SettingsMap.GetBool("CHECKBOX_Galaxy_Inward");
+    }
+};
+
 void GalaxyEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    GalaxyParameters &params = GetParameters<GalaxyParameters>(effect, SettingsMap, buffer);
     double eff_pos = buffer.GetEffectTimeIntervalPosition();
-    int center_x = GetValueCurveInt("Galaxy_CenterX", 50, SettingsMap, eff_pos, GALAXY_CENTREX_MIN, GALAXY_CENTREX_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int center_y = GetValueCurveInt("Galaxy_CenterY", 50, SettingsMap, eff_pos, GALAXY_CENTREY_MIN, GALAXY_CENTREY_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_radius = GetValueCurveInt("Galaxy_Start_Radius", 1, SettingsMap, eff_pos, GALAXY_STARTRADIUS_MIN , GALAXY_STARTRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int end_radius = GetValueCurveInt("Galaxy_End_Radius", 10, SettingsMap, eff_pos, GALAXY_ENDRADIUS_MIN, GALAXY_ENDRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_angle = GetValueCurveInt("Galaxy_Start_Angle", 0, SettingsMap, eff_pos, GALAXY_STARTANGLE_MIN, GALAXY_STARTANGLE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int revolutions = GetValueCurveInt("Galaxy_Revolutions", 1440, SettingsMap, eff_pos, GALAXY_REVOLUTIONS_MIN, GALAXY_REVOLUTIONS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 360);
-    int start_width = GetValueCurveInt("Galaxy_Start_Width", 5, SettingsMap, eff_pos, GALAXY_STARTWIDTH_MIN, GALAXY_STARTWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int end_width = GetValueCurveInt("Galaxy_End_Width", 5, SettingsMap, eff_pos, GALAXY_ENDWIDTH_MIN, GALAXY_ENDWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int duration = GetValueCurveInt("Galaxy_Duration", 20, SettingsMap, eff_pos, GALAXY_DURATION_MIN, GALAXY_DURATION_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int acceleration = GetValueCurveInt("Galaxy_Accel", 0, SettingsMap, eff_pos, GALAXY_ACCEL_MIN, GALAXY_ACCEL_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    bool reverse_dir = SettingsMap.GetBool("CHECKBOX_Galaxy_Reverse");
-    bool blend_edges = SettingsMap.GetBool("CHECKBOX_Galaxy_Blend_Edges");
-    bool inward = SettingsMap.GetBool("CHECKBOX_Galaxy_Inward");
+    int center_x = params.center_x.GetInt(eff_pos, buffer);
+    int center_y = params.center_y.GetInt(eff_pos, buffer);
+    int start_radius = params.start_radius.GetInt(eff_pos, buffer);
+    int end_radius = params.end_radius.GetInt(eff_pos, buffer);
+    int start_angle = params.start_angle.GetInt(eff_pos, buffer);
+    int revolutions = params.revolutions.GetInt(eff_pos, buffer);
+    int start_width = params.start_width.GetInt(eff_pos, buffer);
+    int end_width = params.end_width.GetInt(eff_pos, buffer);
+    int duration = params.duration.GetInt(eff_pos, buffer);
+    int acceleration = params.acceleration.GetInt(eff_pos, buffer);
+    bool reverse_dir = params.reverse_dir;
+    bool blend_edges = params.blend_edges;
+    bool inward = params.inward;
 
     if( revolutions == 0 ) return;
     std::vector< std::vector<double> > temp_colors_pct(buffer.BufferWi, std::vector<double>(buffer.BufferHt));
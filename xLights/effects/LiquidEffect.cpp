@@ -517,10 +517,10 @@ void LiquidEffect::Step(b2World* world, RenderBuffer &buffer, bool enabled[], in
         float audioLevel = 0.0001f;
         if (buffer.GetMedia() != nullptr)
         {
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty())
             {
-                audioLevel = *pf->begin();
+                audioLevel = pf.front();
             }
         }
 
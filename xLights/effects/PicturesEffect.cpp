@@ -2,6 +2,7 @@
 #include <wx/tokenzr.h>
 #include <wx/gifdecod.h>
 #include <wx/image.h>
+#include <wx/filefn.h>
 
 #include "../../include/pictures-16.xpm"
 #include "../../include/pictures-24.xpm"
@@ -24,6 +25,13 @@
 
 #include <log4cpp/Category.hh>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 #define wrdebug(...)
 
 static int PicturesEffectId = 0;
@@ -216,24 +224,227 @@ static inline int GetPicturesDirection(const std::string &dir) {
 
 typedef std::vector< std::pair<wxPoint, xlColor> > PixelVector;
 
-class PicturesRenderCache : public EffectRenderCache {
+// Decoded pictures are shared by every effect, model and render showing the same file. An entry
+// holds the decoded frames (all of them for an animated GIF) and the scaled copies that have been
+// asked for so the rescale is done once per size rather than once per frame. Entries are keyed on
+// the file name and dropped when the file changes on disk or, least recently used first, when the
+// cache grows past PICTURE_CACHE_MAX_BYTES.
+#define PICTURE_CACHE_MAX_BYTES (512 * 1024 * 1024)
+#define PICTURE_CACHE_MAX_SCALED_BYTES (64 * 1024 * 1024)
+
+class PictureImageCache
+{
 public:
-    PicturesRenderCache() : imageCount(0), frame(0),  gifImage(nullptr), maxmovieframes(0) {};
-    virtual ~PicturesRenderCache()
+    PictureImageCache(const std::string& filename, time_t modified, bool suppressBackground) :
+        _filename(filename), _modified(modified), _suppressBackground(suppressBackground), _bytes(0) {}
+
+    static std::shared_ptr<PictureImageCache> Get(const std::string& filename, bool suppressBackground);
+
+    bool IsOk() const { return _ok; }
+    int GetImageCount()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        EnsureLoaded();
+        return _imageCount;
+    }
+    time_t GetModified() const { return _modified; }
+    size_t GetBytes() const { return _bytes; }
+
+    int GetFrameForTime(int msec, bool loop)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        if (_gifImage == nullptr) return 0;
+        return _gifImage->CalcFrameForTime(msec, loop);
+    }
+
+    std::shared_ptr<wxImage> GetFrame(int frame)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        return DoGetFrame(frame);
+    }
+
+    std::shared_ptr<wxImage> GetScaledFrame(int frame, int width, int height)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        std::shared_ptr<wxImage> image = DoGetFrame(frame);
+        if (image == nullptr || width <= 0 || height <= 0) return nullptr;
+        if (image->GetWidth() == width && image->GetHeight() == height) return image;
+
+        auto key = std::make_tuple(frame, width, height);
+        auto it = _scaled.find(key);
+        if (it != _scaled.end()) return it->second;
+
+        if (_scaledBytes > PICTURE_CACHE_MAX_SCALED_BYTES)
+        {
+            // an effect scaling through many sizes would otherwise keep all of them
+            _bytes -= _scaledBytes;
+            _scaledBytes = 0;
+            _scaled.clear();
+        }
+        std::shared_ptr<wxImage> scaled = std::make_shared<wxImage>(image->Scale(width, height));
+        _scaled[key] = scaled;
+        _scaledBytes += ImageBytes(*scaled);
+        _bytes += ImageBytes(*scaled);
+        return scaled;
+    }
+
+private:
+    static size_t ImageBytes(const wxImage& image)
+    {
+        return (size_t)image.GetWidth() * image.GetHeight() * (image.HasAlpha() ? 4 : 3);
+    }
+
+    void Load()
+    {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+        wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
+
+        // There seems to be a bug on linux where this function crashes occasionally
+#ifdef LINUX
+        logger_base.debug("About to count images in bitmap %s.", (const char *)_filename.c_str());
+#endif
+        _imageCount = wxImage::GetImageCount(_filename);
+        if (_imageCount <= 0)
+        {
+            logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)_filename.c_str(), _imageCount);
+
+            // override it to 1
+            _imageCount = 1;
+        }
+        _frames.resize(_imageCount);
+
+        if (_imageCount > 1)
+        {
+#ifdef DEBUG_GIF
+            logger_base.debug("Preparing GIF file for reading: %s", (const char *)_filename.c_str());
+#endif
+            _gifImage = std::make_unique<GIFImage>(_filename, _suppressBackground);
+            if (!_gifImage->IsOk())
+            {
+                _gifImage = nullptr;
+                _ok = false;
+            }
+            return;
+        }
+
+        std::shared_ptr<wxImage> image = std::make_shared<wxImage>();
+        if (!image->LoadFile(_filename, wxBITMAP_TYPE_ANY, 0))
+        {
+            logger_base.error("Error loading image file: %s.", (const char *)_filename.c_str());
+            image->Create(5, 5, true);
+        }
+        _frames[0] = image;
+        _bytes += ImageBytes(*image);
+    }
+
+    // the file is only read the first time something needs it, callers hold _lock
+    void EnsureLoaded()
+    {
+        if (!_loaded)
+        {
+            _loaded = true;
+            Load();
+        }
+    }
+
+    std::shared_ptr<wxImage> DoGetFrame(int frame)
+    {
+        EnsureLoaded();
+        if (!_ok) return nullptr;
+
+        if (frame < 0)
+        {
+            // past the end of a GIF that does not loop
+            if (_blank == nullptr)
+            {
+                _blank = std::make_shared<wxImage>(_gifImage != nullptr ? _gifImage->GetImageSize() : _frames[0]->GetSize());
+            }
+            return _blank;
+        }
+        frame = std::min(frame, _imageCount - 1);
+
+        if (_frames[frame] == nullptr)
+        {
+            // GIFImage shares its working image with what it returns so keep our own copy
+            _frames[frame] = std::make_shared<wxImage>(_gifImage->GetFrame(frame).Copy());
+            _bytes += ImageBytes(*_frames[frame]);
+        }
+        return _frames[frame];
+    }
+
+    std::mutex _lock;
+    std::string _filename;
+    time_t _modified;
+    bool _suppressBackground;
+    bool _loaded = false;
+    bool _ok = true;
+    int _imageCount = 1;
+    std::unique_ptr<GIFImage> _gifImage;
+    std::vector<std::shared_ptr<wxImage>> _frames;
+    std::shared_ptr<wxImage> _blank;
+    std::map<std::tuple<int, int, int>, std::shared_ptr<wxImage>> _scaled;
+    size_t _scaledBytes = 0;
+    std::atomic<size_t> _bytes;
+};
+
+struct CachedPicture
+{
+    std::shared_ptr<PictureImageCache> picture;
+    uint64_t lastUsed;
+};
+static std::mutex PICTURE_CACHE_LOCK;
+static std::map<std::string, CachedPicture> PICTURE_CACHE;
+static uint64_t PICTURE_CACHE_USE_COUNT = 0;
+
+std::shared_ptr<PictureImageCache> PictureImageCache::Get(const std::string& filename, bool suppressBackground)
+{
+    time_t modified = wxFileModificationTime(filename);
+    std::string key = filename + (suppressBackground ? "|1" : "|0");
+
+    std::unique_lock<std::mutex> lock(PICTURE_CACHE_LOCK);
+    CachedPicture& cached = PICTURE_CACHE[key];
+    if (cached.picture == nullptr || cached.picture->GetModified() != modified)
     {
-        if (gifImage != nullptr) {
-            delete gifImage;
-            gifImage = nullptr;
+        cached.picture = std::make_shared<PictureImageCache>(filename, modified, suppressBackground);
+    }
+    cached.lastUsed = ++PICTURE_CACHE_USE_COUNT;
+    std::shared_ptr<PictureImageCache> picture = cached.picture;
+
+    // anything evicted stays alive until the render caches still using it let go
+    size_t total = 0;
+    for (const auto& it : PICTURE_CACHE)
+    {
+        total += it.second.picture->GetBytes();
+    }
+    while (total > PICTURE_CACHE_MAX_BYTES && PICTURE_CACHE.size() > 1)
+    {
+        auto oldest = PICTURE_CACHE.end();
+        for (auto it = PICTURE_CACHE.begin(); it != PICTURE_CACHE.end(); ++it)
+        {
+            if (it->second.picture != picture && (oldest == PICTURE_CACHE.end() || it->second.lastUsed < oldest->second.lastUsed))
+            {
+                oldest = it;
+            }
         }
-    };
+        total -= oldest->second.picture->GetBytes();
+        PICTURE_CACHE.erase(oldest);
+    }
+    return picture;
+}
+
+class PicturesRenderCache : public EffectRenderCache {
+public:
+    PicturesRenderCache() : imageCount(0), frame(0), imageFrame(0), maxmovieframes(0) {};
+    virtual ~PicturesRenderCache() {};
 
-    wxImage image;
-    wxImage rawimage;
+    std::shared_ptr<PictureImageCache> picture;
+    wxSize imageSize;
     int imageCount;
     int frame;
+    int imageFrame;
     int maxmovieframes;
     wxString PictureName;
-    GIFImage* gifImage;
     std::vector<PixelVector> PixelsByFrame;
 };
 
@@ -264,12 +475,9 @@ void PicturesEffect::LoadPixelsFromTextFile(RenderBuffer &buffer, wxFile& debug,
     wxByte rgb[3] = { 0,0,0 };
     PicturesRenderCache *cache = GetCache(buffer);
     cache->imageCount = 0;
-    wxImage &image = cache->image;
-    wxImage &rawimage = cache->rawimage;
     std::vector<PixelVector> &PixelsByFrame = cache->PixelsByFrame;
 
-    if (image.GetWidth() && image.GetHeight()) image.Clear(); //CAUTION: image must be non-empty to clear it (memory error otherwise)
-    if (rawimage.GetWidth() && rawimage.GetHeight()) rawimage.Clear(); //CAUTION: image must be non-empty to clear it (memory error otherwise)
+    cache->picture = nullptr;
 
     if (!cache->PictureName.CmpNoCase(filename)) { wrdebug("no change: " + filename); return; }
     if (!wxFileExists(filename)) { wrdebug("not found: " + filename); return; }
@@ -490,9 +698,7 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     //      ffmpeg -i XXXX.mts -s 16x50 XXXX-%d.jpg
 
     PicturesRenderCache *cache = GetCache(buffer);
-    wxImage &image = cache->image;
-    wxImage &rawimage = cache->rawimage;
-    GIFImage*& gifImage = cache->gifImage;
+    std::shared_ptr<PictureImageCache>& picture = cache->picture;
     std::vector<PixelVector> &PixelsByFrame = cache->PixelsByFrame;
     int &frame = cache->frame;
 
@@ -557,59 +763,19 @@ void PicturesEffect::Render(RenderBuffer &buffer,
         return;
     }
 
-    if (NewPictureName != cache->PictureName || buffer.needToInit)
+    if (NewPictureName != cache->PictureName || buffer.needToInit || picture == nullptr)
     {
         buffer.needToInit = false;
         scale_image = true;
 
-        wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
-
-        // There seems to be a bug on linux where this function crashes occasionally
-#ifdef LINUX
-        logger_base.debug("About to count images in bitmap %s.", (const char *)NewPictureName.c_str());
-#endif
-        cache->imageCount = wxImage::GetImageCount(NewPictureName);
-        if (cache->imageCount <= 0)
-        {
-            logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)NewPictureName.c_str(), cache->imageCount);
-
-            // override it to 1
-            cache->imageCount = 1;
-        }
-
-        if (!image.LoadFile(NewPictureName, wxBITMAP_TYPE_ANY, 0))
-        {
-            logger_base.error("Error loading image file: %s.", (const char *)NewPictureName.c_str());
-            image.Create(5, 5, true);
-        }
-
-        rawimage = image;
+        picture = PictureImageCache::Get(NewPictureName.ToStdString(), suppressGIFBackground);
         cache->PictureName = NewPictureName;
+        cache->imageFrame = 0;
 
-        if (cache->imageCount > 1)
-        {
-#ifdef DEBUG_GIF
-            logger_base.debug("Preparing GIF file for reading: %s", (const char *)NewPictureName.c_str());
-#endif
-            if (gifImage != nullptr && gifImage->GetFilename() != NewPictureName)
-            {
-                delete gifImage;
-                gifImage = nullptr;
-            }
-            gifImage = new GIFImage(NewPictureName.ToStdString(), suppressGIFBackground);
-
-            if (!gifImage->IsOk())
-            {
-                delete gifImage;
-                gifImage = nullptr;
-                return;
-            }
-
-            image = gifImage->GetFrame(0);
-            rawimage = image;
-        }
-
-        if (!image.IsOk())
+        // the count is only known once the first frame has loaded the file
+        std::shared_ptr<wxImage> firstFrame = picture->GetFrame(0);
+        cache->imageCount = picture->GetImageCount();
+        if (firstFrame == nullptr)
             return;
     }
 
@@ -620,68 +786,58 @@ void PicturesEffect::Render(RenderBuffer &buffer,
 
         if (loopGIF)
         {
-            image = gifImage->GetFrameForTime((buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
+            cache->imageFrame = picture->GetFrameForTime((buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
         }
         else
         {
-            int ii = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
-            image = gifImage->GetFrame(ii);
+            cache->imageFrame = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
         }
-
-        rawimage = image;
-
-        if (!rawimage.IsOk())
-            return;
     }
 
+    std::shared_ptr<wxImage> rawimage = picture->GetFrame(cache->imageFrame);
+    if (rawimage == nullptr || !rawimage->IsOk())
+        return;
+
     if (scale_to_fit == "No Scaling" && (start_scale != end_scale))
     {
-        image = rawimage;
         scale_image = true;
     }
 
-    int imgwidth = image.GetWidth();
-    int imght = image.GetHeight();
-    int yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-    int xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
-
-    if (scale_to_fit == "Scale To Fit" && (BufferWi != imgwidth || BufferHt != imght))
+    // the size to draw the current frame at, the scaled copy itself comes from the picture cache
+    wxSize& imageSize = cache->imageSize;
+    if (scale_to_fit == "Scale To Fit" && (BufferWi != rawimage->GetWidth() || BufferHt != rawimage->GetHeight()))
     {
-        image = rawimage;
-        image.Rescale(BufferWi, BufferHt);
-        imgwidth = image.GetWidth();
-        imght = image.GetHeight();
-        yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-        xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+        imageSize = wxSize(BufferWi, BufferHt);
     }
     else if (scale_to_fit == "Scale Keep Aspect Ratio")
     {
-        image = rawimage;
-        float xr = (float)BufferWi / (float)image.GetWidth();
-        float yr = (float)BufferHt / (float)image.GetHeight();
+        float xr = (float)BufferWi / (float)rawimage->GetWidth();
+        float yr = (float)BufferHt / (float)rawimage->GetHeight();
         float sc = std::min(xr, yr);
-        image.Rescale(image.GetWidth() * sc, image.GetHeight() * sc);
-        imgwidth = image.GetWidth();
-        imght = image.GetHeight();
-        yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-        xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+        imageSize = wxSize(rawimage->GetWidth() * sc, rawimage->GetHeight() * sc);
     }
-    else
+    else if (scale_image)
     {
-        if ((start_scale != 100 || end_scale != 100) && scale_image)
+        imageSize = rawimage->GetSize();
+        if (start_scale != 100 || end_scale != 100)
         {
             int delta_scale = end_scale - start_scale;
             int current_scale = start_scale + delta_scale * position;
-            imgwidth = (image.GetWidth()*current_scale) / 100;
-            imght = (image.GetHeight()*current_scale) / 100;
-            imgwidth = std::max(imgwidth, 1);
-            imght = std::max(imght, 1);
-            image.Rescale(imgwidth, imght);
-            yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
-            xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+            imageSize.SetWidth(std::max((rawimage->GetWidth()*current_scale) / 100, 1));
+            imageSize.SetHeight(std::max((rawimage->GetHeight()*current_scale) / 100, 1));
         }
     }
 
+    std::shared_ptr<wxImage> scaledimage = picture->GetScaledFrame(cache->imageFrame, imageSize.GetWidth(), imageSize.GetHeight());
+    if (scaledimage == nullptr)
+        return;
+    const wxImage& image = *scaledimage;
+
+    int imgwidth = image.GetWidth();
+    int imght = image.GetHeight();
+    int yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
+    int xoffset = (imgwidth - BufferWi) / 2; //centered if sizes don't match
+
     int waveX = 0;
     int waveW = 0;
     int waveN = 0; //location of first wave, height adjust, width, wave# -DJ
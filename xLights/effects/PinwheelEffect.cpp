@@ -83,20 +83,49 @@ PinwheelEffect::Pinwheel3DType PinwheelEffect::to3dType(const std::string &pinwh
 }
 
 
+class PinwheelParameters : public EffectParameters
+{
+public:
+    int pinwheel_arms;
+    ValueCurveParameter pinwheel_twist;
+    ValueCurveParameter pinwheel_thickness;
+    bool pinwheel_rotation;
+    std::string pinwheel_3d;
+    ValueCurveParameter xc_adj;
+    ValueCurveParameter yc_adj;
+    ValueCurveParameter pinwheel_armsize;
+    ValueCurveParameter pspeed;
+    std::string pinwheel_style;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        pinwheel_arms = SettingsMap.GetInt("SLIDER_Pinwheel_Arms", 3);
+        pinwheel_twist.DecodeInt("Pinwheel_Twist", 0, SettingsMap, PINWHEEL_TWIST_MIN, PINWHEEL_TWIST_MAX, buffer);
+        pinwheel_thickness.DecodeInt("Pinwheel_Thickness", 0, SettingsMap, PINWHEEL_THICKNESS_MIN, PINWHEEL_THICKNESS_MAX, buffer);
+        pinwheel_rotation = SettingsMap.GetBool("CHECKBOX_Pinwheel_Rotation");
+        pinwheel_3d = SettingsMap["CHOICE_Pinwheel_3D"];
+        xc_adj.DecodeInt("PinwheelXC", 0, SettingsMap, PINWHEEL_X_MIN, PINWHEEL_X_MAX, buffer);
+        yc_adj.DecodeInt("PinwheelYC", 0, SettingsMap, PINWHEEL_Y_MIN, PINWHEEL_Y_MAX, buffer);
+        pinwheel_armsize.DecodeInt("Pinwheel_ArmSize", 100, SettingsMap, PINWHEEL_ARMSIZE_MIN, PINWHEEL_ARMSIZE_MAX, buffer);
+        pspeed.DecodeInt("Pinwheel_Speed", 10, SettingsMap, PINWHEEL_SPEED_MIN, PINWHEEL_SPEED_MAX, buffer);
+        pinwheel_style = SettingsMap["CHOICE_Pinwheel_Style"];
+    }
+};
+
 void PinwheelEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    PinwheelParameters &params = GetParameters<PinwheelParameters>(effect, SettingsMap, buffer);
 
     float oset = buffer.GetEffectTimeIntervalPosition();
 
-    int pinwheel_arms = SettingsMap.GetInt("SLIDER_Pinwheel_Arms", 3);
-    int pinwheel_twist = GetValueCurveInt("Pinwheel_Twist", 0, SettingsMap, oset, PINWHEEL_TWIST_MIN, PINWHEEL_TWIST_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_thickness = GetValueCurveInt("Pinwheel_Thickness", 0, SettingsMap, oset, PINWHEEL_THICKNESS_MIN, PINWHEEL_THICKNESS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    bool pinwheel_rotation = SettingsMap.GetBool("CHECKBOX_Pinwheel_Rotation");
-    const std::string &pinwheel_3d = SettingsMap["CHOICE_Pinwheel_3D"];
-    int xc_adj = GetValueCurveInt("PinwheelXC", 0, SettingsMap, oset, PINWHEEL_X_MIN, PINWHEEL_X_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int yc_adj = GetValueCurveInt("PinwheelYC", 0, SettingsMap, oset, PINWHEEL_Y_MIN, PINWHEEL_Y_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pinwheel_armsize = GetValueCurveInt("Pinwheel_ArmSize", 100, SettingsMap, oset, PINWHEEL_ARMSIZE_MIN, PINWHEEL_ARMSIZE_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int pspeed = GetValueCurveInt("Pinwheel_Speed", 10, SettingsMap, oset, PINWHEEL_SPEED_MIN, PINWHEEL_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    const std::string &pinwheel_style = SettingsMap["CHOICE_Pinwheel_Style"];
+    int pinwheel_arms = params.pinwheel_arms;
+    int pinwheel_twist = params.pinwheel_twist.GetInt(oset, buffer);
+    int pinwheel_thickness = params.pinwheel_thickness.GetInt(oset, buffer);
+    bool pinwheel_rotation = params.pinwheel_rotation;
+    const std::string &pinwheel_3d = params.pinwheel_3d;
+    int xc_adj = params.xc_adj.GetInt(oset, buffer);
+    int yc_adj = params.yc_adj.GetInt(oset, buffer);
+    int pinwheel_armsize = params.pinwheel_armsize.GetInt(oset, buffer);
+    int pspeed = params.pspeed.GetInt(oset, buffer);
+    const std::string &pinwheel_style = params.pinwheel_style;
 
     double pos = (double)((buffer.curPeriod - buffer.curEffStartPer) * pspeed * buffer.frameTimeInMs) / (double)PINWHEEL_SPEED_MAX;
     int degrees_per_arm = 1;
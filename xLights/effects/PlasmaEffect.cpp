@@ -60,16 +60,32 @@ void PlasmaEffect::SetDefaultParameters() {
     SetChoiceValue(pp->Choice_Plasma_Color, "Normal");
 }
 
+class PlasmaParameters : public EffectParameters
+{
+public:
+    int Style;
+    int Line_Density;
+    ValueCurveParameter PlasmaSpeed;
+    int ColorScheme;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        Style = SettingsMap.GetInt("SLIDER_Plasma_Style", 1);
+        Line_Density = SettingsMap.GetInt("SLIDER_Plasma_Line_Density", 1);
+        PlasmaSpeed.DecodeInt("Plasma_Speed", 10, SettingsMap, PLASMA_SPEED_MIN, PLASMA_SPEED_MAX, buffer);
+        ColorScheme = GetPlasmaColorScheme(SettingsMap["CHOICE_Plasma_Color"]);
+    }
+};
+
 void PlasmaEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    PlasmaParameters &params = GetParameters<PlasmaParameters>(effect, SettingsMap, buffer);
 
     float oset = buffer.GetEffectTimeIntervalPosition();
-    int Style = SettingsMap.GetInt("SLIDER_Plasma_Style", 1);
-    int Line_Density = SettingsMap.GetInt("SLIDER_Plasma_Line_Density", 1);
-    int PlasmaSpeed = GetValueCurveInt("Plasma_Speed", 10, SettingsMap, oset, PLASMA_SPEED_MIN, PLASMA_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    std::string PlasmaDirectionStr = SettingsMap["CHOICE_Plasma_Direction"];
+    int Style = params.Style;
+    int Line_Density = params.Line_Density;
+    int PlasmaSpeed = params.PlasmaSpeed.GetInt(oset, buffer);
 
     int PlasmaDirection = 0; //fixme?
-    const int ColorScheme = GetPlasmaColorScheme(SettingsMap["CHOICE_Plasma_Color"]);
+    const int ColorScheme = params.ColorScheme;
 
     //  These are for Plasma effect
     static const double pi=3.1415926535897932384626433832;
@@ -88,6 +104,7 @@ void PlasmaEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
     const double sin_time_2 = buffer.sin(time / 2);
     static const double pi3 = pi / 3.0;
 
+    const MultiColorBlendTable &blend = buffer.GetMultiColorBlendTable(false);
     int block = buffer.BufferHt * buffer.BufferWi > 100 ? 1 : -1;
     parallel_for(0, buffer.BufferWi, [&] (int x) {
         double rx = ((float)x / (buffer.BufferWi - 1)); // rx is now in the range 0.0 to 1.0
@@ -131,7 +148,7 @@ void PlasmaEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
                 case PLASMA_NORMAL_COLORS:
                     {
                         double h = (buffer.sin (vldpi + 2 * pi3) + 1) * 0.5;
-                        buffer.GetMultiColorBlend(h,false,color);
+                        color = blend.Get(h);
                     }
                     break;
                 case PLASMA_PRESET1:
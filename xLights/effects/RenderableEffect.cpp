@@ -10,6 +10,8 @@
 #include <wx/spinctrl.h>
 
 #include <sstream>
+#include <list>
+#include <unordered_map>
 #include "../UtilFunctions.h"
 #include "../ValueCurveButton.h"
 #include "PixelBuffer.h"
@@ -891,6 +893,73 @@ void RenderableEffect::SetRadioValue(wxRadioButton *r) {
     r->ProcessWindowEvent(evt);
 }
 
+namespace
+{
+    // a parsed value curve and how it was set up
+    struct CachedValueCurve
+    {
+        bool limitsFirst;
+        float min;
+        float max;
+        int divisor;
+        ValueCurve valueCurve;
+    };
+}
+
+// Parsing a value curve is far more expensive than evaluating it and effects ask for the same
+// curves every frame, so each render thread keeps the curves it has parsed and bakes them for
+// the effect being rendered.
+static ValueCurve& GetCachedValueCurve(const std::string& serialised, bool limitsFirst, float min, float max, int divisor, long startMS, long endMS)
+{
+    static thread_local std::unordered_map<std::string, std::list<CachedValueCurve>> cache;
+
+    if (cache.size() > 1000) cache.clear();
+
+    auto& curves = cache[serialised];
+    CachedValueCurve* cached = nullptr;
+    for (auto& it : curves)
+    {
+        if (it.limitsFirst == limitsFirst && it.min == min && it.max == max && it.divisor == divisor)
+        {
+            cached = &it;
+            break;
+        }
+    }
+
+    if (cached == nullptr)
+    {
+        curves.push_back(CachedValueCurve());
+        cached = &curves.back();
+        cached->limitsFirst = limitsFirst;
+        cached->min = min;
+        cached->max = max;
+        cached->divisor = divisor;
+        ValueCurve& valc = cached->valueCurve;
+        if (limitsFirst)
+        {
+            valc.SetDivisor(divisor);
+            valc.SetLimits(min, max);
+            valc.Deserialise(serialised);
+        }
+        else
+        {
+            valc.Deserialise(serialised);
+            if (valc.IsActive())
+            {
+                valc.SetLimits(min, max);
+                valc.SetDivisor(divisor);
+            }
+        }
+    }
+
+    ValueCurve& valc = cached->valueCurve;
+    if (valc.IsActive())
+    {
+        valc.Bake(startMS, endMS, ValueCurve::GetBakeFrames(startMS, endMS));
+    }
+    return valc;
+}
+
 double RenderableEffect::GetValueCurveDouble(const std::string &name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor)
 {
     double res = def;
@@ -908,16 +977,14 @@ double RenderableEffect::GetValueCurveDouble(const std::string &name, double def
         res = SettingsMap.GetDouble(tn, def);
     }
 
-    wxString vn = "VALUECURVE_" + name;
-    wxString vc = SettingsMap.Get(vn, "");
+    const std::string vn = "VALUECURVE_" + name;
+    const std::string vc = SettingsMap.Get(vn, "");
     if (vc != "")
     {
-        bool needsUpgrade = !vc.Contains("RV=TRUE");
-        ValueCurve valc(vc.ToStdString());
+        bool needsUpgrade = vc.find("RV=TRUE") == std::string::npos;
+        ValueCurve& valc = GetCachedValueCurve(vc, false, min, max, divisor, startMS, endMS);
         if (valc.IsActive())
         {
-            valc.SetLimits(min, max);
-            valc.SetDivisor(divisor);
 
             // If we ask for a double we always want it pre-divided
             //if (slider)
@@ -958,14 +1025,11 @@ int RenderableEffect::GetValueCurveInt(const std::string &name, int def, Setting
     const std::string vn = "VALUECURVE_" + name;
     if (SettingsMap.Contains(vn))
     {
-        wxString vc = SettingsMap.Get(vn, "");
+        const std::string vc = SettingsMap.Get(vn, "");
 
-        bool needsUpgrade = !vc.Contains("RV=TRUE");
+        bool needsUpgrade = vc.find("RV=TRUE") == std::string::npos;
 
-        ValueCurve valc;
-        valc.SetDivisor(divisor);
-        valc.SetLimits(min, max);
-        valc.Deserialise(vc.ToStdString());
+        ValueCurve& valc = GetCachedValueCurve(vc, true, min, max, divisor, startMS, endMS);
         if (valc.IsActive())
         {
             // If we ask for an int then we seem to want it undivided
@@ -989,4 +1053,131 @@ int RenderableEffect::GetValueCurveInt(const std::string &name, int def, Setting
     }
 
     return res;
+}
+
+
+EffectParameters *RenderableEffect::GetParameters(Effect *effect, RenderBuffer &buffer, EffectParameters *(*create)(), bool &decode)
+{
+    EffectParameters *&params = buffer.effectParameters[id];
+    decode = false;
+    if (params == nullptr)
+    {
+        params = create();
+        decode = true;
+    }
+    if (params->effect != effect || params->stateCount != buffer.stateCount)
+    {
+        decode = true;
+    }
+    params->effect = effect;
+    params->stateCount = buffer.stateCount;
+    return params;
+}
+
+static bool IsMusicValueCurve(const ValueCurve& valc)
+{
+    const std::string type = valc.GetType();
+    return type == "Music" || type == "Inverted Music" || type == "Music Trigger Fade";
+}
+
+void ValueCurveParameter::DecodeInt(const std::string &name, int def, SettingsMap &settings, int min, int max, RenderBuffer &buffer, int divisor)
+{
+    _value = def;
+    _active = false;
+    _music = false;
+
+    const std::string sn = "SLIDER_" + name;
+    const std::string tn = "TEXTCTRL_" + name;
+    if (settings.Contains(sn))
+    {
+        _value = settings.GetInt(sn, def);
+    }
+    else if (settings.Contains(tn))
+    {
+        _value = settings.GetInt(tn, def);
+    }
+
+    const std::string vn = "VALUECURVE_" + name;
+    if (settings.Contains(vn))
+    {
+        const std::string vc = settings.Get(vn, "");
+        bool needsUpgrade = vc.find("RV=TRUE") == std::string::npos;
+
+        ValueCurve& valc = GetCachedValueCurve(vc, true, min, max, divisor, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+        if (valc.IsActive())
+        {
+            _valueCurve = valc;
+            _active = true;
+            _music = IsMusicValueCurve(valc);
+            if (needsUpgrade)
+            {
+                settings[vn] = valc.Serialise();
+            }
+        }
+    }
+}
+
+void ValueCurveParameter::DecodeDouble(const std::string &name, double def, SettingsMap &settings, double min, double max, RenderBuffer &buffer, int divisor)
+{
+    _value = def;
+    _active = false;
+    _music = false;
+
+    const std::string sn = "SLIDER_" + name;
+    const std::string tn = "TEXTCTRL_" + name;
+    if (settings.Contains(sn))
+    {
+        _value = settings.GetDouble(sn, def);
+    }
+    else if (settings.Contains(tn))
+    {
+        _value = settings.GetDouble(tn, def);
+    }
+
+    const std::string vn = "VALUECURVE_" + name;
+    const std::string vc = settings.Get(vn, "");
+    if (vc != "")
+    {
+        bool needsUpgrade = vc.find("RV=TRUE") == std::string::npos;
+
+        ValueCurve& valc = GetCachedValueCurve(vc, false, min, max, divisor, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+        if (valc.IsActive())
+        {
+            _valueCurve = valc;
+            _active = true;
+            _music = IsMusicValueCurve(valc);
+            if (needsUpgrade)
+            {
+                settings[vn] = valc.Serialise();
+            }
+        }
+    }
+}
+
+int ValueCurveParameter::GetInt(float offset, const RenderBuffer &buffer)
+{
+    if (_music)
+    {
+        ValueCurve valc = _valueCurve;
+        return valc.GetOutputValueAt(offset, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    }
+    if (_active)
+    {
+        return _valueCurve.GetOutputValueAt(offset, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    }
+    return (int)_value;
+}
+
+double ValueCurveParameter::GetDouble(float offset, const RenderBuffer &buffer)
+{
+    if (_music)
+    {
+        ValueCurve valc = _valueCurve;
+        return valc.GetOutputValueAtDivided(offset, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    }
+    if (_active)
+    {
+        return _valueCurve.GetOutputValueAtDivided(offset, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    }
+    return _value;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <wx/bitmap.h>
 #include <string>
 #include "../Color.h"
+#include "../ValueCurve.h"
 #include "assist/AssistPanel.h"
 
 class wxPanel;
@@ -18,6 +19,27 @@ class wxSlider;
 class wxCheckBox;
 class AudioManager;
 class wxSpinCtrl;
+class EffectParameters;
+
+// A setting that comes from its SLIDER_ or TEXTCTRL_ control unless its VALUECURVE_ is active.
+// Decoding matches GetValueCurveInt/GetValueCurveDouble but only looks the settings up once.
+class ValueCurveParameter
+{
+    public:
+        ValueCurveParameter() : _value(0.0), _active(false), _music(false) {}
+
+        void DecodeInt(const std::string &name, int def, SettingsMap &settings, int min, int max, RenderBuffer &buffer, int divisor = 1);
+        void DecodeDouble(const std::string &name, double def, SettingsMap &settings, double min, double max, RenderBuffer &buffer, int divisor = 1);
+        bool IsActive() const { return _active; }
+        int GetInt(float offset, const RenderBuffer &buffer);
+        double GetDouble(float offset, const RenderBuffer &buffer);
+
+    private:
+        double _value;
+        bool _active;
+        bool _music; // music curves follow the audio so each value comes from a fresh copy of the curve
+        ValueCurve _valueCurve;
+};
 
 class RenderableEffect
 {
@@ -85,6 +107,19 @@ class RenderableEffect
 
         double GetValueCurveDouble(const std::string & name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor = 1);
         int GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor = 1);
+        // the settings decoded into a P, P::Decode(settings, buffer) runs when the effect starts
+        // rendering into the buffer and the frames that follow reuse the result
+        template <class P>
+        P &GetParameters(Effect *effect, SettingsMap &settings, RenderBuffer &buffer)
+        {
+            bool decode = false;
+            P *params = static_cast<P*>(GetParameters(effect, buffer, []() -> EffectParameters* { return new P(); }, decode));
+            if (decode) {
+                params->Decode(settings, buffer);
+            }
+            return *params;
+        }
+        EffectParameters *GetParameters(Effect *effect, RenderBuffer &buffer, EffectParameters *(*create)(), bool &decode);
         bool IsVersionOlder(const std::string& compare, const std::string& version);
         void AdjustSettingsToBeFitToTime(int effectIdx, SettingsMap &settings, int startMS, int endMS, xlColorVector &colors);
         virtual void RemoveDefaults(const std::string &version, Effect *effect);
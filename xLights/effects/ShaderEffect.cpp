@@ -59,6 +59,7 @@
 #include "../xLightsApp.h"
 #include "../TimingPanel.h"
 #include "OpenGLShaders.h"
+#include "../DrawGLUtils.h"
 #include "UtilFunctions.h"
 #include "../../xSchedule/wxJSON/jsonreader.h"
 
@@ -67,6 +68,16 @@
 #include <log4cpp/Category.hh>
 #include <fstream>
 
+#ifdef LINUX
+    // keep X out of the EGL headers, the surfaceless platform doesn't need it
+    #define EGL_NO_X11
+    #define MESA_EGL_NO_X11_HEADERS
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+    #include <dlfcn.h>
+    #include <functional>
+#endif
+
 namespace
 {
 #ifndef GL_CLAMP_TO_EDGE
@@ -405,6 +416,207 @@ private:
     std::mutex lock;
     std::queue<GLContextInfo*> contexts;
 } GL_CONTEXT_POOL;
+#elif defined(LINUX)
+
+// Shader effects render into their own framebuffer so they don't need a window.  An EGL context on
+// a surfaceless display (Mesa's llvmpipe when there is no GPU) lets each shader effect render on
+// whichever thread renders it, and on machines with no display at all.  libEGL is loaded at run
+// time and without it shaders fall back to the preview's context on the main thread.
+static struct {
+    decltype(&eglGetProcAddress) GetProcAddress = nullptr;
+    decltype(&eglGetDisplay) GetDisplay = nullptr;
+    decltype(&eglInitialize) Initialize = nullptr;
+    decltype(&eglTerminate) Terminate = nullptr;
+    decltype(&eglQueryString) QueryString = nullptr;
+    decltype(&eglBindAPI) BindAPI = nullptr;
+    decltype(&eglChooseConfig) ChooseConfig = nullptr;
+    decltype(&eglCreateContext) CreateContext = nullptr;
+    decltype(&eglDestroyContext) DestroyContext = nullptr;
+    decltype(&eglMakeCurrent) MakeCurrent = nullptr;
+    decltype(&eglGetError) GetError = nullptr;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplayEXT = nullptr;
+} EGL;
+
+static bool HasExtension(const char* extensions, const char* name)
+{
+    return extensions != nullptr && wxSplit(extensions, ' ').Index(name) != wxNOT_FOUND;
+}
+
+class GLContextInfo {
+public:
+    GLContextInfo(EGLDisplay display, EGLContext context) : _display(display), _context(context) {}
+    ~GLContextInfo() {
+        EGL.DestroyContext(_display, _context);
+    }
+    bool SetCurrent() {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        if (EGL.MakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context) != EGL_TRUE) {
+            logger_opengl.error("ShaderEffect unable to give thread %d EGL context 0x%llx - 0x%x.", wxThread::GetCurrentId(), (uint64_t)_context, EGL.GetError());
+            return false;
+        }
+        if (_release) {
+            _release();
+            _release = nullptr;
+        }
+        return true;
+    }
+    void UnsetCurrent() {
+        EGL.MakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    // the GL objects of an effect that has finished with the context can't be deleted on the thread
+    // that lets it go, it may already have the preview's context, so they go when it is next used
+    void ReleaseOnNextUse(std::function<void()> release) {
+        _release = release;
+    }
+
+private:
+    EGLDisplay _display;
+    EGLContext _context;
+    std::function<void()> _release;
+};
+
+class GLContextPool {
+public:
+
+    GLContextPool() {
+    }
+    ~GLContextPool() {
+        while (!contexts.empty()) {
+            GLContextInfo *ret = contexts.front();
+            delete ret;
+            contexts.pop();
+        }
+        if (display != EGL_NO_DISPLAY) {
+            EGL.Terminate(display);
+        }
+    }
+
+    bool IsAvailable() {
+        std::call_once(initialised, [this]() { available = Initialise(); });
+        return available;
+    }
+
+    GLContextInfo *GetContext() {
+        if (!IsAvailable()) {
+            return nullptr;
+        }
+        {
+            std::unique_lock<std::mutex> locker(lock);
+            if (!contexts.empty()) {
+                GLContextInfo *ret = contexts.front();
+                contexts.pop();
+                return ret;
+            }
+        }
+        return create();
+    }
+    void ReleaseContext(GLContextInfo *pctx) {
+        std::unique_lock<std::mutex> locker(lock);
+        contexts.push(pctx);
+    }
+
+private:
+    bool Initialise() {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+
+        void *lib = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (lib == nullptr) {
+            logger_opengl.info("ShaderEffect - libEGL not found, shaders will render on the main thread.");
+            return false;
+        }
+        EGL.GetProcAddress = (decltype(EGL.GetProcAddress))dlsym(lib, "eglGetProcAddress");
+        EGL.GetDisplay = (decltype(EGL.GetDisplay))dlsym(lib, "eglGetDisplay");
+        EGL.Initialize = (decltype(EGL.Initialize))dlsym(lib, "eglInitialize");
+        EGL.Terminate = (decltype(EGL.Terminate))dlsym(lib, "eglTerminate");
+        EGL.QueryString = (decltype(EGL.QueryString))dlsym(lib, "eglQueryString");
+        EGL.BindAPI = (decltype(EGL.BindAPI))dlsym(lib, "eglBindAPI");
+        EGL.ChooseConfig = (decltype(EGL.ChooseConfig))dlsym(lib, "eglChooseConfig");
+        EGL.CreateContext = (decltype(EGL.CreateContext))dlsym(lib, "eglCreateContext");
+        EGL.DestroyContext = (decltype(EGL.DestroyContext))dlsym(lib, "eglDestroyContext");
+        EGL.MakeCurrent = (decltype(EGL.MakeCurrent))dlsym(lib, "eglMakeCurrent");
+        EGL.GetError = (decltype(EGL.GetError))dlsym(lib, "eglGetError");
+        if (EGL.GetProcAddress == nullptr || EGL.GetDisplay == nullptr || EGL.Initialize == nullptr
+            || EGL.Terminate == nullptr || EGL.QueryString == nullptr || EGL.BindAPI == nullptr
+            || EGL.ChooseConfig == nullptr || EGL.CreateContext == nullptr || EGL.DestroyContext == nullptr
+            || EGL.MakeCurrent == nullptr || EGL.GetError == nullptr) {
+            logger_opengl.warn("ShaderEffect - libEGL is missing functions, shaders will render on the main thread.");
+            return false;
+        }
+
+        // the surfaceless platform needs neither X nor a GPU
+        if (HasExtension(EGL.QueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+            EGL.GetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)EGL.GetProcAddress("eglGetPlatformDisplayEXT");
+        }
+        if (EGL.GetPlatformDisplayEXT != nullptr) {
+            display = EGL.GetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = EGL.GetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || EGL.Initialize(display, &major, &minor) != EGL_TRUE) {
+            logger_opengl.warn("ShaderEffect - unable to initialise an EGL display, shaders will render on the main thread.");
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+        if (!HasExtension(EGL.QueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")
+            || EGL.BindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+            logger_opengl.warn("ShaderEffect - EGL %d.%d has no surfaceless OpenGL contexts, shaders will render on the main thread.", major, minor);
+            return false;
+        }
+        const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLint numConfigs = 0;
+        if (EGL.ChooseConfig(display, configAttribs, &config, 1, &numConfigs) != EGL_TRUE || numConfigs == 0) {
+            logger_opengl.warn("ShaderEffect - no EGL config for OpenGL, shaders will render on the main thread.");
+            return false;
+        }
+
+        // make sure there is a context that works and the GL entry points are loaded even if no
+        // preview canvas has been created
+        GLContextInfo *ctx = create();
+        if (ctx == nullptr || !ctx->SetCurrent()) {
+            delete ctx;
+            return false;
+        }
+        if (!OpenGLShaders::HasShaderSupport() || !OpenGLShaders::HasFramebufferObjects()) {
+            DrawGLUtils::LoadGLFunctions();
+        }
+        logger_opengl.info("ShaderEffect - EGL %d.%d glVer: %s (%s)(%s)", major, minor,
+                           (const char *)glGetString(GL_VERSION),
+                           (const char *)glGetString(GL_RENDERER),
+                           (const char *)glGetString(GL_VENDOR));
+        ctx->UnsetCurrent();
+        ReleaseContext(ctx);
+        return true;
+    }
+
+    GLContextInfo *create() {
+        static log4cpp::Category& logger_opengl = log4cpp::Category::getInstance(std::string("log_opengl"));
+        // same core profile the preview asks for, 3.1 where 3.3 isn't there
+        EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+                             EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+                             EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+                             EGL_NONE };
+        EGLContext context = EGL.CreateContext(display, config, EGL_NO_CONTEXT, attribs);
+        if (context == EGL_NO_CONTEXT) {
+            attribs[3] = 1;
+            context = EGL.CreateContext(display, config, EGL_NO_CONTEXT, attribs);
+        }
+        if (context == EGL_NO_CONTEXT) {
+            logger_opengl.error("ShaderEffect unable to create EGL context - 0x%x.", EGL.GetError());
+            return nullptr;
+        }
+        logger_opengl.debug("ShaderEffect Thread %d created EGL context 0x%llx.", wxThread::GetCurrentId(), (uint64_t)context);
+        return new GLContextInfo(display, context);
+    }
+
+    std::once_flag initialised;
+    bool available = false;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLConfig config = nullptr;
+    std::mutex lock;
+    std::queue<GLContextInfo*> contexts;
+} GL_CONTEXT_POOL;
 #endif
 
 
@@ -428,7 +640,18 @@ public:
             GL_CONTEXT_POOL.ReleaseContext(glContextInfo);
         }
 #else
-        if (preview) {
+        if (glContextInfo) {
+            unsigned vertexArrayId = s_vertexArrayId;
+            unsigned vertexBufferId = s_vertexBufferId;
+            unsigned fbId = s_fbId;
+            unsigned rbId = s_rbId;
+            unsigned rbTex = s_rbTex;
+            unsigned programId = s_programId;
+            glContextInfo->ReleaseOnNextUse([vertexArrayId, vertexBufferId, fbId, rbId, rbTex, programId]() {
+                DestroyResources(vertexArrayId, vertexBufferId, fbId, rbId, rbTex, programId);
+            });
+            GL_CONTEXT_POOL.ReleaseContext(glContextInfo);
+        } else if (preview) {
             unsigned vertexArrayId = s_vertexArrayId;
             unsigned vertexBufferId = s_vertexBufferId;
             unsigned fbId = s_fbId;
@@ -517,7 +740,8 @@ public:
 #elif defined(__WXMSW__)
     GLContextInfo *glContextInfo = nullptr;
 #else
-    xlGLCanvas *preview;
+    GLContextInfo *glContextInfo = nullptr;
+    xlGLCanvas *preview = nullptr;
 #endif
 };
 
@@ -529,15 +753,16 @@ bool ShaderEffect::CanRenderOnBackgroundThread(Effect* effect, const SettingsMap
     // the OSX GL engine is thread safe.
     //
     // on windows, we need to create the GL contexts on the main thread, but then can use them
-    // on the background thread.  Similar to the Path and text drawing contexts
+    // on the background thread.  Similar to the text drawing contexts
     return true;
 #else
-    return false;
+    // EGL contexts can be used on any thread, the preview's context only on the main one
+    return GL_CONTEXT_POOL.IsAvailable();
 #endif
 }
 
 void ShaderEffect::UnsetGLContext(ShaderRenderCache* cache) {
-#if defined(__WXMSW__)
+#if !defined(__WXOSX__)
     if (cache->glContextInfo != nullptr) {
         // release it from the thread every time so we never find ourselves in a situation where it has not been released by a thread
         cache->glContextInfo->UnsetCurrent();
@@ -545,7 +770,7 @@ void ShaderEffect::UnsetGLContext(ShaderRenderCache* cache) {
 #endif
 }
 
-void ShaderEffect::SetGLContext(ShaderRenderCache *cache) {
+bool ShaderEffect::SetGLContext(ShaderRenderCache *cache) {
 #if defined(__WXOSX__)
     if (cache->s_glContext == nullptr) {
         wxGLAttributes attributes;
@@ -588,10 +813,21 @@ void ShaderEffect::SetGLContext(ShaderRenderCache *cache) {
         cache->glContextInfo->SetCurrent();
     }
 #else
+    if (cache->glContextInfo == nullptr && cache->preview == nullptr && GL_CONTEXT_POOL.IsAvailable()) {
+        // we grab it here and release it when the cache is deleted
+        cache->glContextInfo = GL_CONTEXT_POOL.GetContext();
+        if (cache->glContextInfo == nullptr) {
+            return false;
+        }
+    }
+    if (cache->glContextInfo != nullptr) {
+        return cache->glContextInfo->SetCurrent();
+    }
     ShaderPanel *p = (ShaderPanel *)panel;
     cache->preview = p->_preview;
     p->_preview->SetCurrentGLContext();
 #endif
+    return true;
 }
 
 
@@ -599,20 +835,22 @@ void ShaderEffect::Render(Effect* eff, SettingsMap& SettingsMap, RenderBuffer& b
 {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    // Bail out right away if we don't have the necessary OpenGL support
-    if (!OpenGLShaders::HasFramebufferObjects() || !OpenGLShaders::HasShaderSupport())
-    {
-        setRenderBufferAll(buffer, *wxCYAN);
-        logger_base.error("ShaderEffect::Render() - missing OpenGL support!!");
-        return;
-    }
-
     ShaderRenderCache* cache = (ShaderRenderCache*)buffer.infoCache[id];
     if (cache == nullptr) {
         cache = new ShaderRenderCache();
         buffer.infoCache[id] = cache;
     }
 
+    // Bail out right away if we don't have the necessary OpenGL support, the context
+    // comes first as a headless context is what loads the GL functions
+    if (!SetGLContext(cache) || !OpenGLShaders::HasFramebufferObjects() || !OpenGLShaders::HasShaderSupport())
+    {
+        UnsetGLContext(cache);
+        setRenderBufferAll(buffer, *wxCYAN);
+        logger_base.error("ShaderEffect::Render() - missing OpenGL support!!");
+        return;
+    }
+
     // This object has all the data from the json in the .fs file
     ShaderConfig*& _shaderConfig = cache->_shaderConfig;
     bool& s_shadersInit = cache->s_shadersInit;
@@ -626,8 +864,6 @@ void ShaderEffect::Render(Effect* eff, SettingsMap& SettingsMap, RenderBuffer& b
     int& s_rbHeight = cache->s_rbHeight;
     long& _timeMS = cache->_timeMS;
 
-    SetGLContext(cache);
-
     float oset = buffer.GetEffectTimeIntervalPosition();
     double timeRate = GetValueCurveDouble("Shader_Speed", 100, SettingsMap, oset, SHADER_SPEED_MIN, SHADER_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
 
@@ -359,10 +359,10 @@ void ShapeEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
     if (useMusic)
     {
         if (buffer.GetMedia() != nullptr) {
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty())
             {
-                f = *pf->begin();
+                f = pf.front();
             }
         }
     }
@@ -59,16 +59,41 @@ void ShockwaveEffect::SetDefaultParameters() {
 const double PI  =3.141592653589793238463;
 #define ToRadians(x) ((double)x * PI / (double)180.0)
 
+class ShockwaveParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter center_x;
+    ValueCurveParameter center_y;
+    ValueCurveParameter start_radius;
+    ValueCurveParameter end_radius;
+    ValueCurveParameter start_width;
+    ValueCurveParameter end_width;
+    int acceleration;
+    bool blend_edges;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        center_x.DecodeInt("Shockwave_CenterX", 50, SettingsMap, SHOCKWAVE_X_MIN, SHOCKWAVE_X_MAX, buffer);
+        center_y.DecodeInt("Shockwave_CenterY", 50, SettingsMap, SHOCKWAVE_Y_MIN, SHOCKWAVE_Y_MAX, buffer);
+        start_radius.DecodeInt("Shockwave_Start_Radius", 0, SettingsMap, SHOCKWAVE_STARTRADIUS_MIN, SHOCKWAVE_STARTRADIUS_MAX, buffer);
+        end_radius.DecodeInt("Shockwave_End_Radius", 0, SettingsMap, SHOCKWAVE_ENDRADIUS_MIN, SHOCKWAVE_ENDRADIUS_MAX, buffer);
+        start_width.DecodeInt("Shockwave_Start_Width", 0, SettingsMap, SHOCKWAVE_STARTWIDTH_MIN, SHOCKWAVE_STARTWIDTH_MAX, buffer);
+        end_width.DecodeInt("Shockwave_End_Width", 0, SettingsMap, SHOCKWAVE_ENDWIDTH_MIN, SHOCKWAVE_ENDWIDTH_MAX, buffer);
+        acceleration = SettingsMap.GetInt("SLIDER_Shockwave_Accel", 0);
+        blend_edges = SettingsMap.GetBool("CHECKBOX_Shockwave_Blend_Edges");
+    }
+};
+
 void ShockwaveEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    ShockwaveParameters &params = GetParameters<ShockwaveParameters>(effect, SettingsMap, buffer);
     double eff_pos = buffer.GetEffectTimeIntervalPosition();
-    int center_x = GetValueCurveInt("Shockwave_CenterX", 50, SettingsMap, eff_pos, SHOCKWAVE_X_MIN, SHOCKWAVE_X_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int center_y = GetValueCurveInt("Shockwave_CenterY", 50, SettingsMap, eff_pos, SHOCKWAVE_Y_MIN, SHOCKWAVE_Y_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_radius = GetValueCurveInt("Shockwave_Start_Radius", 0, SettingsMap, eff_pos, SHOCKWAVE_STARTRADIUS_MIN, SHOCKWAVE_STARTRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int end_radius = GetValueCurveInt("Shockwave_End_Radius", 0, SettingsMap, eff_pos, SHOCKWAVE_ENDRADIUS_MIN, SHOCKWAVE_ENDRADIUS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int start_width = GetValueCurveInt("Shockwave_Start_Width", 0, SettingsMap, eff_pos, SHOCKWAVE_STARTWIDTH_MIN, SHOCKWAVE_STARTWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int end_width = GetValueCurveInt("Shockwave_End_Width", 0, SettingsMap, eff_pos, SHOCKWAVE_ENDWIDTH_MIN, SHOCKWAVE_ENDWIDTH_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int acceleration = SettingsMap.GetInt("SLIDER_Shockwave_Accel", 0);
-    bool blend_edges = SettingsMap.GetBool("CHECKBOX_Shockwave_Blend_Edges");
+    int center_x = params.center_x.GetInt(eff_pos, buffer);
+    int center_y = params.center_y.GetInt(eff_pos, buffer);
+    int start_radius = params.start_radius.GetInt(eff_pos, buffer);
+    int end_radius = params.end_radius.GetInt(eff_pos, buffer);
+    int start_width = params.start_width.GetInt(eff_pos, buffer);
+    int end_width = params.end_width.GetInt(eff_pos, buffer);
+    int acceleration = params.acceleration;
+    bool blend_edges = params.blend_edges;
 
     int num_colors = buffer.palette.Size();
     if( num_colors == 0 )
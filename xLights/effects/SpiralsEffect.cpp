@@ -52,21 +52,48 @@ bool SpiralsEffect::SupportsLinearColorCurves(const SettingsMap &SettingsMap) co
     return !SettingsMap.GetBool("E_CHECKBOX_Spirals_Blend");
 }
 
+class SpiralsParameters : public EffectParameters
+{
+public:
+    ValueCurveParameter PaletteRepeat;
+    ValueCurveParameter Movement;
+    ValueCurveParameter Rotation;
+    ValueCurveParameter Thickness;
+    bool Blend;
+    bool Show3D;
+    bool grow;
+    bool shrink;
+    bool rotationCurve;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        PaletteRepeat.DecodeInt("Spirals_Count", 1, SettingsMap, SPIRALS_COUNT_MIN, SPIRALS_COUNT_MAX, buffer);
+        Movement.DecodeDouble("Spirals_Movement", 1.0, SettingsMap, SPIRALS_MOVEMENT_MIN, SPIRALS_MOVEMENT_MAX, buffer, SPIRALS_MOVEMENT_DIVISOR);
+        Rotation.DecodeDouble("Spirals_Rotation", 0.0, SettingsMap, SPIRALS_ROTATION_MIN, SPIRALS_ROTATION_MAX, buffer, SPIRALS_ROTATION_DIVISOR);
+        // This is because spirals uses the slider while most others use the TextCtrl
+        rotationCurve = SettingsMap.Contains("VALUECURVE_Spirals_Rotation") && wxString(SettingsMap["VALUECURVE_Spirals_Rotation"]).Contains("Active=TRUE");
+        Thickness.DecodeInt("Spirals_Thickness", 0, SettingsMap, SPIRALS_THICKNESS_MIN, SPIRALS_THICKNESS_MAX, buffer);
+        Blend = SettingsMap.GetBool("CHECKBOX_Spirals_Blend");
+        Show3D = SettingsMap.GetBool("CHECKBOX_Spirals_3D");
+        grow = SettingsMap.GetBool("CHECKBOX_Spirals_Grow");
+        shrink = SettingsMap.GetBool("CHECKBOX_Spirals_Shrink");
+    }
+};
+
 void SpiralsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    SpiralsParameters &params = GetParameters<SpiralsParameters>(effect, SettingsMap, buffer);
     float offset = buffer.GetEffectTimeIntervalPosition();
-    int PaletteRepeat = GetValueCurveInt("Spirals_Count", 1, SettingsMap, offset, SPIRALS_COUNT_MIN, SPIRALS_COUNT_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    float Movement = GetValueCurveDouble("Spirals_Movement", 1.0, SettingsMap, offset, SPIRALS_MOVEMENT_MIN, SPIRALS_MOVEMENT_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), SPIRALS_MOVEMENT_DIVISOR);
-    float Rotation = GetValueCurveDouble("Spirals_Rotation", 0.0, SettingsMap, offset, SPIRALS_ROTATION_MIN, SPIRALS_ROTATION_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), SPIRALS_ROTATION_DIVISOR);
-    // This is because spirals uses the slider while most others use the TextCtrl
-    if (SettingsMap.Contains("VALUECURVE_Spirals_Rotation") && wxString(SettingsMap["VALUECURVE_Spirals_Rotation"]).Contains("Active=TRUE"))
+    int PaletteRepeat = params.PaletteRepeat.GetInt(offset, buffer);
+    float Movement = params.Movement.GetDouble(offset, buffer);
+    float Rotation = params.Rotation.GetDouble(offset, buffer);
+    if (params.rotationCurve)
     {
         Rotation *= 10;
     }
-    int Thickness = GetValueCurveInt("Spirals_Thickness", 0, SettingsMap, offset, SPIRALS_THICKNESS_MIN, SPIRALS_THICKNESS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    bool Blend = SettingsMap.GetBool("CHECKBOX_Spirals_Blend");
-    bool Show3D = SettingsMap.GetBool("CHECKBOX_Spirals_3D");
-    bool grow = SettingsMap.GetBool("CHECKBOX_Spirals_Grow");
-    bool shrink = SettingsMap.GetBool("CHECKBOX_Spirals_Shrink");
+    int Thickness = params.Thickness.GetInt(offset, buffer);
+    bool Blend = params.Blend;
+    bool Show3D = params.Show3D;
+    bool grow = params.grow;
+    bool shrink = params.shrink;
 
     if (PaletteRepeat == 0) {
         PaletteRepeat = 1;
@@ -96,6 +123,7 @@ void SpiralsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffe
 
     SpiralThickness += ThicknessState;
 
+    const MultiColorBlendTable *blend = Blend ? &buffer.GetMultiColorBlendTable(false) : nullptr;
     for (int ns = 0; ns < SpiralCount; ns++)
     {
         int strand_base = ns * deltaStrands;
@@ -117,7 +145,7 @@ void SpiralsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffe
 
                 if (Blend)
                 {
-                    buffer.GetMultiColorBlend(double(buffer.BufferHt - y - 1) / double(buffer.BufferHt), false, color);
+                    color = blend->Get(double(buffer.BufferHt - y - 1) / double(buffer.BufferHt));
                 }
                 if (Show3D)
                 {
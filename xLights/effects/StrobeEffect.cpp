@@ -88,9 +88,9 @@ void StrobeEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
     if (reactToMusic) {
         float f = 0.0;
         if (buffer.GetMedia() != nullptr) {
-            std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->begin();
+            FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty()) {
+                f = pf.front();
             }
         }
         Number_Strobes *= f;
@@ -6,7 +6,6 @@
 #include "../UtilClasses.h"
 #include "../AudioManager.h"
 
-#include <wx/graphics.h>
 #if wxUSE_GRAPHICS_CONTEXT == 0
   #error Please refer to README.windows to make necessary changes to wxWidgets setup.h file.
   #error You will also need to rebuild wxWidgets once the change is made.
@@ -190,14 +189,10 @@ void ATendril::Update(wxPoint* target)
 	}
 }
 
-void ATendril::Draw(PathDrawingContext* gc, xlColor colour, int thickness)
+void ATendril::Draw(RenderBuffer& buffer, PathRasteriser& path, xlColor colour, int thickness)
 {
-    wxColor c(colour);
-    wxPen pen(c, thickness);
-    gc->SetPen(pen);
-
-    wxGraphicsPath path = gc->CreatePath();
-    path.MoveToPoint(_nodes.front()->x, _nodes.front()->y);
+    path.Clear();
+    path.MoveTo(_nodes.front()->x, _nodes.front()->y);
 
     std::list<TendrilNode*>::const_iterator ci = _nodes.begin();
     ++ci; // move to second node
@@ -214,13 +209,13 @@ void ATendril::Draw(PathDrawingContext* gc, xlColor colour, int thickness)
         TendrilNode* b = *cinext;
         float x = (a->x + b->x) * 0.5;
         float y = (a->y + b->y) * 0.5;
-        path.AddQuadCurveToPoint(a->x, a->y, x, y);
+        path.QuadTo(a->x, a->y, x, y);
     }
 
     TendrilNode* a = *ci;
     TendrilNode* b = *(++ci);
-    path.AddQuadCurveToPoint(a->x, a->y, b->x, b->y);
-    gc->StrokePath(path);
+    path.QuadTo(a->x, a->y, b->x, b->y);
+    path.Stroke(buffer, colour, thickness);
 }
 
 wxPoint* ATendril::LastLocation()
@@ -389,11 +384,13 @@ void Tendril::Update(int x, int y)
     Update(&pt);
 }
 
-void Tendril::Draw(PathDrawingContext* gc, xlColor colour, int thickness)
+void Tendril::Draw(RenderBuffer& buffer, xlColor colour, int thickness)
 {
+    // aliased to match the way the tendrils have always been drawn
+    PathRasteriser path(false);
 	for (std::list<ATendril*>::const_iterator ci = _tendrils.begin(); ci != _tendrils.end(); ++ci)
 	{
-		(*ci)->Draw(gc, colour, thickness);
+		(*ci)->Draw(buffer, path, colour, thickness);
 	}
 }
 
@@ -526,7 +523,6 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
     float tension, int trails, int length, int xoffset, int yoffset, int manualx, int manualy)
 {
     float oset = buffer.GetEffectTimeIntervalPosition();
-    buffer.GetPathDrawingContext()->Clear();
 
     if (friction < 0.4f)
     {
@@ -813,10 +809,10 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
             float f = 0.1f;
             if (buffer.GetMedia() != nullptr)
             {
-                std::list<float>* p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                if (p != nullptr)
+                FrameDataView p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                if (!p.empty())
                 {
-                    f = *p->begin();
+                    f = p.front();
                 }
             }
 
@@ -843,10 +839,10 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
             float f = 0.1f;
             if (buffer.GetMedia() != nullptr)
             {
-                std::list<float>* p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                if (p != nullptr)
+                FrameDataView p = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                if (!p.empty())
                 {
-                    f = *p->begin();
+                    f = p.front();
                 }
             }
 
@@ -919,27 +915,10 @@ void TendrilEffect::Render(RenderBuffer &buffer, const std::string& movement,
         }
     }
 
+    // the tendrils replace the whole buffer like the drawn image used to
+    buffer.Clear();
     if (_tendril != nullptr)
     {
-        _tendril->Draw(buffer.GetPathDrawingContext(), colour, thickness);
-    }
-    wxImage * image = buffer.GetPathDrawingContext()->FlushAndGetImage();
-    bool hasAlpha = image->HasAlpha();
-
-    xlColor c;
-    for (int y = 0; y < buffer.BufferHt; y++)
-    {
-        for (int x = 0; x < buffer.BufferWi; x++)
-        {
-            if (hasAlpha)
-            {
-                c.Set(image->GetRed(x, y), image->GetGreen(x, y), image->GetBlue(x, y), image->GetAlpha(x, y));
-            }
-            else
-            {
-                c.Set(image->GetRed(x, y), image->GetGreen(x, y), image->GetBlue(x, y), 255);
-            }
-            buffer.SetPixel(x, y, c);
-        }
+        _tendril->Draw(buffer, colour, thickness);
     }
 }
@@ -58,7 +58,7 @@ class ATendril
 	~ATendril();
 	ATendril(float friction, int size, float dampening, float tension, float spring, const wxPoint& start, size_t maxx, size_t maxy);
 	void Update(wxPoint* target);
-	void Draw(PathDrawingContext* gc, xlColor colour, int thickness);
+	void Draw(RenderBuffer& buffer, PathRasteriser& path, xlColor colour, int thickness);
 	wxPoint* LastLocation();
 };
 
@@ -75,7 +75,7 @@ class Tendril
 	void UpdateRandomMove(int tunemovement);
     void Update(wxPoint* target);
     void Update(int x, int y);
-    void Draw(PathDrawingContext* gc, xlColor colour, int thickness);
+    void Draw(RenderBuffer& buffer, xlColor colour, int thickness);
 };
 
 class TendrilEffect : public RenderableEffect
@@ -85,9 +85,6 @@ class TendrilEffect : public RenderableEffect
         virtual ~TendrilEffect();
         virtual void SetDefaultParameters() override;
         virtual void Render(Effect *effect, SettingsMap &settings, RenderBuffer &buffer) override;
-#ifdef LINUX
-        virtual bool CanRenderOnBackgroundThread(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) override { return false;}
-#endif
         virtual bool AppropriateOnNodes() const override { return false; }
         virtual bool SupportsRenderCache(const SettingsMap& settings) const override { return true; }
 
@@ -2,10 +2,15 @@
 
 #include <mutex>
 #include <array>
-#include <unordered_map>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 #include "TextPanel.h"
 #include <wx/checkbox.h>
+#include <wx/math.h>
+#include <wx/thread.h>
 
 #include "../sequencer/Effect.h"
 #include "../sequencer/Element.h"
@@ -537,8 +542,7 @@ void TextEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &
         int endx = wxAtoi(SettingsMap.Get("SLIDER_Text_XEnd", "0"));
         bool pixelOffsets = wxAtoi(SettingsMap.Get("CHECKBOX_Text_PixelOffsets", "0"));
 
-        wxImage * i = RenderTextLine(buffer,
-                       buffer.GetTextDrawingContext(),
+        RenderTextLine(buffer,
                        text,
                        SettingsMap["FONTPICKER_Text_Font"],
                        TextEffectDirectionsIndex(SettingsMap["CHOICE_Text_Dir"]),
@@ -547,299 +551,441 @@ void TextEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &
                        TextCountDownIndex(SettingsMap["CHOICE_Text_Count"]),
                        wxAtoi(SettingsMap.Get("TEXTCTRL_Text_Speed", "10")),
                        startx, starty, endx, endy, pixelOffsets);
-        
-        if (i == nullptr) {
-            return;
-        }
-        xlColor c;
-        bool ha = i->HasAlpha();
-        unsigned char* data = i->GetData();
-        unsigned char* alpha = ha ? i->GetAlpha() : nullptr;
-        int w = i->GetWidth();
-        int h = i->GetHeight();
-        int cur = 0;
-        int cura = 0;
-        for(int y = h - 1; y >= 0; y--)
-        {
-            for(int x=0; x < w; x++)
-            {
-                if (ha) {
-                    c.Set(data[cur], data[cur + 1], data[cur + 2], alpha[cura++]);
-                } else {
-                    c.Set(data[cur], data[cur + 1], data[cur + 2]);
-                    if (c == xlBLACK) {
-                        c.alpha = 0;
-                    }
-                }
-                cur += 3;
-                buffer.SetPixel(x, y, c);
-            }
-        }
     }
 }
 
-wxSize GetMultiLineTextExtent(TextDrawingContext *dc,
-                              const wxString& text,
-                              wxCoord *widthText,
-                              wxCoord *heightText,
-                              wxCoord *hl)
-{
-    double widthTextMax = 0, widthLine;
-    double heightTextTotal = 0;
-    double heightLineDefault = 0, heightLine = 0;
+// Glyphs of an OS font rasterised once into coverage masks through a text drawing context.
+// Strings are then composited straight into the render buffer a glyph at a time so drawing
+// text needs neither a drawing context nor, once the glyphs are there, the main thread.
+// The kerning of each pair of characters drawn next to each other is measured alongside so
+// the glyphs are spaced as the context would space them, though each glyph lands on a
+// whole pixel where the context can place them part way between.
+class TextGlyphAtlas {
+public:
+    struct Glyph {
+        double advance = 0;
+        int x = 0; // top left of the mask relative to the pen position at the top of the line
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> mask;
+    };
+
+    // the atlas for the font, seeded with the printable ascii glyphs when it is created
+    static TextGlyphAtlas* GetAtlas(const std::string& fontString);
+    // the atlas for the font if something has already created it
+    static TextGlyphAtlas* FindAtlas(const std::string& fontString);
+
+    int GetLineHeight() const { return _lineHeight; }
+    bool HasGlyphs(const wxString& text);
+    // one entry per character of text, nullptr for the line breaks, and how far each one
+    // moves the pen including the kerning against the character after it
+    void GetGlyphs(const wxString& text, std::vector<const Glyph*>& glyphs, std::vector<double>& advances);
+
+    wxSize GetMultiLineTextExtent(const wxString& text);
+    // the lines centred in rect, colours are applied a character at a time
+    void DrawLabel(RenderBuffer& buffer, const wxString& text, const wxRect& rect, const std::vector<xlColor>& colors);
+    // the lines with their top left at x, y rotated anticlockwise about that point
+    void DrawText(RenderBuffer& buffer, const wxString& text, int x, int y, double rotation, const xlColor& color);
+
+private:
+    TextGlyphAtlas(const std::string& fontString) : _fontString(fontString), _lineHeight(0) {}
+    static bool CanRasterise();
+    static uint64_t PairKey(wxUniChar first, wxUniChar second) { return ((uint64_t)first.GetValue() << 32) | second.GetValue(); }
+    void Rasterise(const std::vector<wxUniChar>& chars, std::map<wxUniChar::value_type, Glyph>& glyphs,
+                   const std::vector<std::pair<wxUniChar, wxUniChar>>& pairs, std::map<uint64_t, double>& kerning);
+    static void DrawGlyph(RenderBuffer& buffer, const Glyph& glyph, int x, int y, const xlColor& color);
+    static void DrawGlyph(RenderBuffer& buffer, const Glyph& glyph, double u, double v, int x, int y, double sn, double cs, const xlColor& color);
+
+    std::string _fontString;
+    std::atomic_int _lineHeight;
+    std::mutex _lock;
+    std::map<wxUniChar::value_type, Glyph> _glyphs;
+    // adjustment to the first character's advance when followed by the second
+    std::map<uint64_t, double> _kerning;
+    // stands in for glyphs a thread that can't rasterise found missing
+    Glyph _missing;
+};
 
-    wxString curLine;
-    for ( wxString::const_iterator pc = text.begin(); ; ++pc )
+static std::mutex GLYPH_ATLAS_LOCK;
+static std::map<std::string, std::unique_ptr<TextGlyphAtlas>> GLYPH_ATLASES;
+
+TextGlyphAtlas* TextGlyphAtlas::GetAtlas(const std::string& fontString)
+{
+    TextGlyphAtlas* atlas = nullptr;
+    bool created = false;
     {
-        if ( pc == text.end() || *pc == wxS('\n') )
-        {
-            if ( curLine.empty() )
-            {
-                // we can't use GetTextExtent - it will return 0 for both width
-                // and height and an empty line should count in height
-                // calculation
+        std::unique_lock<std::mutex> locker(GLYPH_ATLAS_LOCK);
+        auto& it = GLYPH_ATLASES[fontString];
+        if (it == nullptr) {
+            it.reset(new TextGlyphAtlas(fontString));
+            created = true;
+        }
+        atlas = it.get();
+    }
+    if (created || atlas->GetLineHeight() == 0) {
+        wxString ascii;
+        for (int c = 32; c < 127; c++) {
+            ascii += wxUniChar(c);
+        }
+        std::vector<const Glyph*> glyphs;
+        std::vector<double> advances;
+        atlas->GetGlyphs(ascii, glyphs, advances);
+    }
+    return atlas;
+}
 
-                // assume that this line has the same height as the previous
-                // one
-                if ( !heightLineDefault )
-                    heightLineDefault = heightLine;
+TextGlyphAtlas* TextGlyphAtlas::FindAtlas(const std::string& fontString)
+{
+    std::unique_lock<std::mutex> locker(GLYPH_ATLAS_LOCK);
+    auto it = GLYPH_ATLASES.find(fontString);
+    return it == GLYPH_ATLASES.end() ? nullptr : it->second.get();
+}
 
-                if ( !heightLineDefault )
-                {
-                    // but we don't know it yet - choose something reasonable
-                    double dummy;
-                    dc->GetTextExtent(wxS("W"), &dummy, &heightLineDefault);
-                }
+bool TextGlyphAtlas::CanRasterise()
+{
+#ifdef LINUX
+    // Linux text drawing contexts only work on the main thread
+    return wxThread::IsMain();
+#else
+    return true;
+#endif
+}
 
-                heightTextTotal += heightLineDefault;
+bool TextGlyphAtlas::HasGlyphs(const wxString& text)
+{
+    if (_lineHeight == 0) {
+        return false;
+    }
+    std::unique_lock<std::mutex> locker(_lock);
+    wxUniChar last = '\n';
+    for (auto it = text.begin(); it != text.end(); ++it) {
+        if (*it != '\n') {
+            if (_glyphs.find((*it).GetValue()) == _glyphs.end()) {
+                return false;
             }
-            else
-            {
-                dc->GetTextExtent(curLine, &widthLine, &heightLine);
-                if ( widthLine > widthTextMax )
-                    widthTextMax = widthLine;
-                heightTextTotal += heightLine;
+            if (last != '\n' && _kerning.find(PairKey(last, *it)) == _kerning.end()) {
+                return false;
             }
+        }
+        last = *it;
+    }
+    return true;
+}
 
-            if ( pc == text.end() )
-            {
-                break;
+void TextGlyphAtlas::GetGlyphs(const wxString& text, std::vector<const Glyph*>& glyphs, std::vector<double>& advances)
+{
+    std::vector<wxUniChar> chars(text.begin(), text.end());
+    glyphs.assign(chars.size(), nullptr);
+    advances.assign(chars.size(), 0.0);
+    std::vector<wxUniChar> missing;
+    std::vector<std::pair<wxUniChar, wxUniChar>> missingPairs;
+    {
+        std::unique_lock<std::mutex> locker(_lock);
+        for (size_t i = 0; i < chars.size(); i++) {
+            wxUniChar c = chars[i];
+            if (c == '\n') {
+                continue;
             }
-            else // '\n'
-            {
-                curLine.clear();
+            auto g = _glyphs.find(c.GetValue());
+            if (g != _glyphs.end()) {
+                glyphs[i] = &g->second;
+            } else if (std::find(missing.begin(), missing.end(), c) == missing.end()) {
+                missing.push_back(c);
+            }
+            if (i + 1 < chars.size() && chars[i + 1] != '\n' && _kerning.find(PairKey(c, chars[i + 1])) == _kerning.end()) {
+                auto pair = std::make_pair(c, chars[i + 1]);
+                if (std::find(missingPairs.begin(), missingPairs.end(), pair) == missingPairs.end()) {
+                    missingPairs.push_back(pair);
+                }
             }
-        }
-        else
-        {
-            curLine += *pc;
         }
     }
-    *widthText = widthTextMax;
-    *heightText = heightTextTotal;
-    *hl = heightLine;
-    return wxSize(widthTextMax, heightTextTotal);
-}
 
-class CachedTextInfo {
-public:
-    CachedTextInfo() {}
-    CachedTextInfo(const std::string &txt, const std::string font, const std::vector<xlColor> &c, const wxRect &r)
-    : text(txt), rect(r), color(c), fontString(font) {}
-    ~CachedTextInfo() {}
-    
-    bool operator==(const CachedTextInfo &i) const {
-        return (text == i.text)
-            && (fontString == i.fontString)
-            && (rect == i.rect)
-            && (color == i.color);
+    std::map<wxUniChar::value_type, Glyph> added;
+    std::map<uint64_t, double> addedKerning;
+    if ((!missing.empty() || !missingPairs.empty()) && CanRasterise()) {
+        // rasterised without holding the lock as getting a context may have to wait on the main thread
+        Rasterise(missing, added, missingPairs, addedKerning);
     }
-    
-    std::string text;
-    wxRect rect;
-    std::vector<xlColor> color;
-    std::string fontString;
-};
 
-struct CachedTextInfoHasher {
-    size_t operator()(const CachedTextInfo& t) const {
-        std::size_t h1 = std::hash<std::string>{}(t.text);
-        std::size_t h2 = std::hash<std::string>{}(t.fontString);
-        h1 ^= (h2 << 1);
-        for (auto a : t.color) {
-            h1 ^= a.GetRGB() << 3;
-        }
-        h1 ^= (t.rect.x << 8) + (t.rect.y << 16);
-        return h1;
+    std::unique_lock<std::mutex> locker(_lock);
+    for (auto& it : added) {
+        _glyphs.emplace(it.first, std::move(it.second));
     }
-};
-
-class TextRenderCache : public EffectRenderCache {
-public:
-    TextRenderCache() : timer_countdown(0), synced_textsize(wxSize(0,0)) {};
-    virtual ~TextRenderCache() {
-        for (auto it = textCache.begin(); it != textCache.end(); ++it) {
-            delete it->second;
+    _kerning.insert(addedKerning.begin(), addedKerning.end());
+    for (size_t i = 0; i < chars.size(); i++) {
+        if (chars[i] == '\n') {
+            continue;
         }
-    };
-    int timer_countdown;
-    wxSize synced_textsize;
-    
-    wxImage *GetImage(const CachedTextInfo &inf) {
-        return textCache[inf];
-    }
-    void PutImage(const CachedTextInfo &inf, wxImage *img) {
-        textCache[inf] = img;
-    }
-    
-    wxSize GetMultiLineTextExtent(const std::string &font, const wxString &msg) {
-        std::pair<std::string, wxString> key(font, msg);
-        auto i = textExtentCache.find(key);
-        if (i == textExtentCache.end()) {
-            return wxSize(-1, -1);
+        if (glyphs[i] == nullptr) {
+            auto g = _glyphs.find(chars[i].GetValue());
+            glyphs[i] = g == _glyphs.end() ? &_missing : &g->second;
         }
-        return i->second;
-    }
-    void PutMultiLineTextExtent(const std::string &font, const wxString &msg, const wxSize &sz) {
-        std::pair<std::string, wxString> key(font, msg);
-        textExtentCache[key] = sz;
-    }
-    
-    std::unordered_map<CachedTextInfo, wxImage*, CachedTextInfoHasher> textCache;
-    std::map<std::pair<std::string, wxString>, wxSize> textExtentCache;
-};
-
-wxSize GetMultiLineTextExtent(TextDrawingContext *dc,
-                              const wxString& text,
-                              TextRenderCache *cache,
-                              const std::string &font,
-                              bool &fontSet)
-{
-    wxSize i = cache->GetMultiLineTextExtent(font, text);
-    if (i.x == -1 && i.y == -1) {
-        if (!fontSet) {
-            dc->Clear();
-            SetFont(dc, font, xlWHITE);
-            fontSet = true;
+        advances[i] = glyphs[i]->advance;
+        if (i + 1 < chars.size() && chars[i + 1] != '\n') {
+            // pairs a thread that can't rasterise found missing are left unkerned
+            auto k = _kerning.find(PairKey(chars[i], chars[i + 1]));
+            if (k != _kerning.end()) {
+                advances[i] += k->second;
+            }
         }
-        wxCoord x,y,z;
-        i = GetMultiLineTextExtent(dc, text, &x, &y, &z);
-        cache->PutMultiLineTextExtent(font, text, i);
     }
-    return i;
 }
 
-void DrawLabel(TextDrawingContext *dc,
-               const wxString& text,
-               const wxRect& rect,
-               int alignment,
-               TextRenderCache *cache,
-               const std::string &fontString,
-               const std::vector<xlColor> colors)
+void TextGlyphAtlas::Rasterise(const std::vector<wxUniChar>& chars, std::map<wxUniChar::value_type, Glyph>& glyphs,
+                               const std::vector<std::pair<wxUniChar, wxUniChar>>& pairs, std::map<uint64_t, double>& kerning)
 {
-    // find the text position
-    wxCoord widthText, heightText, heightLine;
-    GetMultiLineTextExtent(dc, text, &widthText, &heightText, &heightLine);
-
-    wxCoord width = widthText;
-    wxCoord height = heightText;
-
-    wxCoord x, y;
-    if ( alignment & wxALIGN_RIGHT )
-    {
-        x = rect.GetRight() - width;
-    }
-    else if ( alignment & wxALIGN_CENTRE_HORIZONTAL )
-    {
-        x = (rect.GetLeft() + rect.GetRight() + 1 - width) / 2;
-    }
-    else // alignment & wxALIGN_LEFT
-    {
-        x = rect.GetLeft();
+    TextDrawingContext* dc = TextDrawingContext::GetContext();
+    if (dc == nullptr) {
+        return;
     }
 
-    if ( alignment & wxALIGN_BOTTOM )
-    {
-        y = rect.GetBottom() - height;
-    }
-    else if ( alignment & wxALIGN_CENTRE_VERTICAL )
-    {
-        y = (rect.GetTop() + rect.GetBottom() + 1 - height) / 2;
+    dc->Clear();
+    SetFont(dc, _fontString, xlWHITE);
+    double w, h;
+    dc->GetTextExtent("X", &w, &h);
+    int lineHeight = h;
+    std::vector<double> advances(chars.size());
+    double maxAdvance = 0;
+    for (size_t i = 0; i < chars.size(); i++) {
+        dc->GetTextExtent(wxString(chars[i]), &w, &h);
+        advances[i] = w;
+        maxAdvance = std::max(maxAdvance, w);
     }
-    else // alignment & wxALIGN_TOP
-    {
-        y = rect.GetTop();
+    for (const auto& it : pairs) {
+        double w1, w2;
+        dc->GetTextExtent(wxString(it.first), &w1, &h);
+        dc->GetTextExtent(wxString(it.second), &w2, &h);
+        dc->GetTextExtent(wxString(it.first) + wxString(it.second), &w, &h);
+        kerning[PairKey(it.first, it.second)] = w - w1 - w2;
     }
 
-    // split the string into lines and draw each of them separately
-    //
-    // NB: while wxDC::DrawText() on some platforms supports drawing multi-line
-    //     strings natively, this is not the case for all of them, notably not
-    //     wxMSW which uses this function for multi-line texts, so we may only
-    //     call DrawText() for single-line strings from here to avoid infinite
-    //     recursion.
-    wxString curLine;
-    int curPos = 0;
-    for ( wxString::const_iterator pc = text.begin(); ; ++pc )
-    {
-        if ( pc == text.end() || *pc == '\n' ) {
-            int xRealStart = x; // init it here to avoid compielr warnings
-            if ( !curLine.empty() )
-            {
-                // NB: can't test for !(alignment & wxALIGN_LEFT) because
-                //     wxALIGN_LEFT is 0
-                if ( alignment & (wxALIGN_RIGHT | wxALIGN_CENTRE_HORIZONTAL) )
-                {
-                    wxCoord x1,y1,z1;
-                    wxCoord widthLine = GetMultiLineTextExtent(dc, curLine, &x1, &y1, &z1).x;
+    // room around the pen position for glyphs that overhang their advance
+    int pad = std::max(lineHeight / 2, 2);
+    int cellWi = (int)maxAdvance + 2 * pad + 1;
+    int cellHt = lineHeight + 2 * pad;
+    dc->ResetSize(cellWi, cellHt);
+
+    for (size_t i = 0; i < chars.size(); i++) {
+        Glyph& g = glyphs[chars[i].GetValue()];
+        g.advance = advances[i];
+        if (wxIsspace(chars[i])) {
+            continue;
+        }
 
-                    if ( alignment & wxALIGN_RIGHT )
-                    {
-                        xRealStart += width - widthLine;
-                    }
-                    else // if ( alignment & wxALIGN_CENTRE_HORIZONTAL )
-                    {
-                        xRealStart += (width - widthLine) / 2;
-                    }
+        dc->Clear();
+        SetFont(dc, _fontString, xlWHITE);
+        dc->DrawText(wxString(chars[i]), pad, pad);
+        wxImage* img = dc->FlushAndGetImage();
+        int iw = img->GetWidth();
+        int ih = img->GetHeight();
+        const unsigned char* data = img->GetData();
+        const unsigned char* alpha = img->HasAlpha() ? img->GetAlpha() : nullptr;
+
+        // without an alpha channel anything that isn't black was drawn
+        std::vector<uint8_t> coverage(iw * ih);
+        int minx = iw, miny = ih, maxx = -1, maxy = -1;
+        for (int y = 0; y < ih; y++) {
+            for (int x = 0; x < iw; x++) {
+                int idx = y * iw + x;
+                uint8_t cv = 0;
+                if (alpha != nullptr) {
+                    cv = alpha[idx];
+                } else if (data[idx * 3] != 0 || data[idx * 3 + 1] != 0 || data[idx * 3 + 2] != 0) {
+                    cv = 255;
                 }
-                //else: left aligned, nothing to do
-                if (colors.size() != 1) {
-                    wxArrayDouble d;
-                    dc->GetTextExtents(curLine, d);
-                    for (int x1 = 0; x1 < curLine.size(); x1++) {
-                        wxString c = curLine[x1];
-                        if (c != " ") {
-                            SetFont(dc, fontString, colors[curPos % colors.size()]);
-                            curPos++;
-                            double loc = xRealStart;
-                            if (x1 != 0) {
-                                loc += d[x1 - 1];
-                            }
-                            dc->DrawText(c, loc, y);
-                        }
-                    }
-                } else {
-                    dc->DrawText(curLine, xRealStart, y);
+                if (cv != 0) {
+                    coverage[idx] = cv;
+                    minx = std::min(minx, x);
+                    maxx = std::max(maxx, x);
+                    miny = std::min(miny, y);
+                    maxy = std::max(maxy, y);
                 }
             }
+        }
+        if (maxx < 0) {
+            continue;
+        }
+
+        g.x = minx - pad;
+        g.y = miny - pad;
+        g.width = maxx - minx + 1;
+        g.height = maxy - miny + 1;
+        g.mask.resize(g.width * g.height);
+        for (int y = 0; y < g.height; y++) {
+            memcpy(&g.mask[y * g.width], &coverage[(y + miny) * iw + minx], g.width);
+        }
+    }
+    TextDrawingContext::ReleaseContext(dc);
 
-            y += heightLine;
+    if (_lineHeight == 0) {
+        _lineHeight = lineHeight;
+    }
+}
 
-            if ( pc == text.end() )
-                break;
+wxSize TextGlyphAtlas::GetMultiLineTextExtent(const wxString& text)
+{
+    std::vector<const Glyph*> glyphs;
+    std::vector<double> advances;
+    GetGlyphs(text, glyphs, advances);
+
+    double widthTextMax = 0;
+    double widthLine = 0;
+    int lines = 1;
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        if (glyphs[i] == nullptr) {
+            widthTextMax = std::max(widthTextMax, widthLine);
+            widthLine = 0;
+            lines++;
+        } else {
+            widthLine += advances[i];
+        }
+    }
+    widthTextMax = std::max(widthTextMax, widthLine);
+    return wxSize(widthTextMax, lines * _lineHeight);
+}
 
-            curLine.clear();
+void TextGlyphAtlas::DrawLabel(RenderBuffer& buffer, const wxString& text, const wxRect& rect, const std::vector<xlColor>& colors)
+{
+    std::vector<const Glyph*> glyphs;
+    std::vector<double> advances;
+    GetGlyphs(text, glyphs, advances);
+
+    std::vector<int> widths(1, 0);
+    double widthLine = 0;
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        if (glyphs[i] == nullptr) {
+            widths.back() = widthLine;
+            widths.push_back(0);
+            widthLine = 0;
+        } else {
+            widthLine += advances[i];
         }
-        else // not end of line
-        {
-            curLine += *pc;
+    }
+    widths.back() = widthLine;
+
+    int lineHeight = _lineHeight;
+    int width = *std::max_element(widths.begin(), widths.end());
+    int height = widths.size() * lineHeight;
+    int x = (rect.GetLeft() + rect.GetRight() + 1 - width) / 2;
+    int y = (rect.GetTop() + rect.GetBottom() + 1 - height) / 2;
+
+    size_t line = 0;
+    int xRealStart = x + (width - widths[line]) / 2;
+    double pen = 0;
+    int curPos = 0;
+    size_t i = 0;
+    for (auto it = text.begin(); it != text.end(); ++it, ++i) {
+        const Glyph* g = glyphs[i];
+        if (g == nullptr) {
+            y += lineHeight;
+            xRealStart = x + (width - widths[++line]) / 2;
+            pen = 0;
+            continue;
+        }
+        if (*it != ' ') {
+            DrawGlyph(buffer, *g, xRealStart + (int)std::round(pen), y, colors[curPos % colors.size()]);
+            curPos++;
         }
+        pen += advances[i];
     }
 }
 
+void TextGlyphAtlas::DrawText(RenderBuffer& buffer, const wxString& text, int x, int y, double rotation, const xlColor& color)
+{
+    std::vector<const Glyph*> glyphs;
+    std::vector<double> advances;
+    GetGlyphs(text, glyphs, advances);
+
+    double sn = std::sin(wxDegToRad(rotation));
+    double cs = std::cos(wxDegToRad(rotation));
+    double u = 0;
+    double v = 0;
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        const Glyph* g = glyphs[i];
+        if (g == nullptr) {
+            u = 0;
+            v += _lineHeight;
+        } else {
+            if (rotation == 0.0) {
+                DrawGlyph(buffer, *g, x + (int)std::round(u), y + (int)v, color);
+            } else {
+                DrawGlyph(buffer, *g, u, v, x, y, sn, cs, color);
+            }
+            u += advances[i];
+        }
+    }
+}
 
+// x, y are in drawing context coordinates which run down the buffer
+void TextGlyphAtlas::DrawGlyph(RenderBuffer& buffer, const Glyph& glyph, int x, int y, const xlColor& color)
+{
+    xlColor c = color;
+    for (int gy = 0; gy < glyph.height; gy++) {
+        int by = y + glyph.y + gy;
+        if (by < 0 || by >= buffer.BufferHt) {
+            continue;
+        }
+        const uint8_t* mask = &glyph.mask[gy * glyph.width];
+        for (int gx = 0; gx < glyph.width; gx++) {
+            int bx = x + glyph.x + gx;
+            if (mask[gx] != 0 && bx >= 0 && bx < buffer.BufferWi) {
+                c.alpha = mask[gx];
+                buffer.SetPixel(bx, buffer.BufferHt - 1 - by, c);
+            }
+        }
+    }
+}
 
+// u, v is the pen position along and down the text which is rotated about x, y, the
+// buffer pixels the rotated mask covers are mapped back into it so there are no gaps
+void TextGlyphAtlas::DrawGlyph(RenderBuffer& buffer, const Glyph& glyph, double u, double v, int x, int y, double sn, double cs, const xlColor& color)
+{
+    double l = u + glyph.x;
+    double t = v + glyph.y;
+    double minx = buffer.BufferWi, miny = buffer.BufferHt, maxx = 0, maxy = 0;
+    for (double cu : { l, l + glyph.width }) {
+        for (double cv : { t, t + glyph.height }) {
+            double px = x + cu * cs + cv * sn;
+            double py = y - cu * sn + cv * cs;
+            minx = std::min(minx, px);
+            maxx = std::max(maxx, px);
+            miny = std::min(miny, py);
+            maxy = std::max(maxy, py);
+        }
+    }
+    int sx = std::max(0, (int)std::floor(minx));
+    int ex = std::min(buffer.BufferWi - 1, (int)std::ceil(maxx));
+    int sy = std::max(0, (int)std::floor(miny));
+    int ey = std::min(buffer.BufferHt - 1, (int)std::ceil(maxy));
+
+    xlColor c = color;
+    for (int by = sy; by <= ey; by++) {
+        double dy = by + 0.5 - y;
+        for (int bx = sx; bx <= ex; bx++) {
+            double dx = bx + 0.5 - x;
+            int mx = std::floor(dx * cs - dy * sn - l);
+            int my = std::floor(dx * sn + dy * cs - t);
+            if (mx < 0 || my < 0 || mx >= glyph.width || my >= glyph.height) {
+                continue;
+            }
+            uint8_t cv = glyph.mask[my * glyph.width + mx];
+            if (cv != 0) {
+                c.alpha = cv;
+                buffer.SetPixel(bx, buffer.BufferHt - 1 - by, c);
+            }
+        }
+    }
+}
 
+class TextRenderCache : public EffectRenderCache {
+public:
+    TextRenderCache() : timer_countdown(0), synced_textsize(wxSize(0,0)) {};
+    virtual ~TextRenderCache() {};
+    int timer_countdown;
+    wxSize synced_textsize;
+};
 
 // dir is 0: move left, 1: move right, 2: up, 3: down, 4: no movement
 // Effect is 0: normal, 1: vertical text down, 2: vertical text up,
@@ -886,6 +1032,26 @@ static wxString StripRight(wxString str, wxString pattern)
     return str;
 }
 
+bool TextEffect::CanRenderOnBackgroundThread(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer)
+{
+#ifdef LINUX
+    // glyphs and kerning pairs the atlas doesn't have yet need a text drawing context which only works
+    // on the main thread, text from files, lyric tracks and countdowns isn't known up front so always goes there
+    if (settings.Get("CHOICE_Text_Font", "Use OS Fonts") != "Use OS Fonts"
+        || TextCountDownIndex(settings["CHOICE_Text_Count"]) != COUNTDOWN_NONE) {
+        return false;
+    }
+    wxString text = settings["TEXTCTRL_Text"];
+    if (text == "") {
+        return false;
+    }
+    TextGlyphAtlas *atlas = TextGlyphAtlas::FindAtlas(settings["FONTPICKER_Text_Font"]);
+    return atlas != nullptr && atlas->HasGlyphs(text);
+#else
+    return true;
+#endif
+}
+
 TextRenderCache *GetCache(RenderBuffer &buffer, int id) {
     TextRenderCache *cache = (TextRenderCache*)buffer.infoCache[id];
     if (cache == nullptr) {
@@ -896,20 +1062,19 @@ TextRenderCache *GetCache(RenderBuffer &buffer, int id) {
 }
 
 //jwylie - 2016-11-01  -- enhancement: add minute seconds countdown
-wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
-                                    TextDrawingContext* dc,
-                                    const wxString& Line_orig,
-                                    const std::string &fontString,
-                                    int dir,
-                                    bool center, int Effect, int Countdown, int tspeed,
-                                    int startx, int starty, int endx, int endy,
-                                    bool isPixelBased) const
+void TextEffect::RenderTextLine(RenderBuffer &buffer,
+                                const wxString& Line_orig,
+                                const std::string &fontString,
+                                int dir,
+                                bool center, int Effect, int Countdown, int tspeed,
+                                int startx, int starty, int endx, int endy,
+                                bool isPixelBased) const
 {
     int i;
     wxString Line = Line_orig;
     wxString msg, tempmsg;
 
-    if (Line.IsEmpty()) return nullptr;
+    if (Line.IsEmpty()) return;
 
     int state = (buffer.curPeriod - buffer.curEffStartPer) * tspeed * buffer.frameTimeInMs / 50;
 
@@ -939,16 +1104,15 @@ wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
         default: break;
     }
     
-    TextRenderCache *cache = GetCache(buffer, id);
-    bool fontSet = false;
-    
-    wxSize textsize = GetMultiLineTextExtent(dc, msg, cache, fontString, fontSet);
-    int extra_left = IsGoingLeft(dir)? textsize.x - GetMultiLineTextExtent(dc, wxString(msg).Trim(false), cache, fontString, fontSet).x: 0; //CAUTION: trim() alters object, so make a copy first
-    int extra_right = IsGoingRight(dir)? textsize.x - GetMultiLineTextExtent(dc, wxString(msg).Trim(true), cache, fontString, fontSet).x: 0;
-    int extra_down = IsGoingDown(dir)? textsize.y - GetMultiLineTextExtent(dc, StripRight(msg, "\n"), cache, fontString, fontSet).y: 0;
-    int extra_up = IsGoingUp(dir)? textsize.y - GetMultiLineTextExtent(dc, StripLeft(msg, "\n"), cache, fontString, fontSet).y: 0;
+    TextGlyphAtlas *atlas = TextGlyphAtlas::GetAtlas(fontString);
+
+    wxSize textsize = atlas->GetMultiLineTextExtent(msg);
+    int extra_left = IsGoingLeft(dir)? textsize.x - atlas->GetMultiLineTextExtent(wxString(msg).Trim(false)).x: 0; //CAUTION: trim() alters object, so make a copy first
+    int extra_right = IsGoingRight(dir)? textsize.x - atlas->GetMultiLineTextExtent(wxString(msg).Trim(true)).x: 0;
+    int extra_down = IsGoingDown(dir)? textsize.y - atlas->GetMultiLineTextExtent(StripRight(msg, "\n")).y: 0;
+    int extra_up = IsGoingUp(dir)? textsize.y - atlas->GetMultiLineTextExtent(StripLeft(msg, "\n")).y: 0;
     //    debug(1, "size %d lstrip %d, rstrip %d, = %d, %d, text %s", dc.GetMultiLineTextExtent(msg).y, dc.GetMultiLineTextExtent(StripLeft(msg, "\n")).y, dc.GetMultiLineTextExtent(StripRight(msg, "\n")).y, extra_down, extra_up, (const char*)StripLeft(msg, "\n"));
-    int lineh = GetMultiLineTextExtent(dc, "X", cache, fontString, fontSet).y;
+    int lineh = atlas->GetLineHeight();
     //    wxString debmsg = msg; debmsg.Replace("\n","\\n", true);
     int xoffset=0;
     int yoffset=0;
@@ -1071,24 +1235,15 @@ wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
         if (colors.size() == 0) {
             colors.push_back(xlWHITE);
         }
-        CachedTextInfo inf(msg.ToStdString(), fontString, colors, rect);
-        wxImage *img = GetCache(buffer,id)->GetImage(inf);
-        if (img == nullptr) {
-            dc->Clear();
-            SetFont(dc, fontString, colors[0]);
-            DrawLabel(dc, msg, rect, wxALIGN_CENTER_HORIZONTAL|wxALIGN_CENTER_VERTICAL, GetCache(buffer,id), fontString, colors);
-            wxImage *i2 = dc->FlushAndGetImage();
-            img = new wxImage(i2->GetSize());
-            *img = i2->Copy();
-            GetCache(buffer,id)->PutImage(inf, img);
-        }
-        return img;
+        // the text replaces the whole buffer like the drawn image used to
+        buffer.Clear();
+        atlas->DrawLabel(buffer, msg, rect, colors);
+        return;
     }
-    
+
     xlColor c;
     buffer.palette.GetColor(0,c);
-    dc->Clear();
-    SetFont(dc,fontString,c);
+    buffer.Clear();
     switch (dir) {
         case TEXTDIR_VECTOR: {
             double position = buffer.GetEffectTimeIntervalPosition(1.0);
@@ -1101,45 +1256,44 @@ wxImage *TextEffect::RenderTextLine(RenderBuffer &buffer,
             ex = OffsetLeft + (ex - OffsetLeft) * position;
             ey = OffsetTop + (ey - OffsetTop) * position;
             if (TextRotation > 50) {
-                dc->DrawText(msg, buffer.BufferWi / 2 + ex - txtwidth / 2, buffer.BufferHt / 2 + ey + textsize.GetHeight() / 2, TextRotation);
+                atlas->DrawText(buffer, msg, buffer.BufferWi / 2 + ex - txtwidth / 2, buffer.BufferHt / 2 + ey + textsize.GetHeight() / 2, TextRotation, c);
             } else if (TextRotation > 0) {
-                dc->DrawText(msg, buffer.BufferWi / 2 + ex - txtwidth / 2, buffer.BufferHt / 2 + ey + yoffset * 2, TextRotation);
+                atlas->DrawText(buffer, msg, buffer.BufferWi / 2 + ex - txtwidth / 2, buffer.BufferHt / 2 + ey + yoffset * 2, TextRotation, c);
             } else if (TextRotation < -50) {
-                dc->DrawText(msg, buffer.BufferWi / 2 + ex + txtwidth / 2, buffer.BufferHt / 2 + ey - textsize.GetHeight() / 2, TextRotation);
+                atlas->DrawText(buffer, msg, buffer.BufferWi / 2 + ex + txtwidth / 2, buffer.BufferHt / 2 + ey - textsize.GetHeight() / 2, TextRotation, c);
             } else {
-                dc->DrawText(msg, buffer.BufferWi / 2 + ex - txtwidth / 2 + xoffset, buffer.BufferHt / 2 + ey - textsize.GetHeight() / 2, TextRotation);
+                atlas->DrawText(buffer, msg, buffer.BufferWi / 2 + ex - txtwidth / 2 + xoffset, buffer.BufferHt / 2 + ey - textsize.GetHeight() / 2, TextRotation, c);
             }
         }
             break;
         case TEXTDIR_LEFT:
-            dc->DrawText(msg, buffer.BufferWi - state % xlimit/8 + xoffset, OffsetTop, TextRotation);
+            atlas->DrawText(buffer, msg, buffer.BufferWi - state % xlimit/8 + xoffset, OffsetTop, TextRotation, c);
             break; // left
         case TEXTDIR_RIGHT:
-            dc->DrawText(msg, state % xlimit/8 - txtwidth + xoffset, OffsetTop, TextRotation);
+            atlas->DrawText(buffer, msg, state % xlimit/8 - txtwidth + xoffset, OffsetTop, TextRotation, c);
             break; // right
         case TEXTDIR_UP:
-            dc->DrawText(msg, OffsetLeft, totheight - state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, OffsetLeft, totheight - state % ylimit/8 - yoffset, TextRotation, c);
             break; // up
         case TEXTDIR_DOWN:
-            dc->DrawText(msg, OffsetLeft, state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, OffsetLeft, state % ylimit/8 - yoffset, TextRotation, c);
             break; // down
         case TEXTDIR_UPLEFT:
-            dc->DrawText(msg, buffer.BufferWi - state % xlimit/8 + xoffset, totheight - state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, buffer.BufferWi - state % xlimit/8 + xoffset, totheight - state % ylimit/8 - yoffset, TextRotation, c);
             break; // up-left
         case TEXTDIR_DOWNLEFT:
-            dc->DrawText(msg, buffer.BufferWi - state % xlimit/8 + xoffset, state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, buffer.BufferWi - state % xlimit/8 + xoffset, state % ylimit/8 - yoffset, TextRotation, c);
             break; // down-left
         case TEXTDIR_UPRIGHT:
-            dc->DrawText(msg, state % xlimit/8 - txtwidth + xoffset, totheight - state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, state % xlimit/8 - txtwidth + xoffset, totheight - state % ylimit/8 - yoffset, TextRotation, c);
             break; // up-right
         case TEXTDIR_DOWNRIGHT:
-            dc->DrawText(msg, state % xlimit/8 - txtwidth + xoffset, state % ylimit/8 - yoffset, TextRotation);
+            atlas->DrawText(buffer, msg, state % xlimit/8 - txtwidth + xoffset, state % ylimit/8 - yoffset, TextRotation, c);
             break; // down-right
         default:
-            dc->DrawText(msg, 0, OffsetTop, TextRotation);
+            atlas->DrawText(buffer, msg, 0, OffsetTop, TextRotation, c);
             break; // static
     }
-    return buffer.GetTextDrawingContext()->FlushAndGetImage();
 }
 
 void TextEffect::FormatCountdown(int Countdown, int state, wxString& Line, RenderBuffer &buffer, wxString& msg, wxString Line_orig) const
@@ -4,9 +4,7 @@
 #include "RenderableEffect.h"
 
 class wxString;
-class TextDrawingContext;
 class FontManager;
-class wxImage;
 
 class TextEffect : public RenderableEffect
 {
@@ -16,9 +14,7 @@ class TextEffect : public RenderableEffect
         virtual void SetDefaultParameters() override;
         virtual void Render(Effect *effect, SettingsMap &settings, RenderBuffer &buffer) override;
         virtual void SetPanelStatus(Model* cls) override;
-#ifdef LINUX
-        virtual bool CanRenderOnBackgroundThread(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) override {return false;};
-#endif
+        virtual bool CanRenderOnBackgroundThread(Effect *effect, const SettingsMap &settings, RenderBuffer &buffer) override;
         virtual bool CanBeRandom() override {return false;}
         virtual bool SupportsRenderCache(const SettingsMap& settings) const override { return true; }
 
@@ -35,8 +31,7 @@ class TextEffect : public RenderableEffect
         void SelectTextColor(std::string& palette, int index) const;
         void FormatCountdown(int Countdown, int state, wxString& Line, RenderBuffer &buffer, wxString& msg, wxString Line_orig) const;
 
-        wxImage *RenderTextLine(RenderBuffer &buffer,
-                            TextDrawingContext* dc,
+        void RenderTextLine(RenderBuffer &buffer,
                             const wxString& Line_orig,
                             const std::string &fontString,
                             int dir,
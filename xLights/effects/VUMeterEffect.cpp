@@ -783,21 +783,21 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
     
     int truexoffset = xoffset * buffer.BufferWi / 100;
     int trueyoffset = yoffset * buffer.BufferHt / 100;
-	std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+	FrameDataView pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
     while (lineHistory.size() > sensitivity / 10)
     {
         lineHistory.pop_front();
     }
 
-	if (pdata != nullptr && pdata->size() != 0)
+	if (!pdata.empty())
 	{
         if (peak)
         {
             if (lastvalues.size() == 0)
             {
-                lastvalues = *pdata;
-                lastpeaks = *pdata;
+                lastvalues.assign(pdata.begin(), pdata.end());
+                lastpeaks.assign(pdata.begin(), pdata.end());
                 for (auto it = lastvalues.begin(); it != lastvalues.end(); ++it)
                 {
                     pauseuntilpeakfall.push_back(0);
@@ -805,7 +805,7 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
             }
             else
             {
-                std::list<float>::iterator newdata = pdata->begin();
+                const float* newdata = pdata.begin();
                 std::list<float>::iterator olddata = lastpeaks.begin();
                 auto pause = pauseuntilpeakfall.begin();
 
@@ -840,11 +840,11 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		{
 			if (lastvalues.size() == 0)
 			{
-				lastvalues = *pdata;
+				lastvalues.assign(pdata.begin(), pdata.end());
 			}
 			else
 			{
-				std::list<float>::iterator newdata = pdata->begin();
+				const float* newdata = pdata.begin();
 				std::list<float>::iterator olddata = lastvalues.begin();
 
 				while (olddata != lastvalues.end())
@@ -869,10 +869,10 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		}
 		else
 		{
-			lastvalues = *pdata;
+			lastvalues.assign(pdata.begin(), pdata.end());
 		}
 
-        int datapoints = std::min((int)pdata->size(), endNote - startNote + 1);
+        int datapoints = std::min((int)pdata.size(), endNote - startNote + 1);
 
 		if (usebars > datapoints)
 		{
@@ -1088,10 +1088,10 @@ void VUMeterEffect::RenderVolumeBarsFrame(RenderBuffer &buffer, int usebars, int
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			FrameDataView pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (!pf.empty())
 			{
-				f = ApplyGain(*pf->begin(), gain);
+				f = ApplyGain(pf.front(), gain);
 			}
 			for (int j = 0; j < cols; j++)
 			{
@@ -1172,16 +1172,16 @@ void VUMeterEffect::RenderWaveformFrame(RenderBuffer &buffer, int usebars, int y
             if (start + i >= 0)
             {
                 float fh = 0.0;
-                std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-                if (pf != nullptr)
+                FrameDataView pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+                if (!pf.empty())
                 {
-                    fh = ApplyGain(*pf->begin(), gain);
+                    fh = ApplyGain(pf.front(), gain);
                 }
                 float fl = 0.0;
                 pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_LOW, "");
-                if (pf != nullptr)
+                if (!pf.empty())
                 {
-                    fl = ApplyGain(*pf->begin(), gain);
+                    fl = ApplyGain(pf.front(), gain);
                 }
                 int s = (1.0 - fl) * buffer.BufferHt / 2;
                 int e = (1.0 + fh) * buffer.BufferHt / 2;
@@ -1406,10 +1406,10 @@ void VUMeterEffect::RenderOnFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
    
     float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->begin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 	xlColor color1;
 	buffer.palette.GetColor(0, color1);
@@ -1429,10 +1429,10 @@ void VUMeterEffect::RenderOnColourFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     xlColor color1;
@@ -1522,10 +1522,10 @@ void VUMeterEffect::RenderIntensityWaveFrame(RenderBuffer &buffer, int usebars,
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float>* pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			FrameDataView pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (!pf.empty())
 			{
-				f = ApplyGain(*pf->begin(), gain);
+				f = ApplyGain(pf.front(), gain);
 			}
 			xlColor color1;
 			if (buffer.palette.Size() < 2)
@@ -1558,10 +1558,10 @@ void VUMeterEffect::RenderLevelPulseFrame(RenderBuffer &buffer, int fadeframes,
     if (buffer.GetMedia() == nullptr) return;
     
     float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->begin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	if (f > (float)sensitivity / 100.0)
@@ -1599,10 +1599,10 @@ void VUMeterEffect::RenderLevelPulseColourFrame(RenderBuffer &buffer, int fadefr
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1649,10 +1649,10 @@ void VUMeterEffect::RenderLevelColourFrame(RenderBuffer &buffer, int& colourinde
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -2099,10 +2099,10 @@ void VUMeterEffect::RenderLevelShapeFrame(RenderBuffer& buffer, const std::strin
     float scaling = (float)scale / 100.0 * 7.0;
 
 	float f = 0.0;
-	std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->begin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	int centerx = (buffer.BufferWi / 2.0) + truexoffset;
@@ -2391,10 +2391,10 @@ void VUMeterEffect::RenderTimingEventJumpFrame(RenderBuffer &buffer, int fallfra
                 if (useAudioLevel)
                 {
                     float f = 0.0;
-                    std::list<float>* pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                    if (pf != nullptr)
+                    FrameDataView pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                    if (!pf.empty())
                     {
-                        f = ApplyGain(*pf->begin(), gain);
+                        f = ApplyGain(pf.front(), gain);
                     }
                     lastsize = f;
                 }
@@ -2598,13 +2598,13 @@ void VUMeterEffect::RenderNoteOnFrame(RenderBuffer& buffer, int startNote, int e
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    FrameDataView pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (auto it : *pdata)
+        for (auto it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2633,13 +2633,13 @@ void VUMeterEffect::RenderNoteLevelPulseFrame(RenderBuffer& buffer, int fadefram
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    FrameDataView pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (auto it : *pdata)
+        for (auto it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2685,11 +2685,11 @@ void VUMeterEffect::RenderLevelBarFrame(RenderBuffer &buffer, int bars, int sens
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    FrameDataView pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
-        float level = ApplyGain(pdata->front(), gain);
+        float level = ApplyGain(pdata.front(), gain);
 
         xlColor color1;
         if (level > (float)sensitivity / 100.0)
@@ -2818,13 +2818,13 @@ void VUMeterEffect::RenderNoteLevelBarFrame(RenderBuffer &buffer, int bars, int
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>* pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    FrameDataView pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (auto it : *pdata)
+        for (auto it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -206,7 +206,7 @@ public:
 		}
 	};
 
-    VideoReader* _videoreader;
+    SharedVideoReader* _videoreader;
 	int _videoframerate;
 	int _loops;
     int _frameMS;
@@ -262,7 +262,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
     }
 
     int &_loops = cache->_loops;
-    VideoReader* &_videoreader = cache->_videoreader;
+    SharedVideoReader* &_videoreader = cache->_videoreader;
     int& _frameMS = cache->_frameMS;
     int& _nextManualMS = cache->_nextManualMS;
 
@@ -300,7 +300,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
             // have to open the file
             int width = buffer.BufferWi * 100 / (cropRight - cropLeft);
             int height = buffer.BufferHt * 100 / (cropTop - cropBottom);
-            _videoreader = new VideoReader(filename, width, height, aspectratio);
+            _videoreader = new SharedVideoReader(filename, width, height, aspectratio);
 
             if (_videoreader == nullptr)
             {
@@ -326,12 +326,6 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
                     //fp->addVideoTime(filename, videolen);
                 }
 
-                if (starttime != 0)
-                {
-                    logger_base.debug("Video effect initialising ... seeking to start location for the video %f.", (float)starttime);
-                    _videoreader->Seek(starttime * 1000);
-                }
-
                 if (durationTreatment == "Slow/Accelerate")
                 {
                     int effectFrames = buffer.curEffEndPer - buffer.curEffStartPer + 1;
@@ -384,7 +378,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         }
 
         // get the image for the current frame
-        AVFrame* image = _videoreader->GetNextFrame(frame);
+        const uint8_t* image = _videoreader->GetNextFrame(frame);
 
         // if we have reached the end and we are to loop
         if (_videoreader->AtEnd() && durationTreatment == "Loop")
@@ -398,7 +392,6 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
             }
             logger_base.debug("Video effect loop #%d at frame %d to video frame %d.", _loops, buffer.curPeriod - buffer.curEffStartPer, frame);
 
-            _videoreader->Seek(0);
             image = _videoreader->GetNextFrame(frame);
         }
 
@@ -419,7 +412,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
             xlColor c;
             for (int y = 0; y < _videoreader->GetHeight() - yoffset - ytail; y++)
             {
-                uint8_t* ptr = image->data[0] + (_videoreader->GetHeight() - 1 - y - yoffset) * _videoreader->GetWidth() * 3 + xoffset * 3;
+                const uint8_t* ptr = image + (_videoreader->GetHeight() - 1 - y - yoffset) * _videoreader->GetWidth() * 3 + xoffset * 3;
 
                 for (int x = 0; x < _videoreader->GetWidth() - xoffset - xtail; x++)
                 {
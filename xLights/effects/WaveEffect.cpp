@@ -95,21 +95,48 @@ void WaveEffect::SetDefaultParameters() {
     wp->BitmapButton_Wave_YOffsetVC->SetActive(false);
 }
 
+class WaveParameters : public EffectParameters
+{
+public:
+    int WaveType;
+    int FillColor;
+    bool MirrorWave;
+    ValueCurveParameter NumberWaves;
+    ValueCurveParameter ThicknessWave;
+    ValueCurveParameter WaveHeight;
+    ValueCurveParameter wspeed;
+    ValueCurveParameter yoffset;
+    bool WaveDirection;
+
+    void Decode(SettingsMap &SettingsMap, RenderBuffer &buffer) {
+        WaveType = GetWaveType(SettingsMap["CHOICE_Wave_Type"]);
+        FillColor = GetWaveFillColor(SettingsMap["CHOICE_Fill_Colors"]);
+        MirrorWave = SettingsMap.GetBool("CHECKBOX_Mirror_Wave");
+        NumberWaves.DecodeInt("Number_Waves", 1, SettingsMap, WAVE_NUMBER_MIN, WAVE_NUMBER_MAX, buffer);
+        ThicknessWave.DecodeInt("Thickness_Percentage", 5, SettingsMap, WAVE_THICKNESS_MIN, WAVE_THICKNESS_MAX, buffer);
+        WaveHeight.DecodeInt("Wave_Height", 50, SettingsMap, WAVE_HEIGHT_MIN, WAVE_HEIGHT_MAX, buffer);
+        wspeed.DecodeInt("Wave_Speed", 10, SettingsMap, WAVE_SPEED_MIN, WAVE_SPEED_MAX, buffer);
+        yoffset.DecodeInt("Wave_YOffset", 0, SettingsMap, WAVE_YOFFSET_MIN, WAVE_YOFFSET_MAX, buffer);
+        WaveDirection = "Left to Right" == SettingsMap["CHOICE_Wave_Direction"] ? true : false;
+    }
+};
+
 void WaveEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &buffer) {
+    WaveParameters &params = GetParameters<WaveParameters>(effect, SettingsMap, buffer);
 
     float oset = buffer.GetEffectTimeIntervalPosition();
 
-    int WaveType = GetWaveType(SettingsMap["CHOICE_Wave_Type"]);
-    int FillColor = GetWaveFillColor(SettingsMap["CHOICE_Fill_Colors"]);
+    int WaveType = params.WaveType;
+    int FillColor = params.FillColor;
 
-    bool MirrorWave = SettingsMap.GetBool("CHECKBOX_Mirror_Wave");
-    int NumberWaves = GetValueCurveInt("Number_Waves", 1, SettingsMap, oset, WAVE_NUMBER_MIN, WAVE_NUMBER_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int ThicknessWave = GetValueCurveInt("Thickness_Percentage", 5, SettingsMap, oset, WAVE_THICKNESS_MIN, WAVE_THICKNESS_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int WaveHeight = GetValueCurveInt("Wave_Height", 50, SettingsMap, oset, WAVE_HEIGHT_MIN, WAVE_HEIGHT_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int wspeed = GetValueCurveInt("Wave_Speed", 10, SettingsMap, oset, WAVE_SPEED_MIN, WAVE_SPEED_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
-    int yoffset = GetValueCurveInt("Wave_YOffset", 0, SettingsMap, oset, WAVE_YOFFSET_MIN, WAVE_YOFFSET_MAX, buffer.GetStartTimeMS(), buffer.GetEndTimeMS());
+    bool MirrorWave = params.MirrorWave;
+    int NumberWaves = params.NumberWaves.GetInt(oset, buffer);
+    int ThicknessWave = params.ThicknessWave.GetInt(oset, buffer);
+    int WaveHeight = params.WaveHeight.GetInt(oset, buffer);
+    int wspeed = params.wspeed.GetInt(oset, buffer);
+    int yoffset = params.yoffset.GetInt(oset, buffer);
 
-    bool WaveDirection = "Left to Right" == SettingsMap["CHOICE_Wave_Direction"] ? true : false;
+    bool WaveDirection = params.WaveDirection;
 
     double WaveYOffset = (buffer.BufferHt / 2.0) * (yoffset * 0.01);
     int roundedWaveYOffset = std::round(WaveYOffset);
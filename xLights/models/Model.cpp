@@ -2088,6 +2088,7 @@ std::list<int> Model::ParseFaceNodes(std::string channels)
 }
 
 void Model::SetFromXml(wxXmlNode* ModelNode, bool zb) {
+    InvalidateRenderBufferCache();
     if (modelDimmingCurve != nullptr) {
         delete modelDimmingCurve;
         modelDimmingCurve = nullptr;
@@ -3142,6 +3143,54 @@ void Model::InitRenderBufferNodes(const std::string &type, const std::string &ca
     ApplyTransform(transform, newNodes, bufferWi, bufferHt);
 }
 
+void Model::InitRenderBufferNodesCached(const std::string &type, const std::string &camera,
+    const std::string &transform,
+    std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHt) const {
+
+    // the transforms work on the whole node list so only a clean list can be served from the cache and
+    // 3D camera layouts depend on the state of the house preview so they are always recalculated
+    if (!newNodes.empty() || camera != "2D") {
+        InitRenderBufferNodes(type, camera, transform, newNodes, bufferWi, bufferHt);
+        return;
+    }
+
+    std::string key = type + "|" + camera + "|" + transform;
+    unsigned long changes = GetRenderBufferChangeCount();
+    std::shared_ptr<const RenderBufferLayout> layout;
+    {
+        std::unique_lock<std::mutex> lock(renderBufferCacheLock);
+        auto it = renderBufferCache.find(key);
+        if (it != renderBufferCache.end() && it->second->changeCount == changes) {
+            layout = it->second;
+        }
+    }
+
+    if (layout == nullptr) {
+        auto l = std::make_shared<RenderBufferLayout>();
+        l->bufferWi = 0;
+        l->bufferHi = 0;
+        InitRenderBufferNodes(type, camera, transform, l->nodes, l->bufferWi, l->bufferHi);
+        // groups can reset themselves while building their nodes so take the count afterwards
+        l->changeCount = GetRenderBufferChangeCount();
+        layout = l;
+
+        std::unique_lock<std::mutex> lock(renderBufferCacheLock);
+        renderBufferCache[key] = layout;
+    }
+
+    newNodes.reserve(layout->nodes.size());
+    for (const auto& it : layout->nodes) {
+        newNodes.push_back(NodeBaseClassPtr(it->clone()));
+    }
+    bufferWi = layout->bufferWi;
+    bufferHt = layout->bufferHi;
+}
+
+void Model::InvalidateRenderBufferCache() {
+    std::unique_lock<std::mutex> lock(renderBufferCacheLock);
+    renderBufferCache.clear();
+}
+
 std::string Model::GetNextName() {
     if (nodeNames.size() > Nodes.size()) {
         return nodeNames[Nodes.size()];
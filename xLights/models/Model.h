@@ -5,6 +5,8 @@
 #include <map>
 #include <vector>
 #include <list>
+#include <memory>
+#include <mutex>
 
 #include "ModelScreenLocation.h"
 #include "../Color.h"
@@ -105,6 +107,12 @@ public:
     virtual void GetBufferSize(const std::string &type, const std::string &camera, const std::string &transform, int &BufferWi, int &BufferHi) const;
     virtual void InitRenderBufferNodes(const std::string &type, const std::string &camera, const std::string &transform,
                                        std::vector<NodeBaseClassPtr> &Nodes, int &BufferWi, int &BufferHi) const;
+    // InitRenderBufferNodes through a per model cache of the node layouts, the nodes added are copies the caller can change
+    void InitRenderBufferNodesCached(const std::string &type, const std::string &camera, const std::string &transform,
+                                     std::vector<NodeBaseClassPtr> &Nodes, int &BufferWi, int &BufferHi) const;
+    void InvalidateRenderBufferCache();
+    // changes whenever anything the render buffer node layouts depend on changes
+    virtual unsigned long GetRenderBufferChangeCount() const { return changeCount; }
     const ModelManager &GetModelManager() const {
         return modelManager;
     }
@@ -206,6 +214,17 @@ protected:
 
     std::vector<std::string> modelState;
 
+    struct RenderBufferLayout
+    {
+        std::vector<NodeBaseClassPtr> nodes;
+        int bufferWi;
+        int bufferHi;
+        unsigned long changeCount;
+    };
+    // shared between the render jobs, the layouts themselves are never changed once cached
+    mutable std::map<std::string, std::shared_ptr<const RenderBufferLayout>> renderBufferCache;
+    mutable std::mutex renderBufferCacheLock;
+
 public:
     bool IsControllerConnectionValid() const;
     wxXmlNode *GetControllerConnection() const;
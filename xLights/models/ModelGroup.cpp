@@ -222,6 +222,7 @@ int ModelGroup::GetGridSize() const
 }
 
 bool ModelGroup::Reset(bool zeroBased) {
+    InvalidateRenderBufferCache();
     this->zeroBased = zeroBased;
     selected = false;
     name = ModelXml->GetAttribute("name").ToStdString();
@@ -530,6 +531,14 @@ bool ModelGroup::SubModelRenamed(const std::string &oldName, const std::string &
     return changed;
 }
 
+unsigned long ModelGroup::GetRenderBufferChangeCount() const {
+    unsigned long l = changeCount;
+    for (auto it = models.begin(); it != models.end(); ++it) {
+        l += (*it)->GetRenderBufferChangeCount();
+    }
+    return l;
+}
+
 void ModelGroup::CheckForChanges() const {
 
     unsigned long l = 0;
@@ -136,3 +136,207 @@ void NodeClassRGBW::GetForChannels(unsigned char *buf) const {
             break;
     }
 }
+
+static NodeTable::ChannelLayout GetChannelLayout(const NodeBaseClass *node, const uint8_t *offsets) {
+    NodeTable::ChannelLayout l = {};
+    for (int x = 0; x < 3; x++) {
+        l.offsets[x] = offsets[x];
+    }
+    const std::type_info &type = typeid(*node);
+    bool hasAllOffsets = offsets[0] != 255 && offsets[1] != 255 && offsets[2] != 255;
+    if (type == typeid(NodeBaseClass) && hasAllOffsets) {
+        l.kind = NodeTable::LAYOUT_RGB;
+    } else if (type == typeid(NodeClassRed)) {
+        l.kind = NodeTable::LAYOUT_SINGLE;
+        l.component = 0;
+    } else if (type == typeid(NodeClassGreen)) {
+        l.kind = NodeTable::LAYOUT_SINGLE;
+        l.component = 1;
+    } else if (type == typeid(NodeClassBlue)) {
+        l.kind = NodeTable::LAYOUT_SINGLE;
+        l.component = 2;
+    } else if (type == typeid(NodeClassWhite)) {
+        l.kind = NodeTable::LAYOUT_WHITE;
+    } else {
+        l.kind = NodeTable::LAYOUT_NODE;
+    }
+    return l;
+}
+
+void NodeTable::Clear() {
+    colors.clear();
+    firstX.clear();
+    firstY.clear();
+    coordStart.clear();
+    bufX.clear();
+    bufY.clear();
+    actChan.clear();
+    chanCount.clear();
+    layout.clear();
+    layouts.clear();
+    modelIndex.clear();
+    models.clear();
+    sparkle.clear();
+    nodes.clear();
+}
+
+void NodeTable::Build(const std::vector<NodeBaseClassPtr> &nodeList) {
+    Clear();
+
+    size_t count = nodeList.size();
+    size_t coordCount = 0;
+    for (const auto &n : nodeList) {
+        coordCount += n->Coords.size();
+    }
+    colors.resize(count, xlBLACK);
+    firstX.reserve(count);
+    firstY.reserve(count);
+    coordStart.reserve(count + 1);
+    bufX.reserve(coordCount);
+    bufY.reserve(coordCount);
+    actChan.reserve(count);
+    chanCount.reserve(count);
+    layout.reserve(count);
+    modelIndex.reserve(count);
+    sparkle.reserve(count);
+    nodes.reserve(count);
+
+    for (const auto &n : nodeList) {
+        coordStart.push_back(bufX.size());
+        for (const auto &c : n->Coords) {
+            bufX.push_back(c.bufX);
+            bufY.push_back(c.bufY);
+        }
+        firstX.push_back(n->Coords.empty() ? -1 : n->Coords[0].bufX);
+        firstY.push_back(n->Coords.empty() ? -1 : n->Coords[0].bufY);
+        actChan.push_back(n->ActChan);
+        chanCount.push_back(n->GetChanCount());
+        sparkle.push_back(n->sparkle);
+
+        ChannelLayout l = GetChannelLayout(n.get(), n->offsets);
+        if (typeid(*n) == typeid(NodeClassRGBW)
+            && n->offsets[0] != 255 && n->offsets[1] != 255 && n->offsets[2] != 255) {
+            const NodeClassRGBW *rgbw = static_cast<const NodeClassRGBW*>(n.get());
+            l.kind = LAYOUT_RGBW;
+            l.wOffset = rgbw->wOffset;
+            l.wIndex = rgbw->wIndex;
+            l.rgbwHandling = rgbw->rgbwHandling;
+        }
+        auto lit = std::find(layouts.begin(), layouts.end(), l);
+        if (lit == layouts.end()) {
+            layouts.push_back(l);
+            lit = layouts.end() - 1;
+        }
+        layout.push_back(lit - layouts.begin());
+        nodes.push_back(l.kind == LAYOUT_NODE ? n.get() : nullptr);
+
+        auto mit = std::find(models.begin(), models.end(), n->model);
+        if (mit == models.end()) {
+            models.push_back(n->model);
+            mit = models.end() - 1;
+        }
+        modelIndex.push_back(mit - models.begin());
+    }
+    coordStart.push_back(bufX.size());
+}
+
+void NodeTable::GetColor(size_t n, xlColor &color) const {
+    const xlColor &c = colors[n];
+    const ChannelLayout &l = layouts[layout[n]];
+    switch (l.kind) {
+        case LAYOUT_SINGLE:
+            color.Set(l.component == 0 ? c.red : 0,
+                      l.component == 1 ? c.green : 0,
+                      l.component == 2 ? c.blue : 0);
+            break;
+        case LAYOUT_WHITE: {
+            uint8_t cmin = std::min(c.red, std::min(c.green, c.blue));
+            color.Set(cmin, cmin, cmin);
+            break;
+        }
+        case LAYOUT_NODE:
+            nodes[n]->GetColor(color);
+            break;
+        default:
+            color.Set(c.red, c.green, c.blue);
+            break;
+    }
+}
+
+void NodeTable::GetForChannels(size_t n, unsigned char *buf) const {
+    const xlColor &c = colors[n];
+    const ChannelLayout &l = layouts[layout[n]];
+    switch (l.kind) {
+        case LAYOUT_RGB:
+            buf[l.offsets[0]] = c.red;
+            buf[l.offsets[1]] = c.green;
+            buf[l.offsets[2]] = c.blue;
+            break;
+        case LAYOUT_SINGLE:
+            buf[0] = l.component == 0 ? c.red : (l.component == 1 ? c.green : c.blue);
+            break;
+        case LAYOUT_WHITE:
+            buf[0] = std::min(c.red, std::min(c.green, c.blue));
+            break;
+        case LAYOUT_RGBW: {
+            bool isWhite = c.red == c.green && c.green == c.blue;
+            switch (l.rgbwHandling) {
+                case RGB_HANDLING_RGB:
+                    buf[l.offsets[0] + l.wOffset] = c.red;
+                    buf[l.offsets[1] + l.wOffset] = c.green;
+                    buf[l.offsets[2] + l.wOffset] = c.blue;
+                    break;
+                case RGB_HANDLING_WHITE:
+                    if (isWhite) {
+                        buf[l.wIndex] = c.red;
+                    }
+                    break;
+                default: //RGB_HANDLING_NORMAL
+                    if (isWhite) {
+                        buf[0 + l.wOffset] = buf[1 + l.wOffset] = buf[2 + l.wOffset] = 0;
+                        buf[l.wIndex] = c.red;
+                    } else {
+                        buf[l.offsets[0] + l.wOffset] = c.red;
+                        buf[l.offsets[1] + l.wOffset] = c.green;
+                        buf[l.offsets[2] + l.wOffset] = c.blue;
+                        buf[l.wIndex] = 0;
+                    }
+                    break;
+            }
+            break;
+        }
+        default:
+            nodes[n]->GetForChannels(buf);
+            break;
+    }
+}
+
+void NodeTable::SetFromChannels(size_t n, const unsigned char *buf) {
+    xlColor &c = colors[n];
+    const ChannelLayout &l = layouts[layout[n]];
+    switch (l.kind) {
+        case LAYOUT_RGB:
+            c.Set(buf[l.offsets[0]], buf[l.offsets[1]], buf[l.offsets[2]]);
+            break;
+        case LAYOUT_SINGLE:
+            c.Set(l.component == 0 ? buf[0] : 0,
+                  l.component == 1 ? buf[0] : 0,
+                  l.component == 2 ? buf[0] : 0);
+            break;
+        case LAYOUT_WHITE:
+            c.Set(buf[0], buf[0], buf[0]);
+            break;
+        case LAYOUT_RGBW:
+            if (l.rgbwHandling == RGB_HANDLING_WHITE
+                || (l.rgbwHandling != RGB_HANDLING_RGB && buf[l.wIndex] != 0)) {
+                c.Set(buf[l.wIndex], buf[l.wIndex], buf[l.wIndex]);
+            } else {
+                c.Set(buf[l.offsets[0] + l.wOffset], buf[l.offsets[1] + l.wOffset], buf[l.offsets[2] + l.wOffset]);
+            }
+            break;
+        default:
+            nodes[n]->SetFromChannels(buf);
+            nodes[n]->GetColor(c);
+            break;
+    }
+}
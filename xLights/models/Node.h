@@ -11,6 +11,7 @@
 #include <cmath>
 #include <memory>
 #include <algorithm>
+#include <typeinfo>
 
 #include "../Color.h"
 
@@ -22,6 +23,7 @@ class Model;
 
 class NodeBaseClass
 {
+    friend class NodeTable;
 
 protected:
     // color values in rgb order
@@ -388,6 +390,7 @@ public:
 };
 class NodeClassRGBW : public NodeBaseClass
 {
+    friend class NodeTable;
 public:
     NodeClassRGBW(int StringNumber, size_t NodesPerString, const std::string &rgbOrder, bool whiteLast, int rgbwtype, const std::string &n = EMPTY_STR)
         : NodeBaseClass(StringNumber, NodesPerString, rgbOrder)
@@ -416,6 +419,73 @@ private:
 
 typedef std::unique_ptr<NodeBaseClass> NodeBaseClassPtr;
 
+// Flat structure of arrays copy of a node list for the render path.  The node
+// objects remain what the UI and the effects work with, but per frame output
+// (mixing, dimming curves and packing into channel data) only walks the plain
+// arrays here.  Nodes whose colour handling isn't a simple channel layout
+// (custom and intensity single colour nodes) are LAYOUT_NODE and still go
+// through the node object.
+class NodeTable
+{
+public:
+    enum LayoutKind : uint8_t {
+        LAYOUT_RGB,     // three channels at offsets[]
+        LAYOUT_SINGLE,  // one channel holding colour component 'component'
+        LAYOUT_WHITE,   // one channel holding min(r, g, b)
+        LAYOUT_RGBW,    // four channels, see NodeClassRGBW
+        LAYOUT_NODE     // handled by the node object
+    };
+    struct ChannelLayout {
+        uint8_t kind;
+        uint8_t offsets[3];
+        uint8_t component;
+        uint8_t wOffset;
+        uint8_t wIndex;
+        uint8_t rgbwHandling;
+
+        bool operator==(const ChannelLayout &l) const {
+            return kind == l.kind && offsets[0] == l.offsets[0] && offsets[1] == l.offsets[1] && offsets[2] == l.offsets[2]
+                && component == l.component && wOffset == l.wOffset && wIndex == l.wIndex && rgbwHandling == l.rgbwHandling;
+        }
+    };
+
+    void Build(const std::vector<NodeBaseClassPtr> &nodeList);
+    void Clear();
+
+    size_t size() const {
+        return actChan.size();
+    }
+    bool IsVisible(size_t n) const {
+        return coordStart[n] != coordStart[n + 1];
+    }
+
+    // equivalents of the NodeBaseClass methods of the same name
+    void SetColor(size_t n, const xlColor &color) {
+        colors[n] = color;
+        if (nodes[n] != nullptr) {
+            nodes[n]->SetColor(color);
+        }
+    }
+    void GetColor(size_t n, xlColor &color) const;
+    void GetForChannels(size_t n, unsigned char *buf) const;
+    void SetFromChannels(size_t n, const unsigned char *buf);
+
+    std::vector<xlColor> colors;          // colour last set on each node
+    std::vector<int> firstX;              // first buffer coordinate of each node, -1 if not displayed
+    std::vector<int> firstY;
+    std::vector<uint32_t> coordStart;     // coords of node n are [coordStart[n], coordStart[n + 1])
+    std::vector<int> bufX;
+    std::vector<int> bufY;
+    std::vector<uint32_t> actChan;
+    std::vector<uint8_t> chanCount;
+    std::vector<uint16_t> layout;         // index into layouts
+    std::vector<ChannelLayout> layouts;   // distinct channel layouts/colour orders
+    std::vector<uint16_t> modelIndex;     // index into models
+    std::vector<const Model*> models;
+    std::vector<unsigned short> sparkle;
+    std::vector<NodeBaseClass*> nodes;    // node object for LAYOUT_NODE entries, otherwise nullptr
+};
+
 
 #endif /* Node_h */
 
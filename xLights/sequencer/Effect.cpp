@@ -640,6 +640,15 @@ void Effect::AddFrame(RenderBuffer &buffer, RenderCache &renderCache) {
     }
 }
 
+void Effect::PrefetchCache(RenderCache &renderCache) {
+    std::unique_lock<std::recursive_mutex> lock(settingsLock);
+    if (mCache) {
+        renderCache.QueuePrefetch(mCache);
+    } else {
+        renderCache.Prefetch(this);
+    }
+}
+
 void Effect::PurgeCache(bool deleteCache) {
     std::unique_lock<std::recursive_mutex> lock(settingsLock);
     if (mCache) {
@@ -140,6 +140,7 @@ public:
     //gets the cached frame.   Returns true if the frame was filled into the buffer
     bool GetFrame(RenderBuffer &buffer, RenderCache &renderCache);
     void AddFrame(RenderBuffer &buffer, RenderCache &renderCache);
+    void PrefetchCache(RenderCache &renderCache);
     void PurgeCache(bool deleteCachefile = false);
 };
 
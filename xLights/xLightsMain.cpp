@@ -1633,6 +1633,16 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     MenuItemFSEQV1->Check(_fseqVersion == 1);
     MenuItemFSEQV2->Check(_fseqVersion == 2);
 
+    // sequences bigger than this are paged to a scratch file, 0 disables paging
+    int sequenceMemoryBudget = 2048;
+    config->Read("xLightsSequenceMemoryBudgetMB", &sequenceMemoryBudget, 2048);
+    SequenceData::SetMemoryBudget((size_t)std::max(sequenceMemoryBudget, 0) * 1024 * 1024);
+    logger_base.debug("Sequence Memory Budget: %dMB.", sequenceMemoryBudget);
+    bool sequenceCompress = false;
+    config->Read("xLightsSequenceCompress", &sequenceCompress, false);
+    SequenceData::SetCompressPages(sequenceCompress);
+    logger_base.debug("Sequence Compress Over Budget: %s.", sequenceCompress ? "true" : "false");
+
     config->Read("xLightsPlayVolume", &playVolume, 100);
     MenuItem_LoudVol->Check(playVolume == 100);
     MenuItem_MedVol->Check(playVolume == 66);
@@ -1842,6 +1852,12 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     logger_base.debug("Enable Render Cache: %s.", (const char*)_enableRenderCache.c_str());
     _renderCache.Enable(_enableRenderCache);
 
+    // render caches across the show folder are trimmed back to this, 0 means no limit
+    int renderCacheMaxSize = 10240;
+    config->Read("xLightsRenderCacheMaxSizeMB", &renderCacheMaxSize, 10240);
+    _renderCache.SetMaxSize((size_t)std::max(renderCacheMaxSize, 0) * 1024 * 1024);
+    logger_base.debug("Render Cache Max Size: %dMB.", renderCacheMaxSize);
+
     config->Read("xLightsAutoSavePerspectives", &_autoSavePerspecive, false);
     MenuItem_PerspectiveAutosave->Check(_autoSavePerspecive);
     logger_base.debug("Autosave perspectives: %s.", _autoSavePerspecive ? "true" : "false");
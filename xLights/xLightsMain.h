@@ -376,6 +376,7 @@ public:
     void DoLayoutWork();
 
     EffectManager &GetEffectManager() { return effectManager; }
+    RenderCache &GetRenderCache() { return _renderCache; }
 
     bool ImportSuperStar(Element *el, wxXmlDocument &doc, int x_size, int y_size,
                          int x_offset, int y_offset, bool average_colors,